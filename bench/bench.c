@@ -0,0 +1,419 @@
+#define _POSIX_C_SOURCE 200809L  // Expose clock_gettime, mkdtemp and chdir
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cart.h"
+#include "catalog.h"
+#include "constants.h"
+#include "data_management.h"
+#include "data_structures.h"
+#include "engine.h"
+
+#define BENCH_SAMPLES 31               // Timed samples per benchmark; odd so the median is one
+#define BENCH_WARMUP_SAMPLES 3         // Samples run and discarded first to warm the caches
+#define BENCH_MIN_SAMPLE_NS 2000000LL  // Shortest a sample may take; batches double until it does
+#define BENCH_MAX_BATCH 65536          // Most operations timed in one sample
+#define BENCH_MAX_CARTS 1024           // Most carts prepared for one sample of a cart benchmark
+#define BENCH_REGISTER_PIECES 1000000  // Pieces of each denomination at the start of a sample
+#define BENCH_ITEM_STOCK 1000000       // Stock of each benchmark item
+#define BENCH_CART_LINES 50            // Lines a cart holds
+
+/**
+ * @brief A machine set up for one benchmark, and the inputs its operations work through.
+ */
+typedef struct
+{
+    Catalog catalog;                         // The benchmark's inventory
+    VendingMachine machine;                  // The machine set up over the inventory
+    CashRegister cash[MAX_DENOMINATIONS];    // The machine's register
+    UserSelection *carts;                    // One cart per operation of a sample, if needed
+    Cents userMoney;                         // Money inserted for the benchmark's order
+    int parameter;                           // Cart lines or amount the benchmark measures
+} BenchState;
+
+/**
+ * @brief One benchmark: an operation timed at one catalog size and parameter.
+ */
+typedef struct
+{
+    const char *name;       // Name of the routine measured
+    const char *unit;       // What the parameter counts, or "-" if there is none
+    int parameter;          // Cart lines or amount in centavos, passed to the operations
+    int itemCount;          // Items in the benchmark's inventory
+    int maxBatch;           // Most operations one sample may run
+    void (*prepare)(BenchState *, int);  // Untimed setup before each sample, or NULL
+    void (*run)(BenchState *, int);      // Runs a batch of the timed operation
+} Benchmark;
+
+static volatile long long benchSink;  // Receives results so the compiler cannot drop the work
+
+static const Cents denominations[] = {
+#define BENCH_DENOMINATION(cents) cents,
+    DENOMINATIONS(BENCH_DENOMINATION)
+#undef BENCH_DENOMINATION
+};
+
+/**
+ * @brief Returns the current monotonic time in nanoseconds.
+ */
+static long long currentTimeNs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long) now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * @brief Fills the register so no sample can run out of any denomination.
+ * @param state The benchmark state whose register is filled.
+ */
+static void fillRegister(BenchState *state)
+{
+    for (int i = 0; i < state->machine.registerSize; i++)
+    {
+        state->cash[i].amountLeft = BENCH_REGISTER_PIECES;
+    }
+    noteRegisterChanged(&state->machine);
+}
+
+/**
+ * @brief Fills a cart with one unit of each of the first lineCount items.
+ * @param state The benchmark state whose inventory is used.
+ * @param cart The cart to fill.
+ * @param lineCount The number of lines to add.
+ */
+static void fillCart(BenchState *state, UserSelection *cart, int lineCount)
+{
+    clearCart(cart);
+    for (int i = 0; i < lineCount; i++)
+    {
+        updateSelectedItems(cart, &state->machine.items[i], i, 1);
+    }
+}
+
+static void runIsValidDenomination(BenchState *state, int batch)
+{
+    // Accepted and rejected amounts, so both outcomes are measured
+    static const Cents amounts[8] = {50000, 2000, 100, 25, 5, 1234, 7, 100000};
+    long long valid = 0;
+
+    for (int i = 0; i < batch; i++)
+    {
+        valid += isValidDenomination(&state->machine, amounts[i & 7]);
+    }
+    benchSink = valid;
+}
+
+static void prepareInsertMoney(BenchState *state, int batch)
+{
+    (void) batch;
+    fillRegister(state);
+    state->userMoney = 0;
+}
+
+static void runInsertMoney(BenchState *state, int batch)
+{
+    int count = (int) (sizeof(denominations) / sizeof(denominations[0]));
+
+    for (int i = 0; i < batch; i++)
+    {
+        insertMoney(&state->machine, denominations[i % count], &state->userMoney);
+    }
+    benchSink = state->userMoney;
+}
+
+static void prepareUpdateSelectedItems(BenchState *state, int batch)
+{
+    (void) batch;
+    fillCart(state, &state->carts[0], state->parameter);
+}
+
+static void runUpdateSelectedItems(BenchState *state, int batch)
+{
+    for (int i = 0; i < batch; i++)
+    {
+        int index = i % state->parameter;  // Adds to a cart already holding parameter lines
+
+        updateSelectedItems(&state->carts[0], &state->machine.items[index], index, 1);
+    }
+    benchSink = state->carts[0].totalItemCost;
+}
+
+static void prepareResetOrderAfterCancel(BenchState *state, int batch)
+{
+    for (int i = 0; i < batch; i++)
+    {
+        fillCart(state, &state->carts[i], state->parameter);  // Carts own their spill buffers
+    }
+}
+
+static void runResetOrderAfterCancel(BenchState *state, int batch)
+{
+    for (int i = 0; i < batch; i++)
+    {
+        state->userMoney = state->carts[i].totalItemCost;
+        resetOrderAfterCancel(&state->carts[i], &state->userMoney, &state->machine);
+    }
+    benchSink = state->machine.items[0].stock;
+}
+
+static void prepareRegister(BenchState *state, int batch)
+{
+    (void) batch;
+    fillRegister(state);
+}
+
+static void runPayOutChange(BenchState *state, int batch)
+{
+    int pieces = 0;
+
+    for (int i = 0; i < batch; i++)
+    {
+        pieces += payOutChange(&state->machine, state->parameter).pieces;
+    }
+    benchSink = pieces;
+}
+
+static void runCashOutAmount(BenchState *state, int batch)
+{
+    int pieces = 0;
+
+    for (int i = 0; i < batch; i++)
+    {
+        pieces += cashOutAmount(&state->machine, state->parameter).pieces;
+    }
+    benchSink = pieces;
+}
+
+static void runSaveItemsToCSV(BenchState *state, int batch)
+{
+    int saved = 0;
+
+    for (int i = 0; i < batch; i++)
+    {
+        saved += saveItemsToCSV(state->machine.items, state->machine.menuSize);
+    }
+    benchSink = saved;
+}
+
+/**
+ * @brief Sets up the inventory, register and carts a benchmark needs.
+ * @param state The state to set up.
+ * @param benchmark The benchmark to set it up for.
+ * @return 1 if the state is ready, 0 if memory ran out.
+ */
+static int setUpBench(BenchState *state, const Benchmark *benchmark)
+{
+    int registerSize = (int) (sizeof(denominations) / sizeof(denominations[0]));
+    int isReady = 1;
+
+    memset(state, 0, sizeof(*state));
+    initCatalog(&state->catalog);
+    for (int i = 0; i < benchmark->itemCount && isReady; i++)
+    {
+        char name[ITEM_NAME_SIZE];
+
+        snprintf(name, sizeof(name), "Benchmark Item %d", i + 1);
+        isReady = addCatalogItem(&state->catalog, i + 1, name, 1000 + (i % 40) * 25,
+                                 BENCH_ITEM_STOCK);
+    }
+    for (int i = 0; i < registerSize; i++)
+    {
+        state->cash[i].cashDenomination = denominations[i];
+        state->cash[i].amountLeft = BENCH_REGISTER_PIECES;
+    }
+    state->parameter = benchmark->parameter;
+    state->carts = calloc(BENCH_MAX_CARTS, sizeof(UserSelection));
+    isReady = isReady && state->carts != NULL &&
+              initVendingMachine(&state->machine, state->catalog.items, state->catalog.count,
+                                 state->cash, registerSize);
+    return isReady;
+}
+
+/**
+ * @brief Releases the memory of a benchmark state.
+ * @param state The state to release.
+ */
+static void tearDownBench(BenchState *state)
+{
+    freeVendingMachine(&state->machine);
+    freeCatalog(&state->catalog);
+    for (int i = 0; state->carts != NULL && i < BENCH_MAX_CARTS; i++)
+    {
+        clearCart(&state->carts[i]);
+    }
+    free(state->carts);
+}
+
+/**
+ * @brief Times one sample of a benchmark.
+ * @param benchmark The benchmark.
+ * @param state Its state.
+ * @param batch The number of operations in the sample.
+ * @return The time the operations took, in nanoseconds.
+ */
+static long long timeSample(const Benchmark *benchmark, BenchState *state, int batch)
+{
+    if (benchmark->prepare != NULL)
+    {
+        benchmark->prepare(state, batch);
+    }
+
+    long long start = currentTimeNs();
+    benchmark->run(state, batch);
+    return currentTimeNs() - start;
+}
+
+static int compareDoubles(const void *a, const void *b)
+{
+    double first = *(const double *) a;
+    double second = *(const double *) b;
+
+    return (first > second) - (first < second);
+}
+
+/**
+ * @brief Runs a benchmark and prints the distribution of its time per operation.
+ *
+ * The batch is doubled until one sample takes BENCH_MIN_SAMPLE_NS, so timer overhead is
+ * negligible, then BENCH_SAMPLES samples are timed after a few discarded warm-up samples.
+ * Percentiles are taken across samples, which keeps the median steady between runs.
+ *
+ * @param benchmark The benchmark to run.
+ * @param isCsv 1 to print a CSV row, 0 to print a table row.
+ * @return 1 if the benchmark ran, 0 if its state could not be set up.
+ */
+static int runBenchmark(const Benchmark *benchmark, int isCsv)
+{
+    BenchState state;
+    double nsPerOp[BENCH_SAMPLES];
+    int batch = 1;
+    int isReady = setUpBench(&state, benchmark);
+
+    if (isReady)
+    {
+        while (batch < benchmark->maxBatch &&
+               timeSample(benchmark, &state, batch) < BENCH_MIN_SAMPLE_NS)
+        {
+            batch *= 2;
+        }
+        for (int i = 0; i < BENCH_WARMUP_SAMPLES; i++)
+        {
+            timeSample(benchmark, &state, batch);
+        }
+        for (int i = 0; i < BENCH_SAMPLES; i++)
+        {
+            nsPerOp[i] = (double) timeSample(benchmark, &state, batch) / batch;
+        }
+        qsort(nsPerOp, BENCH_SAMPLES, sizeof(double), compareDoubles);
+
+        double p50 = nsPerOp[BENCH_SAMPLES / 2];
+        double p90 = nsPerOp[(BENCH_SAMPLES - 1) * 90 / 100];
+        double p99 = nsPerOp[(BENCH_SAMPLES - 1) * 99 / 100];
+        if (isCsv)
+        {
+            printf("%s,%d,%d,%d,%.1f,%.1f,%.1f,%.1f\n", benchmark->name, benchmark->itemCount,
+                   benchmark->parameter, batch, nsPerOp[0], p50, p90, p99);
+        }
+        else
+        {
+            char parameter[32];
+
+            snprintf(parameter, sizeof(parameter), "%d %s", benchmark->parameter,
+                     benchmark->unit);
+            printf("%-22s %8d %-12s %7d %11.1f %11.1f %11.1f %11.1f\n", benchmark->name,
+                   benchmark->itemCount, benchmark->parameter > 0 ? parameter : "-", batch,
+                   nsPerOp[0], p50, p90, p99);
+        }
+    }
+    tearDownBench(&state);
+    return isReady;
+}
+
+int main(int argc, char *argv[])
+{
+    const Benchmark benchmarks[] = {
+        {"isValidDenomination", "-", 0, 8, BENCH_MAX_BATCH, NULL, runIsValidDenomination},
+        {"insertMoney", "-", 0, 8, BENCH_MAX_BATCH, prepareInsertMoney, runInsertMoney},
+        {"updateSelectedItems", "lines", 1, 64, BENCH_MAX_BATCH, prepareUpdateSelectedItems,
+         runUpdateSelectedItems},
+        {"updateSelectedItems", "lines", 10, 64, BENCH_MAX_BATCH, prepareUpdateSelectedItems,
+         runUpdateSelectedItems},
+        {"updateSelectedItems", "lines", BENCH_CART_LINES, 64, BENCH_MAX_BATCH,
+         prepareUpdateSelectedItems, runUpdateSelectedItems},
+        {"resetOrderAfterCancel", "lines", 1, 64, BENCH_MAX_CARTS, prepareResetOrderAfterCancel,
+         runResetOrderAfterCancel},
+        {"resetOrderAfterCancel", "lines", 10, 64, BENCH_MAX_CARTS, prepareResetOrderAfterCancel,
+         runResetOrderAfterCancel},
+        {"resetOrderAfterCancel", "lines", BENCH_CART_LINES, 64, BENCH_MAX_CARTS,
+         prepareResetOrderAfterCancel, runResetOrderAfterCancel},
+        {"payOutChange", "cents", 775, 8, BENCH_MAX_BATCH, prepareRegister, runPayOutChange},
+        {"payOutChange", "cents", 13775, 8, BENCH_MAX_BATCH, prepareRegister, runPayOutChange},
+        {"payOutChange", "cents", 198775, 8, BENCH_MAX_BATCH, prepareRegister, runPayOutChange},
+        {"cashOutAmount", "cents", 775, 8, BENCH_MAX_BATCH, prepareRegister, runCashOutAmount},
+        {"cashOutAmount", "cents", 13775, 8, BENCH_MAX_BATCH, prepareRegister, runCashOutAmount},
+        {"cashOutAmount", "cents", 198775, 8, BENCH_MAX_BATCH, prepareRegister,
+         runCashOutAmount},
+        {"saveItemsToCSV", "-", 0, 8, BENCH_MAX_BATCH, NULL, runSaveItemsToCSV},
+        {"saveItemsToCSV", "-", 0, 1024, BENCH_MAX_BATCH, NULL, runSaveItemsToCSV},
+        {"saveItemsToCSV", "-", 0, 65536, BENCH_MAX_BATCH, NULL, runSaveItemsToCSV}};
+    int benchmarkCount = (int) (sizeof(benchmarks) / sizeof(benchmarks[0]));
+    const char *filter = NULL;  // Only benchmarks whose name contains this are run
+    int isCsv = 0;
+    int exitCode = 0;
+    char originalDir[FILE_PATH_SIZE];
+    char workDir[] = "/tmp/vending-bench-XXXXXX";
+
+    // Usage: bench [--csv] [name filter]
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--csv") == 0)
+        {
+            isCsv = 1;
+        }
+        else
+        {
+            filter = argv[i];
+        }
+    }
+
+    // saveItemsToCSV writes to the current directory, so work in a scratch one
+    if (getcwd(originalDir, sizeof(originalDir)) == NULL || mkdtemp(workDir) == NULL ||
+        chdir(workDir) != 0)
+    {
+        fprintf(stderr, "Unable to create a scratch directory for the benchmarks.\n");
+        return 1;
+    }
+
+    if (isCsv)
+    {
+        printf("benchmark,items,parameter,batch,min_ns,p50_ns,p90_ns,p99_ns\n");
+    }
+    else
+    {
+        printf("%-22s %8s %-12s %7s %11s %11s %11s %11s\n", "Benchmark", "Items", "Parameter",
+               "Batch", "min ns/op", "p50 ns/op", "p90 ns/op", "p99 ns/op");
+        printf(SEPARATOR "------------------------------------\n");
+    }
+    for (int i = 0; i < benchmarkCount; i++)
+    {
+        if ((filter == NULL || strstr(benchmarks[i].name, filter) != NULL) &&
+            !runBenchmark(&benchmarks[i], isCsv))
+        {
+            fprintf(stderr, "Not enough memory to run %s.\n", benchmarks[i].name);
+            exitCode = 1;
+        }
+    }
+
+    unlink(CSV_FILE);
+    if (chdir(originalDir) != 0 || rmdir(workDir) != 0)
+    {
+        fprintf(stderr, "Unable to remove %s.\n", workDir);
+    }
+    return exitCode;
+}
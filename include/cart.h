@@ -0,0 +1,14 @@
+#ifndef CART_H
+#define CART_H
+
+#include "data_structures.h"
+
+// Function Prototypes
+const CartLine *cartLines(const UserSelection *);
+int findCartLine(const UserSelection *, int);
+int addCartUnits(UserSelection *, int, int, Cents);
+Cents cartUnitPrice(const UserSelection *, int, Cents);
+Cents cartLineSubtotal(const UserSelection *, int);
+void clearCart(UserSelection *);
+
+#endif  // CART_H
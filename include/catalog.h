@@ -0,0 +1,24 @@
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include "data_structures.h"
+
+/**
+ * @brief A growable list of the items a machine sells, kept in one contiguous block.
+ */
+typedef struct
+{
+    VendingItem *items;  // Block holding every item back to back
+    int count;           // Number of items in the catalog
+    int capacity;        // Number of items the block can hold before it must grow
+} Catalog;
+
+// Function Prototypes
+void initCatalog(Catalog *);
+int addCatalogItem(Catalog *, int, const char *, Cents, int);
+VendingItem *newCatalogItem(Catalog *);
+int reserveCatalog(Catalog *, int);
+int appendCatalog(Catalog *, const Catalog *);
+void freeCatalog(Catalog *);
+
+#endif  // CATALOG_H
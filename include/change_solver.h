@@ -0,0 +1,18 @@
+#ifndef CHANGE_SOLVER_H
+#define CHANGE_SOLVER_H
+
+#include "data_structures.h"
+#include "engine.h"
+
+// Function Prototypes
+ChangeSolver *createChangeSolver(const CashRegister[], int);
+void destroyChangeSolver(ChangeSolver *);
+ChangeResult solveChange(ChangeSolver *, const CashRegister[], int, Cents);
+
+// Reachability Functions
+void markCashAdded(ChangeSolver *, const CashRegister[], int);
+void markRegisterChanged(ChangeSolver *);
+int isAmountReachable(ChangeSolver *, const CashRegister[], int, Cents);
+int isEveryAmountReachable(ChangeSolver *, const CashRegister[], Cents);
+
+#endif  // CHANGE_SOLVER_H
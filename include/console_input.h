@@ -0,0 +1,15 @@
+#ifndef CONSOLE_INPUT_H
+#define CONSOLE_INPUT_H
+
+#include "data_structures.h"
+
+#define INPUT_BUFFER_SIZE 65536  // Bytes of standard input read ahead at a time
+
+// Function Prototypes
+int readInt(int *);
+int readCents(Cents *);
+int readItemOrder(int *, int *);
+void discardLine(void);
+int isInputClosed(void);
+
+#endif  // CONSOLE_INPUT_H
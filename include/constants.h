@@ -6,8 +6,28 @@
 #define INVALID_DENOM_MSG "Invalid denomination! Please try again."
 #define SEPARATOR "--------------------------------------------------------------"
 
-// Valid Denominations
-static const float VALID_DENOMINATIONS[] = {20, 50, 100, 200, 500, 1, 5, 10, 0.25, 0.10, 0.05};
-static const int NUM_VALID_DENOMINATIONS = 11;
+// Denominations accepted by the machine, in centavos, largest first (bills: 500-20 PHP, coins:
+// 10-1 PHP and 0.25-0.05 PHP). The cash register is laid out from this one list, so the
+// denominations the machine accepts and the ones it holds can never drift apart.
+#define DENOMINATIONS(X) \
+    X(50000) X(20000) X(10000) X(5000) X(2000) X(1000) X(500) X(100) X(25) X(10) X(5)
+#define COUNT_DENOMINATION(cents) +1
+#define NUM_VALID_DENOMINATIONS (0 DENOMINATIONS(COUNT_DENOMINATION))
+
+// Denomination index: maps a denomination to its register slot in O(1)
+#define DENOMINATION_INDEX_SIZE 23  // Prime size giving every denomination above its own bucket
+#define DENOMINATION_HASH(cents) ((int) ((cents) % DENOMINATION_INDEX_SIZE))
+
+// Item names, including the terminating null; sized so a VendingItem fills a 64-byte cache line
+#define ITEM_NAME_SIZE 44
+
+// Carts: lines of small orders are kept inline, larger orders spill to a pooled buffer
+#define CART_INLINE_LINES 6         // Lines a cart holds before it needs a spill buffer
+#define CART_SPILL_MIN_LINES 16     // Lines in the smallest spill buffer (a power of two)
+#define CART_SPILL_SIZE_CLASSES 24  // Spill buffer sizes, each double the last
+#define CART_POOL_DEPTH 32          // Free spill buffers of each size kept for reuse
+#define MAX_DENOMINATIONS 16      // Upper bound on the number of denominations in a cash register
+#define EXACT_CHANGE_LIMIT 50000  // Change the register must cover to accept any bill (500 PHP)
+#define CHANGE_CLAIM_ATTEMPTS 8   // Change plans tried while other threads take planned pieces
 
 #endif  // CONSTANTS_H
@@ -0,0 +1,11 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Function Prototypes
+uint32_t computeCrc32(const void *data, size_t length);
+uint32_t updateCrc32(uint32_t crc, const void *data, size_t length);
+
+#endif  // CRC32_H
@@ -1,8 +1,17 @@
 #ifndef DATA_MANAGEMENT_H
 #define DATA_MANAGEMENT_H
+#include <stddef.h>
+
+#include "catalog.h"
 #include "data_structures.h"
 
+#define CSV_FILE "vending_items.csv"  // File the inventory is saved to
+#define FILE_PATH_SIZE 4096           // Longest file path handled, including the terminator
+
 // Function prototypes
-void saveItemsToCSV(VendingItem[], int);
+int saveItemsToCSV(VendingItem[], int);
+int loadItemsFromCSV(Catalog *, const char *);
+int writeFully(int, const void *, size_t);
+int syncParentDirectory(const char *);
 
 #endif  // DATA_MANAGEMENT_H
@@ -2,36 +2,116 @@
 #ifndef DATA_STRUCTURES_H
 #define DATA_STRUCTURES_H
 
+#include "constants.h"
+
+/**
+ * @brief An amount of money in centavos (100 centavos = 1 PHP). Keeping money as a whole number
+ * of centavos makes every price, total and change calculation exact.
+ */
+typedef long long Cents;
+
 /**
  * @brief Structure for storing vending item details.
  */
 typedef struct
 {
-    int itemNumber;  // Item number for selection
-    char name[20];   // Name of the item
-    float price;     // Price of the item in PHP
-    int stock;       // Available stock of the item
+    int itemNumber;             // Item number for selection
+    char name[ITEM_NAME_SIZE];  // Name of the item
+    Cents price;                // Price of the item in centavos
+    int stock;                  // Available stock of the item
 } VendingItem;
 
+/**
+ * @brief Running sales totals of one vending item, updated as each order ends.
+ */
+typedef struct
+{
+    long long unitsSold;       // Units sold in confirmed orders
+    Cents revenue;             // Money taken for those units at the prices charged, in centavos
+    long long unitsCancelled;  // Units returned to stock by canceled orders
+    long long lastSoldTime;    // Seconds since the epoch of the last confirmed sale, 0 if never
+} ItemSales;
+
 /**
  * @brief Structure for storing cash on hand in the vending machine.
  */
 typedef struct
 {
-    float cashDenomination;  // Cash denomination the machine accepts
+    Cents cashDenomination;  // Cash denomination the machine accepts, in centavos
     int amountLeft;          // Available number of that denomination
 } CashRegister;
 
+/**
+ * @brief One line of a cart: an item, how many units of it are ordered and the price they are
+ * charged at. The price is fixed when the item is first added, so a price change while the order
+ * is open does not change what the customer pays; names are looked up from the inventory.
+ */
+typedef struct
+{
+    Cents unitPrice;  // Price of each unit on the line, fixed when the line was started
+    int itemIndex;    // Inventory index of the item on the line
+    int quantity;     // Units of the item on the line
+} CartLine;
+
+/**
+ * @brief Pooled buffer holding the lines of a cart too large for its inline lines.
+ */
+typedef struct CartSpill CartSpill;
+
 /**
  * @brief Structure for tracking user's selected items in the vending machine.
+ *
+ * A small order keeps its lines inline, so an empty or typical cart is a few dozen bytes and never
+ * allocates. Once it outgrows them, every line moves to a spill buffer taken from a shared pool,
+ * which grows as needed, so a cart can hold any number of lines. A zeroed cart is empty; read
+ * lines with cartLines and empty the cart with clearCart, which returns the spill to the pool.
  */
 typedef struct
 {
-    char selectedItems[50][20];  // Array to store names of selected items
-    int quantities[50];          // Array to store quantities for each selected item
-    float subTotals[50];         // Array to store subtotal costs for each selected item
-    int count;                   // Number of items selected
-    float totalItemCost;         // Total cost of all selected items
+    CartLine lines[CART_INLINE_LINES];  // Lines of the order while it fits inline
+    CartSpill *spill;                   // Lines of the order once it outgrows lines, else NULL
+    int count;                          // Number of items selected
+    Cents totalItemCost;                // Total cost of all selected items
 } UserSelection;
 
+/**
+ * @brief Precomputed denomination tables and scratch space for breaking amounts into change.
+ * Its layout is private to change_solver.c.
+ */
+typedef struct ChangeSolver ChangeSolver;
+
+/**
+ * @brief An open write-ahead journal of the changes made to a machine. Its layout is private to
+ * journal.c.
+ */
+typedef struct Journal Journal;
+
+/**
+ * @brief A fixed-size ring of the most recent transactions of a machine. Its layout is private to
+ * transaction_log.c.
+ */
+typedef struct TransactionLog TransactionLog;
+
+/**
+ * @brief Structure bundling the state of one vending machine: its inventory and cash register.
+ */
+typedef struct
+{
+    VendingItem *items;          // Array of items sold by the machine
+    int menuSize;                // Number of items in the items array
+    ItemSales *sales;            // Sales totals of each item, parallel to items; NULL if not kept
+    CashRegister *cash;          // Array of denominations held by the cash register
+    int registerSize;            // Number of denominations in the cash array
+    ChangeSolver *changeSolver;  // Change-making tables built for the register's denominations
+    signed char denominationSlots[DENOMINATION_INDEX_SIZE];  // Register slot of each
+                                                             // denomination, -1 if none
+    int *nameSlots;     // Inventory index of each item name, -1 if empty, keyed by name hash
+    int *numberSlots;   // Inventory index of each item number, -1 if empty, keyed by number hash
+    int itemSlotCount;  // Number of slots in nameSlots and numberSlots (a power of two)
+    Journal *journal;   // Journal every change is appended to, NULL if changes are not journaled
+    int journalOrder;   // Order id the changes are journaled under: 0 for the console's order,
+                        // the session's while the socket server advances one
+    TransactionLog *transactions;  // Recent transactions, NULL if they are not kept
+} VendingMachine;
+
 #endif  // DATA_STRUCTURES_H
@@ -0,0 +1,96 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include "constants.h"
+#include "data_structures.h"
+#include "transaction_log.h"
+
+/**
+ * @brief Outcome of an engine operation.
+ */
+typedef enum
+{
+    ENGINE_OK = 0,                // The operation succeeded
+    ENGINE_INVALID_ITEM,          // The item does not exist in the inventory
+    ENGINE_OUT_OF_STOCK,          // The item has no stock left
+    ENGINE_INSUFFICIENT_FUNDS,    // The money inserted does not cover the order
+    ENGINE_INVALID_DENOMINATION,  // The denomination is not accepted by the machine
+    ENGINE_INVALID_AMOUNT,        // A price, quantity or amount is not positive
+    ENGINE_INSUFFICIENT_CASH,     // The register does not hold enough of a denomination
+    ENGINE_INEXACT_CHANGE,        // The register cannot make the exact amount
+    ENGINE_CART_FULL,             // The cart could not grow to hold another line
+    ENGINE_EMPTY_ORDER,           // The order has no items to check out
+    ENGINE_INVALID_STATE          // The purchase session cannot take the event in its state
+} EngineStatus;
+
+/**
+ * @brief Result of adding an item to the user's cart.
+ */
+typedef struct
+{
+    EngineStatus status;  // ENGINE_OK if the item was added
+    Cents itemPrice;      // Price of the item that was requested
+    Cents totalCost;      // Cart total after the request (unchanged if the item was not added)
+    Cents shortfall;      // Money still needed when status is ENGINE_INSUFFICIENT_FUNDS
+    int available;        // Units in stock when the request was checked
+} CartResult;
+
+/**
+ * @brief A breakdown of an amount into the denominations of the cash register.
+ */
+typedef struct
+{
+    EngineStatus status;            // ENGINE_OK if the amount can be made exactly
+    int counts[MAX_DENOMINATIONS];  // Number of each register denomination in the breakdown
+    int pieces;                     // Total number of bills and coins in the breakdown
+    Cents remaining;                // Part of the amount the register could not cover
+} ChangeResult;
+
+// Function Prototypes
+
+// Setup Functions
+int initVendingMachine(VendingMachine *, VendingItem[], int, CashRegister[], int);
+void freeVendingMachine(VendingMachine *);
+
+// Lookup Functions
+int findItemByNumber(const VendingMachine *, int);
+int findItemByName(const VendingMachine *, const char *);
+int findDenominationSlot(const VendingMachine *, Cents);
+Cents registerTotal(const VendingMachine *);
+
+// Purchase Functions
+int isValidDenomination(const VendingMachine *, Cents);
+EngineStatus insertMoney(VendingMachine *, Cents, Cents *);
+CartResult addItemToCart(VendingMachine *, int, UserSelection *, Cents);
+CartResult addQuantityToCart(VendingMachine *, int, UserSelection *, Cents, int);
+int updateSelectedItems(UserSelection *, const VendingItem *, int, int);
+ChangeResult computeChange(const VendingMachine *, Cents);
+EngineStatus applyChange(VendingMachine *, const ChangeResult *);
+ChangeResult payOutChange(VendingMachine *, Cents);
+int canMakeChange(const VendingMachine *, Cents);
+int isExactChangeOnly(const VendingMachine *);
+void noteRegisterChanged(VendingMachine *);
+void resetOrderAfterCancel(UserSelection *, Cents *, VendingMachine *);
+void resetOrderAfterConfirm(UserSelection *, Cents *, VendingMachine *);
+void resetOrderAfterConfirmAt(UserSelection *, Cents *, VendingMachine *, long long);
+
+// Register Reservation Functions
+EngineStatus reserveChange(VendingMachine *, const ChangeResult *);
+void commitChange(VendingMachine *, const ChangeResult *);
+void abortChange(VendingMachine *, const ChangeResult *);
+
+// Maintenance Functions
+EngineStatus setItemPrice(VendingMachine *, int, Cents);
+EngineStatus restockItem(VendingMachine *, int, int);
+EngineStatus restockRegister(VendingMachine *, Cents, int);
+ChangeResult cashOutAmount(VendingMachine *, Cents);
+EngineStatus cashOutDenomination(VendingMachine *, Cents, int);
+
+// Transaction Log Functions
+void logTransaction(VendingMachine *, const UserSelection *, Cents, const ChangeResult *,
+                    TransactionOutcome);
+
+// Sales Report Functions
+int findTopSellers(const VendingMachine *, int[], int);
+
+#endif  // ENGINE_H
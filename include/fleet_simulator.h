@@ -0,0 +1,11 @@
+#ifndef FLEET_SIMULATOR_H
+#define FLEET_SIMULATOR_H
+
+#include "data_structures.h"
+
+// Function Prototypes
+int runFleetSimulation(const VendingMachine *machine, int machineCount, int sessionsPerMachine,
+                       int threadCount);
+int runKioskSimulation(VendingMachine *machine, int kioskCount, int sessionsPerKiosk);
+
+#endif  // FLEET_SIMULATOR_H
@@ -0,0 +1,50 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+
+#include "data_structures.h"
+
+#define JOURNAL_FILE "vending_journal.bin"  // File every change to the machine is journaled to
+#define JOURNAL_GROUP_COMMIT_MS 5           // Longest a record waits to be written and synced
+#define JOURNAL_COMPACT_RECORDS 65536       // Records appended before a snapshot is taken
+#define JOURNAL_MAX_ORDER 65535             // Highest order id a record can carry
+
+/**
+ * @brief Kind of change recorded by a journal record, and the meaning of its operands.
+ */
+typedef enum
+{
+    JOURNAL_MONEY_INSERTED = 1,  // Denomination accepted into the register for the order
+    JOURNAL_ITEM_RESERVED,       // Item number, units added to the order (0 means 1)
+    JOURNAL_ORDER_CONFIRMED,     // The order was paid for and ended; seconds since the epoch
+    JOURNAL_ORDER_CANCELLED,     // The order was canceled and its stock returned
+    JOURNAL_ITEM_RESTOCKED,      // Item number, units added
+    JOURNAL_PRICE_CHANGED,       // Item number, new price
+    JOURNAL_CASH_RESTOCKED,      // Denomination, pieces added to the register
+    JOURNAL_CASH_REMOVED         // Denomination, pieces taken out as change or cash out
+} JournalType;
+
+/**
+ * @brief One record of the journal file, written exactly as laid out here.
+ */
+typedef struct
+{
+    uint32_t checksum;    // CRC-32 of the rest of the record
+    uint16_t type;        // A JournalType
+    uint16_t order;       // Order an order change belongs to: 0 for the console's, or the id of
+                          // a socket session, so interleaved orders replay apart
+    uint64_t sequence;    // Position of the change in the history of the machine, from 1
+    int64_t operands[2];  // Details of the change, as listed for its type
+} JournalRecord;
+
+// Function Prototypes
+int replayJournal(const char *, VendingMachine *, UserSelection *, Cents *, uint64_t, uint64_t *);
+Journal *openJournal(const char *, const char *, uint64_t);
+void appendJournal(Journal *, JournalType, int, int64_t, int64_t);
+int isJournalCompactionDue(Journal *);
+void compactJournal(Journal *, const VendingMachine *, const UserSelection *, Cents);
+void flushJournal(Journal *);
+int closeJournal(Journal *);
+
+#endif  // JOURNAL_H
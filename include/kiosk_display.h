@@ -0,0 +1,25 @@
+#ifndef KIOSK_DISPLAY_H
+#define KIOSK_DISPLAY_H
+
+#define DISPLAY_ROW_SIZE 128       // Longest row of a table, including the terminating null
+#define DISPLAY_CART_ROWS 16       // Rows of the panel kept for the cart and order summary
+#define DISPLAY_MIN_PROMPT_ROWS 8  // Rows the prompts below the panel need at least
+
+/**
+ * @brief The regions of the screen a table is drawn into.
+ */
+typedef enum
+{
+    DISPLAY_MENU,  // Item table: numbers, names, prices and stock
+    DISPLAY_CART   // The cart or the order summary
+} DisplaySection;
+
+// Function Prototypes
+int openDisplay(int, int);
+void closeDisplay(void);
+int isDeltaDisplay(void);
+void beginFrame(DisplaySection);
+void addRow(const char *, ...) __attribute__((format(printf, 1, 2)));
+void endFrame(void);
+
+#endif  // KIOSK_DISPLAY_H
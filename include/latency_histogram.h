@@ -0,0 +1,32 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#define HISTOGRAM_SUB_BUCKETS 16                        // Buckets per power of two of latency
+#define HISTOGRAM_BUCKETS (60 * HISTOGRAM_SUB_BUCKETS)  // Enough buckets for any 63-bit latency
+
+/**
+ * @brief A distribution of latencies in log-spaced buckets.
+ *
+ * Each power of two is split into HISTOGRAM_SUB_BUCKETS buckets, so every latency is kept to
+ * within about 6% while recording stays a few instructions and the size stays fixed however many
+ * latencies are recorded.
+ */
+typedef struct
+{
+    long long counts[HISTOGRAM_BUCKETS];  // Latencies recorded in each bucket
+    long long count;                      // Latencies recorded in total
+    long long total;                      // Sum of every latency recorded, in nanoseconds
+    long long min;                        // Smallest latency recorded
+    long long max;                        // Largest latency recorded
+} LatencyHistogram;
+
+// Function Prototypes
+void initHistogram(LatencyHistogram *);
+void recordLatency(LatencyHistogram *, long long);
+void mergeHistogram(LatencyHistogram *, const LatencyHistogram *);
+long long histogramPercentile(const LatencyHistogram *, double);
+double histogramMean(const LatencyHistogram *);
+int histogramBucket(long long);
+long long histogramBucketLimit(int);
+
+#endif  // LATENCY_HISTOGRAM_H
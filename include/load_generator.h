@@ -0,0 +1,10 @@
+#ifndef LOAD_GENERATOR_H
+#define LOAD_GENERATOR_H
+
+#include "data_structures.h"
+
+// Function Prototypes
+int runLoadGenerator(const VendingMachine *machine, long customerCount, double arrivalRate,
+                     unsigned long long seed);
+
+#endif  // LOAD_GENERATOR_H
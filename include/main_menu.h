@@ -1,5 +1,11 @@
+#ifndef MAIN_MENU_H
+#define MAIN_MENU_H
+
 #include "data_structures.h"
+#include "purchase_session.h"
 
 int handleMenuSelection(int);
-void processPurchase(VendingItem[], int, float *, CashRegister[], int, UserSelection *, int *);
-void handleMaintenanceOptions(VendingItem[], int, CashRegister[], int);
+void processPurchase(VendingMachine *, PurchaseSession *);
+void handleMaintenanceOptions(VendingMachine *);
+
+#endif  // MAIN_MENU_H
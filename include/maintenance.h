@@ -1,14 +1,23 @@
+#ifndef MAINTENANCE_H
+#define MAINTENANCE_H
+
 #include "data_structures.h"
 
 // Maintenance Function Prototypes
 int maintenanceValidation(int *);
-void viewInventory(VendingItem[], int);
-void modifyPrice(VendingItem[], int);
-void restockInventory(VendingItem[], int);
+void viewInventory(VendingMachine *);
+void viewSalesReport(VendingMachine *);
+void modifyPrice(VendingMachine *);
+void restockInventory(VendingMachine *);
+
+void handleAmountBasedCashOut(VendingMachine *);
+void handleQuantityBasedCashOut(VendingMachine *);
+void cashOut(VendingMachine *);
+
+void reStockRegister(VendingMachine *);
+void viewCashRegister(VendingMachine *);
 
-void handleAmountBasedCashOut(CashRegister[], int);
-void handleQuantityBasedCashOut(CashRegister[], int);
-void cashOut(CashRegister[], int);
+void viewTransactionHistory(VendingMachine *);
+void viewPerformanceStatistics(void);
 
-void reStockRegister(CashRegister[], int);
-void viewCashRegister(CashRegister[], int);
+#endif  // MAINTENANCE_H
@@ -0,0 +1,15 @@
+#ifndef MONEY_H
+#define MONEY_H
+
+#include <stddef.h>
+
+#include "data_structures.h"
+
+#define MONEY_TEXT_SIZE 32  // Buffer size large enough for any formatted Cents amount
+
+// Function Prototypes
+const char *formatCents(Cents amount, char text[MONEY_TEXT_SIZE]);
+int parseCents(const char *text, Cents *amount);
+int parseCentsSpan(const char *text, size_t length, Cents *amount);
+
+#endif  // MONEY_H
@@ -0,0 +1,38 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include "latency_histogram.h"
+
+/**
+ * @brief Stages of the purchase pipeline whose latency is counted.
+ */
+typedef enum
+{
+    PERF_USER_MONEY_INPUT,       // Accepting one bill or coin
+    PERF_PROCESS_SELECTION,      // Handling one item choice
+    PERF_UPDATE_SELECTED_ITEMS,  // Adding one unit to a cart line
+    PERF_GET_CHANGE,             // Settling a confirmed or canceled order
+    PERF_DISPENSE_CHANGE,        // Paying out change
+    PERF_SAVE_ITEMS_TO_CSV,      // Saving the inventory file
+    PERF_STAGE_COUNT
+} PerfStage;
+
+// Time a stage: PERF_START(start) begins a span and PERF_STOP(stage, start) records it. Without
+// VENDING_PERF both expand to nothing, so the instrumented code is exactly the uninstrumented code
+#ifdef VENDING_PERF
+#define PERF_START(start) long long start = perfClockNs()
+#define PERF_STOP(stage, start) recordPerfStage((stage), perfClockNs() - (start))
+#else
+#define PERF_START(start) ((void) 0)
+#define PERF_STOP(stage, start) ((void) 0)
+#endif
+
+// Function Prototypes
+int isPerfEnabled(void);
+const char *perfStageName(PerfStage);
+long long perfClockNs(void);
+void recordPerfStage(PerfStage, long long);
+void readPerfStage(PerfStage, LatencyHistogram *);
+void resetPerfCounters(void);
+
+#endif  // PERF_COUNTERS_H
@@ -0,0 +1,103 @@
+#ifndef PURCHASE_SESSION_H
+#define PURCHASE_SESSION_H
+
+#include "data_structures.h"
+#include "engine.h"
+
+#define SESSION_TIMEOUT_MS 60000  // Inactivity after which an open order is abandoned
+
+/**
+ * @brief Where a purchase session is in the flow of an order.
+ */
+typedef enum
+{
+    SESSION_IDLE = 0,               // No order has been started
+    SESSION_ACCEPTING_MONEY,        // Money was just inserted for the order
+    SESSION_SELECTING,              // Items were just added to the order
+    SESSION_AWAITING_CONFIRMATION,  // The order was checked out and waits to be confirmed
+    SESSION_DISPENSING,             // The order is paid for and its change is being dispensed
+    SESSION_CANCELLED               // The order was canceled or abandoned and refunded
+} SessionState;
+
+/**
+ * @brief Kind of event that advances a purchase session, and the fields of SessionEvent it uses.
+ */
+typedef enum
+{
+    SESSION_EVENT_INSERT_MONEY = 1,  // A bill or coin was inserted: amount
+    SESSION_EVENT_SELECT_ITEM,       // Units of an item were requested: itemIndex, quantity
+    SESSION_EVENT_CHECKOUT,          // The customer finished selecting
+    SESSION_EVENT_CONFIRM,           // The customer confirmed the order
+    SESSION_EVENT_DISPENSED,         // The change for a confirmed order left the machine
+    SESSION_EVENT_CANCEL,            // The customer canceled the order
+    SESSION_EVENT_TIMEOUT            // The session was inactive for too long
+} SessionEventType;
+
+/**
+ * @brief An event for a purchase session.
+ */
+typedef struct
+{
+    SessionEventType type;  // Kind of event
+    Cents amount;           // Denomination inserted, for SESSION_EVENT_INSERT_MONEY
+    int itemIndex;          // Inventory index of the item, for SESSION_EVENT_SELECT_ITEM
+    int quantity;           // Units of the item, for SESSION_EVENT_SELECT_ITEM
+} SessionEvent;
+
+typedef struct PurchaseSession PurchaseSession;
+
+/**
+ * @brief One customer's order, kept as an explicit state so a front end can hold any number of
+ * sessions suspended between events instead of blocking a thread on each customer's next input.
+ * Set one up with startPurchaseSession and release it with endPurchaseSession.
+ */
+struct PurchaseSession
+{
+    SessionState state;         // Where the session is in the flow of an order
+    UserSelection selection;    // The order's cart
+    Cents userMoney;            // Money inserted for the order
+    ChangeResult change;        // Change reserved for the order while it is dispensing
+    long long deadline;         // Time the open order is abandoned at, in ms; 0 if none is open
+    PurchaseSession *older;     // Session with the next earlier deadline, NULL if none
+    PurchaseSession *newer;     // Session with the next later deadline, NULL if none
+    void *owner;                // Front end object the session belongs to, for its own use
+    int journalOrder;           // Id the session's changes are journaled under, 0 for the console
+};
+
+/**
+ * @brief The sessions with an open order, from the earliest deadline to the latest.
+ *
+ * Every event gives its session the same timeout, so deadlines are handed out in order and a
+ * session only ever moves to the newest end: each event and each expiry costs O(1), however many
+ * sessions are suspended.
+ */
+typedef struct
+{
+    PurchaseSession *oldest;  // Session with the earliest deadline, NULL if none is open
+    PurchaseSession *newest;  // Session with the latest deadline, NULL if none is open
+    long long timeoutMs;      // Inactivity after which an open order is abandoned
+} SessionTimeouts;
+
+/**
+ * @brief The outcome of an event.
+ */
+typedef struct
+{
+    EngineStatus status;  // ENGINE_OK if the event was applied
+    SessionState state;   // State of the session after the event
+    CartResult cart;      // Outcome of the request, for SESSION_EVENT_SELECT_ITEM
+    ChangeResult payout;  // Change reserved by a confirmation, or the refund of a cancellation
+} SessionResult;
+
+// Function Prototypes
+void initSessionTimeouts(SessionTimeouts *, long long);
+void startPurchaseSession(PurchaseSession *, void *, int);
+void resumePurchaseSession(PurchaseSession *);
+SessionResult advanceSession(VendingMachine *, SessionTimeouts *, PurchaseSession *,
+                             const SessionEvent *, long long);
+void endPurchaseSession(VendingMachine *, SessionTimeouts *, PurchaseSession *, long long);
+PurchaseSession *nextExpiredSession(SessionTimeouts *, long long);
+long long nextSessionDeadline(const SessionTimeouts *);
+const char *sessionStateName(SessionState);
+
+#endif  // PURCHASE_SESSION_H
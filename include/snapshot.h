@@ -0,0 +1,71 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "catalog.h"
+#include "data_structures.h"
+
+#define SNAPSHOT_FILE "vending_state.bin"  // File the full machine state is saved to
+#define SNAPSHOT_MAGIC 0x50414E53444E4556ull  // "VENDSNAP" read as a little-endian number
+#define SNAPSHOT_VERSION 3                     // Raised whenever the layout below changes
+
+/**
+ * @brief Header at the start of a snapshot file. It is followed by the items, their sales totals,
+ * the register and the lines of the order in progress, each stored exactly as laid out in memory.
+ */
+typedef struct
+{
+    uint64_t magic;        // SNAPSHOT_MAGIC
+    uint32_t version;      // SNAPSHOT_VERSION
+    uint32_t checksum;     // CRC-32 of the rest of the header and everything after it
+    uint64_t sequence;     // Last journal record included in the snapshot
+    int64_t userMoney;     // Money inserted for the order in progress
+    int32_t itemCount;     // Number of items stored
+    int32_t registerSize;  // Number of register slots stored
+    int32_t lineCount;     // Number of lines of the order in progress stored
+    int32_t itemSize;      // sizeof(VendingItem) when written, to reject other layouts
+    int32_t cashSize;      // sizeof(CashRegister) when written
+    int32_t salesSize;     // sizeof(ItemSales) when written
+} SnapshotHeader;
+
+/**
+ * @brief One line of the order in progress, keyed by item number so it survives reordering.
+ */
+typedef struct
+{
+    int64_t unitPrice;   // Price each unit of the line is charged at
+    int32_t itemNumber;  // Item number of the line's item
+    int32_t quantity;    // Units of the item in the order
+} SnapshotLine;
+
+/**
+ * @brief The full state of a machine at one point of its journal.
+ *
+ * When filled in by loadSnapshot the arrays point into the mapped file and stay valid until
+ * releaseSnapshot; when passed to writeSnapshot they may point anywhere.
+ */
+typedef struct
+{
+    uint64_t sequence;           // Last journal record included in the state
+    Cents userMoney;             // Money inserted for the order in progress
+    const VendingItem *items;    // Every item of the inventory
+    int itemCount;               // Number of items
+    const ItemSales *sales;      // Sales totals of each item, parallel to items
+    const CashRegister *cash;    // Every slot of the cash register
+    int registerSize;            // Number of register slots
+    const SnapshotLine *lines;   // Lines of the order in progress
+    int lineCount;               // Number of lines, 0 if no order is in progress
+    void *mapping;               // Mapped file, NULL if the state was not loaded from a file
+    size_t mappingSize;          // Size of the mapped file
+} MachineSnapshot;
+
+// Function Prototypes
+int writeSnapshot(const char *, const MachineSnapshot *);
+int loadSnapshot(const char *, MachineSnapshot *);
+int copySnapshotItems(const MachineSnapshot *, Catalog *);
+void restoreSnapshot(const MachineSnapshot *, VendingMachine *, UserSelection *, Cents *);
+void releaseSnapshot(MachineSnapshot *);
+
+#endif  // SNAPSHOT_H
@@ -0,0 +1,14 @@
+#ifndef SOCKET_SERVER_H
+#define SOCKET_SERVER_H
+
+#include "data_structures.h"
+
+#define SERVER_MAX_EVENTS 64              // Events taken from epoll per wait
+#define SESSION_LINE_SIZE 256             // Longest command line a client may send
+#define SESSION_OUTPUT_LIMIT (1024 * 1024)  // Reply bytes queued for a slow client before it is
+                                            // dropped
+
+// Function Prototypes
+int runSocketServer(VendingMachine *, const char *, int, long long);
+
+#endif  // SOCKET_SERVER_H
@@ -0,0 +1,47 @@
+#ifndef TRANSACTION_LOG_H
+#define TRANSACTION_LOG_H
+
+#include <stdint.h>
+
+#include "constants.h"
+#include "data_structures.h"
+
+#define TRANSACTION_LOG_SIZE 512   // Most recent transactions kept in memory
+#define TRANSACTION_MAX_LINES 8    // Cart lines stored per transaction; the rest are only counted
+
+/**
+ * @brief How a transaction ended.
+ */
+typedef enum
+{
+    TRANSACTION_CONFIRMED = 1,  // The order was paid for
+    TRANSACTION_CANCELLED       // The order was canceled and the money refunded
+} TransactionOutcome;
+
+/**
+ * @brief One finished transaction, in a fixed size so the log never allocates as it fills.
+ */
+typedef struct
+{
+    uint64_t sequence;                           // Position of the transaction in the log, from 1
+    int64_t time;                                // Seconds since the epoch when it ended
+    Cents moneyIn;                               // Money inserted for the order
+    Cents totalCost;                             // Cost of the order
+    Cents changeGiven;                           // Change or refund paid out of the register
+    Cents changeShort;                           // Part of the change the register could not pay
+    int32_t itemNumbers[TRANSACTION_MAX_LINES];  // Item number of each stored cart line
+    int32_t quantities[TRANSACTION_MAX_LINES];   // Units of each stored cart line
+    uint16_t dispensed[MAX_DENOMINATIONS];       // Pieces paid out of each register slot
+    int32_t otherUnits;                          // Units on the cart lines that were not stored
+    int32_t lineCount;                           // Lines in the cart, stored or not
+    uint8_t outcome;                             // A TransactionOutcome
+} TransactionRecord;
+
+// Function Prototypes
+TransactionLog *createTransactionLog(void);
+void destroyTransactionLog(TransactionLog *);
+void appendTransaction(TransactionLog *, const TransactionRecord *);
+uint64_t transactionCount(const TransactionLog *);
+int readTransaction(const TransactionLog *, uint64_t, TransactionRecord *);
+
+#endif  // TRANSACTION_LOG_H
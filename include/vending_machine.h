@@ -2,27 +2,24 @@
 #define VENDING_MACHINE_H
 
 #include "data_structures.h"
+#include "engine.h"
+#include "purchase_session.h"
 
 // Function Prototypes
 
 // Display Functions
-void displayItems(VendingItem[], int);
-void printSelectedItems(UserSelection *);
+void displayItems(VendingMachine *);
+void printSelectedItems(const VendingMachine *, UserSelection *);
 
 // User Input Functions
-int isValidDenomination(float);
-void userMoneyInput(float *, CashRegister[], int);
-void processSelection(VendingItem[], int, UserSelection *, float *, CashRegister[], int);
-void selectItems(VendingItem[], int, UserSelection *, float *, CashRegister[], int);
+void userMoneyInput(PurchaseSession *, VendingMachine *);
+void processSelection(VendingMachine *, PurchaseSession *, int, int);
+void selectItems(VendingMachine *, PurchaseSession *);
 // Selection Update Functions
-void updateSelectedItems(UserSelection *, VendingItem *);
-void getSilog(UserSelection *);
+void getSilog(const VendingMachine *, UserSelection *);
 
 // Cash Transaction Functions
-void getChange(CashRegister cash[], float *userMoney, int registerSize, float *totalItemCost,
-               int *confirmation);
-void resetOrderAfterCancel(UserSelection *, float *, VendingItem[], int);
-void dispenseChange(CashRegister cash[], int registerSize, float amountToDispense);
-void resetOrderAfterConfirm(UserSelection *, float *);
+int getChange(VendingMachine *machine, PurchaseSession *session);
+int dispenseChange(VendingMachine *machine, PurchaseSession *session);
 
 #endif  // VENDING_MACHINE_H
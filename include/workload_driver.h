@@ -0,0 +1,9 @@
+#ifndef WORKLOAD_DRIVER_H
+#define WORKLOAD_DRIVER_H
+
+#include "data_structures.h"
+
+// Function Prototypes
+int runWorkloadDriver(const char *scriptPath, int repeatCount, const VendingMachine *machine);
+
+#endif  // WORKLOAD_DRIVER_H
@@ -0,0 +1,290 @@
+#include "cart.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief The lines of a cart that outgrew its inline lines, followed by an index that finds the
+ * line of an item in O(1) however many lines the order has.
+ */
+struct CartSpill
+{
+    CartSpill *next;   // Next free buffer of the same size while the buffer is in the pool
+    int sizeClass;     // The buffer holds CART_SPILL_MIN_LINES << sizeClass lines
+    int *slots;        // Line of each inventory index plus 1, keyed by the index; 0 marks an empty
+                       // slot. Twice as many slots as lines, stored after the lines
+    CartLine lines[];  // Lines of the cart
+};
+
+/**
+ * @brief Free spill buffers of each size, shared by every cart. Orders large enough to spill come
+ * and go all day, so their buffers are reused instead of allocated and freed for each order.
+ */
+typedef struct
+{
+    pthread_mutex_t lock;                         // Guards the lists; kiosks share the pool
+    CartSpill *buffers[CART_SPILL_SIZE_CLASSES];  // Free buffers of each size, linked by next
+    int bufferCounts[CART_SPILL_SIZE_CLASSES];    // Number of free buffers of each size
+} SpillPool;
+
+static SpillPool spillPool = {PTHREAD_MUTEX_INITIALIZER, {NULL}, {0}};
+
+/**
+ * @brief Counts the lines a spill buffer holds.
+ * @param sizeClass The size class of the buffer.
+ * @return The number of lines.
+ */
+static int spillCapacity(int sizeClass)
+{
+    return CART_SPILL_MIN_LINES << sizeClass;
+}
+
+/**
+ * @brief Takes an empty spill buffer from the pool, or allocates one if the pool has none.
+ * @param sizeClass The size class of the buffer.
+ * @return The buffer with every slot empty, or NULL if memory ran out.
+ */
+static CartSpill *takeSpill(int sizeClass)
+{
+    int capacity = spillCapacity(sizeClass);
+    CartSpill *spill;
+
+    pthread_mutex_lock(&spillPool.lock);
+    spill = spillPool.buffers[sizeClass];
+    if (spill != NULL)
+    {
+        spillPool.buffers[sizeClass] = spill->next;
+        spillPool.bufferCounts[sizeClass]--;
+    }
+    pthread_mutex_unlock(&spillPool.lock);
+
+    if (spill == NULL)
+    {
+        spill = malloc(sizeof(CartSpill) + (size_t) capacity * sizeof(CartLine) +
+                       (size_t) capacity * 2 * sizeof(int));
+        if (spill != NULL)
+        {
+            spill->sizeClass = sizeClass;
+            spill->slots = (int *) &spill->lines[capacity];
+        }
+    }
+    if (spill != NULL)
+    {
+        memset(spill->slots, 0, (size_t) capacity * 2 * sizeof(int));
+    }
+    return spill;
+}
+
+/**
+ * @brief Gives a spill buffer back to the pool, or frees it if the pool has enough of its size.
+ * @param spill The buffer, no longer used by any cart.
+ */
+static void returnSpill(CartSpill *spill)
+{
+    int isPooled;
+
+    pthread_mutex_lock(&spillPool.lock);
+    isPooled = (spillPool.bufferCounts[spill->sizeClass] < CART_POOL_DEPTH);
+    if (isPooled)
+    {
+        spill->next = spillPool.buffers[spill->sizeClass];
+        spillPool.buffers[spill->sizeClass] = spill;
+        spillPool.bufferCounts[spill->sizeClass]++;
+    }
+    pthread_mutex_unlock(&spillPool.lock);
+
+    if (!isPooled)
+    {
+        free(spill);
+    }
+}
+
+/**
+ * @brief Indexes a spilled cart line under the first free slot from its item's home slot.
+ * @param spill The buffer holding the line.
+ * @param line The line to index.
+ */
+static void indexLine(CartSpill *spill, int line)
+{
+    int mask = spillCapacity(spill->sizeClass) * 2 - 1;
+    int slot = spill->lines[line].itemIndex & mask;
+
+    while (spill->slots[slot] != 0)
+    {
+        slot = (slot + 1) & mask;
+    }
+    spill->slots[slot] = line + 1;
+}
+
+/**
+ * @brief Gets the lines of a cart for changing them.
+ * @param selection The cart.
+ * @return The cart's lines, valid until the cart next grows.
+ */
+static CartLine *editableLines(UserSelection *selection)
+{
+    return (selection->spill != NULL) ? selection->spill->lines : selection->lines;
+}
+
+/**
+ * @brief Moves the lines of a full cart to a spill buffer twice the size of the one it has.
+ * @param selection The cart, whose lines are all in use.
+ * @return 1 if the cart has room for another line, 0 if memory ran out.
+ */
+static int growCart(UserSelection *selection)
+{
+    int sizeClass = (selection->spill == NULL) ? 0 : selection->spill->sizeClass + 1;
+    CartSpill *grown = (sizeClass < CART_SPILL_SIZE_CLASSES) ? takeSpill(sizeClass) : NULL;
+
+    if (grown != NULL)
+    {
+        size_t lineBytes = (size_t) selection->count * sizeof(CartLine);
+
+        memcpy(grown->lines, editableLines(selection), lineBytes);
+        for (int line = 0; line < selection->count; line++)
+        {
+            indexLine(grown, line);
+        }
+        if (selection->spill != NULL)
+        {
+            returnSpill(selection->spill);
+        }
+        selection->spill = grown;
+    }
+    return grown != NULL;
+}
+
+/**
+ * @brief Gets the lines of a cart, wherever they are stored.
+ * @param selection The cart.
+ * @return The cart's selection->count lines, valid until the cart next changes.
+ */
+const CartLine *cartLines(const UserSelection *selection)
+{
+    return (selection->spill != NULL) ? selection->spill->lines : selection->lines;
+}
+
+/**
+ * @brief Finds the cart line holding an inventory item.
+ * @param selection The user's cart.
+ * @param index The inventory index of the item.
+ * @return The line of the item in the cart, or -1 if the item is not in the cart.
+ */
+int findCartLine(const UserSelection *selection, int index)
+{
+    int found = -1;
+
+    if (selection->spill == NULL)
+    {
+        // A few inline lines are faster to scan than to index
+        for (int line = 0; found == -1 && line < selection->count; line++)
+        {
+            if (selection->lines[line].itemIndex == index)
+            {
+                found = line;
+            }
+        }
+    }
+    else
+    {
+        const CartSpill *spill = selection->spill;
+        int mask = spillCapacity(spill->sizeClass) * 2 - 1;
+        int slot = index & mask;
+
+        while (found == -1 && spill->slots[slot] != 0)
+        {
+            int line = spill->slots[slot] - 1;
+
+            if (spill->lines[line].itemIndex == index)
+            {
+                found = line;
+            }
+            slot = (slot + 1) & mask;
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief Adds units of an item to a cart, on the item's line if the cart has one or on a new line.
+ *
+ * Only the cart is changed; the caller takes the units from stock and adds them to the total.
+ *
+ * @param selection The user's cart.
+ * @param index The inventory index of the item.
+ * @param quantity The number of units to add; must be positive.
+ * @param unitPrice The price of each unit if a new line is started; an existing line keeps its own.
+ * @return 1 if the units were added, 0 if the cart needed a new line and memory ran out.
+ */
+int addCartUnits(UserSelection *selection, int index, int quantity, Cents unitPrice)
+{
+    int line = findCartLine(selection, index);
+    int isAdded = 1;
+
+    if (line == -1)
+    {
+        int capacity = (selection->spill == NULL) ? CART_INLINE_LINES
+                                                  : spillCapacity(selection->spill->sizeClass);
+
+        isAdded = (selection->count < capacity || growCart(selection));
+        if (isAdded)
+        {
+            line = selection->count++;
+            editableLines(selection)[line].unitPrice = unitPrice;
+            editableLines(selection)[line].itemIndex = index;
+            editableLines(selection)[line].quantity = 0;
+            if (selection->spill != NULL)
+            {
+                indexLine(selection->spill, line);
+            }
+        }
+    }
+    if (isAdded)
+    {
+        editableLines(selection)[line].quantity += quantity;
+    }
+    return isAdded;
+}
+
+/**
+ * @brief Finds the price more units of an item are charged at in a cart.
+ * @param selection The user's cart.
+ * @param index The inventory index of the item.
+ * @param currentPrice The item's current price.
+ * @return The price of the item's line if the cart has one, otherwise the current price.
+ */
+Cents cartUnitPrice(const UserSelection *selection, int index, Cents currentPrice)
+{
+    int line = findCartLine(selection, index);
+
+    return (line != -1) ? cartLines(selection)[line].unitPrice : currentPrice;
+}
+
+/**
+ * @brief Computes the cost of one cart line at the price its units were added at.
+ * @param selection The user's cart.
+ * @param line The line of the cart.
+ * @return The cost of the line, in centavos.
+ */
+Cents cartLineSubtotal(const UserSelection *selection, int line)
+{
+    const CartLine *cartLine = &cartLines(selection)[line];
+
+    return cartLine->unitPrice * cartLine->quantity;
+}
+
+/**
+ * @brief Empties the user's cart, returning its spill buffer to the pool.
+ * @param selection The user's cart.
+ */
+void clearCart(UserSelection *selection)
+{
+    if (selection->spill != NULL)
+    {
+        returnSpill(selection->spill);
+        selection->spill = NULL;
+    }
+    selection->count = 0;          // Reset the number of selected items
+    selection->totalItemCost = 0;  // Reset the total cost of the order
+}
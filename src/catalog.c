@@ -0,0 +1,123 @@
+#include "catalog.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "constants.h"
+#include "data_structures.h"
+
+#define CATALOG_INITIAL_CAPACITY 16  // Items the block holds before it first grows
+
+/**
+ * @brief Initializes an empty catalog.
+ * @param catalog The catalog to initialize.
+ */
+void initCatalog(Catalog *catalog)
+{
+    catalog->items = NULL;
+    catalog->count = 0;
+    catalog->capacity = 0;
+}
+
+/**
+ * @brief Appends an item to the catalog, growing its block when it is full.
+ * @param catalog The catalog to add to.
+ * @param itemNumber The item number shown to the user.
+ * @param name The name of the item. Names longer than the item name field are cut short.
+ * @param price The price of the item in centavos.
+ * @param stock The number of units in stock.
+ * @return 1 if the item was added, 0 if memory ran out.
+ * @pre Pointers to items in the catalog are invalidated when it grows.
+ */
+int addCatalogItem(Catalog *catalog, int itemNumber, const char *name, Cents price, int stock)
+{
+    VendingItem *item = newCatalogItem(catalog);
+
+    if (item != NULL)
+    {
+        item->itemNumber = itemNumber;
+        strncpy(item->name, name, ITEM_NAME_SIZE - 1);
+        item->name[ITEM_NAME_SIZE - 1] = '\0';  // strncpy does not terminate a long name
+        item->price = price;
+        item->stock = stock;
+    }
+    return item != NULL;
+}
+
+/**
+ * @brief Appends an uninitialized item to the catalog for the caller to fill in place.
+ *
+ * The block doubles in size when it is full, so adding n items costs O(n) in total and the items
+ * always stay in one allocation that is cheap to scan and copy.
+ *
+ * @param catalog The catalog to add to.
+ * @return The new item, or NULL if memory ran out.
+ * @pre Pointers to items in the catalog are invalidated when it grows.
+ */
+VendingItem *newCatalogItem(Catalog *catalog)
+{
+    VendingItem *item = NULL;
+
+    if (catalog->count < catalog->capacity ||
+        reserveCatalog(catalog, (catalog->capacity == 0) ? CATALOG_INITIAL_CAPACITY
+                                                         : catalog->capacity * 2))
+    {
+        item = &catalog->items[catalog->count];
+        catalog->count++;
+    }
+    return item;
+}
+
+/**
+ * @brief Grows the catalog's block so it can hold at least a number of items.
+ * @param catalog The catalog to grow.
+ * @param capacity The number of items the block must be able to hold.
+ * @return 1 if the block is large enough, 0 if memory ran out.
+ * @pre Pointers to items in the catalog are invalidated when it grows.
+ */
+int reserveCatalog(Catalog *catalog, int capacity)
+{
+    int isReserved = 1;
+
+    if (capacity > catalog->capacity)
+    {
+        VendingItem *items = realloc(catalog->items, (size_t) capacity * sizeof(VendingItem));
+
+        isReserved = (items != NULL);
+        if (isReserved)
+        {
+            catalog->items = items;
+            catalog->capacity = capacity;
+        }
+    }
+    return isReserved;
+}
+
+/**
+ * @brief Appends every item of one catalog to the end of another with a single copy.
+ * @param catalog The catalog to add to.
+ * @param source The catalog whose items are copied. It is not modified.
+ * @return 1 if the items were added, 0 if memory ran out.
+ */
+int appendCatalog(Catalog *catalog, const Catalog *source)
+{
+    int isAdded = reserveCatalog(catalog, catalog->count + source->count);
+
+    if (isAdded && source->count > 0)
+    {
+        memcpy(&catalog->items[catalog->count], source->items,
+               (size_t) source->count * sizeof(VendingItem));
+        catalog->count += source->count;
+    }
+    return isAdded;
+}
+
+/**
+ * @brief Releases the memory held by a catalog and leaves it empty.
+ * @param catalog The catalog to release.
+ */
+void freeCatalog(Catalog *catalog)
+{
+    free(catalog->items);
+    initCatalog(catalog);
+}
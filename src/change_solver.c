@@ -0,0 +1,795 @@
+#include "change_solver.h"
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "constants.h"
+#include "data_structures.h"
+#include "engine.h"
+
+#define SOLVER_MAX_UNITS 65536            // Largest amount, in units, of the exact search
+#define SOLVER_UNREACHABLE (INT_MAX / 2)  // Piece count marking an amount that cannot be made
+#define REACH_UNITS 32768                 // Amounts, in units, covered by the reachability index
+#define REACH_WORD_BITS 64                // Bits held by each word of the reachability index
+#define REACH_WORDS (REACH_UNITS / REACH_WORD_BITS + 1)  // Words holding amounts 0..REACH_UNITS
+
+/**
+ * @brief Scratch space of one change search. Each search takes a workspace of its own from the
+ *        solver's pool, so kiosks solving change on the same machine never share one.
+ */
+typedef struct SolverWorkspace SolverWorkspace;
+struct SolverWorkspace
+{
+    SolverWorkspace *next;  // Next free workspace while the workspace is in the pool
+    int capacity;           // Largest amount, in units, the workspace can hold
+    int *previous;          // Fewest pieces for each amount using the denominations searched so far
+    int *current;           // Fewest pieces for each amount after adding the next denomination
+    int *taken;             // Pieces taken of each denomination for each amount, one row per stage
+    int *queue;             // Sliding window of candidate counts for one residue class
+};
+
+/**
+ * @brief Denomination tables built once per register, a pool of search workspaces and the
+ *        reachability index of the register counts.
+ */
+struct ChangeSolver
+{
+    int registerSize;                      // Number of denominations the tables were built for
+    int order[MAX_DENOMINATIONS];          // Register slots, largest denomination first
+    int unitValues[MAX_DENOMINATIONS];     // Value of each register slot, in units
+    Cents unitSize;                        // Largest amount every denomination is a multiple of
+    int isCanonical;                       // 1 if largest-first change is always optimal
+    pthread_mutex_t lock;                  // Guards the pool and the index; kiosks share the solver
+    SolverWorkspace *workspaces;           // Free search workspaces, linked by next
+    unsigned long long *reachable;         // Bit u is set if the register can pay out u units
+    int indexedCounts[MAX_DENOMINATIONS];  // Register counts the index describes
+    int isReachableStale;                  // 1 if cash was removed since the index was last built
+    int firstGap;                          // Smallest amount, in units, the register cannot pay out
+};
+
+/**
+ * @brief Checks whether the reachability index must be rebuilt before it is used.
+ * @param solver The solver whose index is checked.
+ * @return 1 if register counts changed since the index was built, 0 otherwise.
+ */
+static int isIndexStale(const ChangeSolver *solver)
+{
+    return __atomic_load_n(&solver->isReachableStale, __ATOMIC_ACQUIRE);  // Set by any thread
+}
+
+/**
+ * @brief Reads the counts of a cash register that other threads may be updating.
+ * @param cash The cash register.
+ * @param registerSize The number of denominations in the cash array.
+ * @param counts Receives the pieces held in each register slot.
+ */
+static void loadCounts(const CashRegister cash[], int registerSize, int counts[])
+{
+    for (int i = 0; i < registerSize; i++)
+    {
+        counts[i] = __atomic_load_n(&cash[i].amountLeft, __ATOMIC_ACQUIRE);
+    }
+}
+
+/**
+ * @brief Computes the greatest common divisor of two positive amounts.
+ * @param a The first amount.
+ * @param b The second amount.
+ * @return The greatest common divisor of a and b.
+ */
+static Cents greatestCommonDivisor(Cents a, Cents b)
+{
+    while (b != 0)
+    {
+        Cents remainder = a % b;
+        a = b;
+        b = remainder;
+    }
+    return a;
+}
+
+/**
+ * @brief Breaks an amount down by taking as many of the largest denomination as possible first.
+ * @param solver The solver holding the denomination order.
+ * @param counts The pieces held in each register slot, which limit the breakdown.
+ * @param amount The amount to break down, in centavos.
+ * @param isCapped Set to 1 if the register ran short of a denomination the walk wanted more of.
+ * @return The breakdown, with status ENGINE_INEXACT_CHANGE if part of the amount is left over.
+ */
+static ChangeResult greedyChange(const ChangeSolver *solver, const int counts[], Cents amount,
+                                 int *isCapped)
+{
+    ChangeResult result;
+    Cents remaining = amount;  // Part of the amount still to be covered
+
+    memset(&result, 0, sizeof(result));
+    *isCapped = 0;
+
+    for (int i = 0; i < solver->registerSize; i++)
+    {
+        int slot = solver->order[i];
+        Cents denomination = solver->unitValues[slot] * solver->unitSize;
+        Cents count = remaining / denomination;  // As many as fit in the remainder
+
+        if (count > counts[slot])
+        {
+            count = counts[slot];  // Limited by what the register holds
+            *isCapped = 1;
+        }
+
+        result.counts[slot] = (int) count;
+        result.pieces += (int) count;
+        remaining -= count * denomination;
+    }
+
+    result.remaining = remaining;
+    result.status = (remaining == 0) ? ENGINE_OK : ENGINE_INEXACT_CHANGE;
+    return result;
+}
+
+/**
+ * @brief Checks whether largest-first change is optimal for every amount given unlimited pieces.
+ *
+ * Compares the largest-first piece count against the fewest possible pieces for every amount
+ * below the sum of the two largest denominations, which is enough to find a counterexample if
+ * one exists. Only called once, when the solver is created.
+ *
+ * @param solver The solver whose denomination tables are checked.
+ * @return 1 if the denominations are canonical, 0 if not or if the check could not be run.
+ */
+static int checkCanonical(const ChangeSolver *solver)
+{
+    int isCanonical = 0;
+    int limit = solver->unitValues[solver->order[0]];
+    int *fewest = NULL;
+
+    if (solver->registerSize > 1)
+    {
+        limit += solver->unitValues[solver->order[1]];
+    }
+
+    // The bound only holds when the smallest unit is itself a denomination
+    if (solver->unitValues[solver->order[solver->registerSize - 1]] == 1)
+    {
+        fewest = malloc((size_t) (limit + 1) * sizeof(int));
+    }
+
+    if (fewest != NULL)
+    {
+        isCanonical = 1;
+        fewest[0] = 0;
+        for (int amount = 1; amount <= limit && isCanonical; amount++)
+        {
+            int greedyPieces = 0;
+            int remaining = amount;
+
+            fewest[amount] = SOLVER_UNREACHABLE;
+            for (int i = 0; i < solver->registerSize; i++)
+            {
+                int value = solver->unitValues[solver->order[i]];
+
+                if (value <= amount && fewest[amount - value] + 1 < fewest[amount])
+                {
+                    fewest[amount] = fewest[amount - value] + 1;
+                }
+                greedyPieces += remaining / value;
+                remaining %= value;
+            }
+
+            if (greedyPieces != fewest[amount])
+            {
+                isCanonical = 0;
+            }
+        }
+        free(fewest);
+    }
+    return isCanonical;
+}
+
+/**
+ * @brief Takes a free search workspace from the solver's pool, or makes an empty one.
+ * @param solver The solver whose pool is used.
+ * @return The workspace, or NULL if memory ran out.
+ */
+static SolverWorkspace *takeWorkspace(ChangeSolver *solver)
+{
+    SolverWorkspace *workspace;
+
+    pthread_mutex_lock(&solver->lock);
+    workspace = solver->workspaces;
+    if (workspace != NULL)
+    {
+        solver->workspaces = workspace->next;
+    }
+    pthread_mutex_unlock(&solver->lock);
+
+    if (workspace == NULL)
+    {
+        workspace = calloc(1, sizeof(SolverWorkspace));  // Grown by the first search that uses it
+    }
+    return workspace;
+}
+
+/**
+ * @brief Gives a search workspace back to the solver's pool for the next search.
+ * @param solver The solver whose pool receives the workspace.
+ * @param workspace The workspace, no longer used by any search.
+ */
+static void returnWorkspace(ChangeSolver *solver, SolverWorkspace *workspace)
+{
+    pthread_mutex_lock(&solver->lock);
+    workspace->next = solver->workspaces;
+    solver->workspaces = workspace;
+    pthread_mutex_unlock(&solver->lock);
+}
+
+/**
+ * @brief Frees a search workspace and its tables.
+ * @param workspace The workspace to free.
+ */
+static void freeWorkspace(SolverWorkspace *workspace)
+{
+    free(workspace->previous);
+    free(workspace->current);
+    free(workspace->taken);
+    free(workspace->queue);
+    free(workspace);
+}
+
+/**
+ * @brief Grows a search workspace so it can hold amounts up to a number of units.
+ * @param workspace The workspace to grow.
+ * @param registerSize The number of denominations, one row of the taken table each.
+ * @param units The largest amount, in units, the next search needs.
+ * @return 1 if the workspace is large enough, 0 if memory could not be allocated.
+ */
+static int reserveWorkspace(SolverWorkspace *workspace, int registerSize, int units)
+{
+    int isReserved = 1;
+
+    if (units > workspace->capacity)
+    {
+        int capacity = workspace->capacity * 2;  // Grow geometrically to avoid reallocating often
+        size_t row;
+        int *previous;
+        int *current;
+        int *taken;
+        int *queue;
+
+        if (capacity < units)
+        {
+            capacity = units;
+        }
+        if (capacity > SOLVER_MAX_UNITS)
+        {
+            capacity = SOLVER_MAX_UNITS;
+        }
+        row = (size_t) capacity + 1;
+
+        // Blocks that do grow are kept; the old capacity still describes all of them
+        previous = realloc(workspace->previous, row * sizeof(int));
+        if (previous != NULL)
+        {
+            workspace->previous = previous;
+        }
+        current = realloc(workspace->current, row * sizeof(int));
+        if (current != NULL)
+        {
+            workspace->current = current;
+        }
+        taken = realloc(workspace->taken, row * (size_t) registerSize * sizeof(int));
+        if (taken != NULL)
+        {
+            workspace->taken = taken;
+        }
+        queue = realloc(workspace->queue, row * sizeof(int));
+        if (queue != NULL)
+        {
+            workspace->queue = queue;
+        }
+
+        isReserved = (previous != NULL && current != NULL && taken != NULL && queue != NULL);
+        if (isReserved)
+        {
+            workspace->capacity = capacity;
+        }
+    }
+    return isReserved;
+}
+
+/**
+ * @brief Adds one denomination to the search, allowing up to a fixed number of its pieces.
+ *
+ * For each residue class modulo the denomination, the fewest pieces for an amount is the
+ * minimum over a sliding window of the previous stage, which a monotone queue yields in
+ * constant time per amount.
+ *
+ * @param workspace The workspace holding the previous stage.
+ * @param stage The row of the taken table to fill.
+ * @param value The denomination's value, in units.
+ * @param available The number of pieces of the denomination the register holds.
+ * @param units The amount being searched for, in units.
+ */
+static void addDenominationStage(SolverWorkspace *workspace, int stage, int value, int available,
+                                 int units)
+{
+    const int *previous = workspace->previous;
+    int *current = workspace->current;
+    int *taken = workspace->taken + (size_t) stage * ((size_t) workspace->capacity + 1);
+    int *queue = workspace->queue;
+
+    for (int residue = 0; residue < value && residue <= units; residue++)
+    {
+        int head = 0;
+        int tail = 0;
+
+        for (int k = 0, amount = residue; amount <= units; k++, amount += value)
+        {
+            if (previous[amount] < SOLVER_UNREACHABLE)
+            {
+                int key = previous[amount] - k;
+
+                // Drop candidates that can never beat this one again
+                while (tail > head &&
+                       previous[residue + queue[tail - 1] * value] - queue[tail - 1] >= key)
+                {
+                    tail--;
+                }
+                queue[tail++] = k;
+            }
+
+            // Drop candidates that would need more pieces than the register holds
+            while (head < tail && queue[head] < k - available)
+            {
+                head++;
+            }
+
+            if (head < tail)
+            {
+                int j = queue[head];
+                current[amount] = previous[residue + j * value] + (k - j);
+                taken[amount] = k - j;
+            }
+            else
+            {
+                current[amount] = SOLVER_UNREACHABLE;
+                taken[amount] = 0;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Searches the register counts for the exact breakdown with the fewest pieces.
+ *
+ * Amounts above the search window have their excess covered by the largest denominations
+ * first, then every amount up to the rest is solved one denomination at a time.
+ *
+ * @param solver The solver built for the register's denominations.
+ * @param counts The pieces held in each register slot, which limit the breakdown.
+ * @param amount The amount to break down, in centavos.
+ * @return The breakdown, with status ENGINE_INEXACT_CHANGE if no exact breakdown was found.
+ */
+static ChangeResult searchChange(ChangeSolver *solver, const int counts[], Cents amount)
+{
+    ChangeResult result;
+    int available[MAX_DENOMINATIONS];  // Pieces of each slot still free for the search
+    Cents total = 0;
+    Cents units = amount / solver->unitSize;
+    SolverWorkspace *workspace = takeWorkspace(solver);
+
+    memset(&result, 0, sizeof(result));
+    result.remaining = amount;
+    result.status = ENGINE_INEXACT_CHANGE;
+
+    for (int i = 0; i < solver->registerSize; i++)
+    {
+        available[i] = counts[i];
+        total += solver->unitValues[i] * solver->unitSize * counts[i];
+    }
+
+    // Cover any excess over the search window with the largest denominations first
+    for (int i = 0; i < solver->registerSize && units > SOLVER_MAX_UNITS; i++)
+    {
+        int slot = solver->order[i];
+        Cents value = solver->unitValues[slot];
+        Cents count = (units - SOLVER_MAX_UNITS + value - 1) / value;  // Enough to fit the window
+
+        if (count > units / value)
+        {
+            count = units / value;
+        }
+        if (count > available[slot])
+        {
+            count = available[slot];
+        }
+
+        result.counts[slot] = (int) count;
+        result.pieces += (int) count;
+        available[slot] -= (int) count;
+        units -= count * value;
+    }
+
+    // Only amounts made of whole units and covered by the register can be exact
+    if (workspace != NULL && amount % solver->unitSize == 0 && amount <= total &&
+        units <= SOLVER_MAX_UNITS && reserveWorkspace(workspace, solver->registerSize, (int) units))
+    {
+        size_t row = (size_t) workspace->capacity + 1;
+
+        // Fewest pieces for every amount up to the target, one denomination at a time
+        workspace->previous[0] = 0;
+        for (int amountUnits = 1; amountUnits <= units; amountUnits++)
+        {
+            workspace->previous[amountUnits] = SOLVER_UNREACHABLE;
+        }
+        for (int stage = 0; stage < solver->registerSize; stage++)
+        {
+            int *swap;
+
+            addDenominationStage(workspace, stage, solver->unitValues[stage], available[stage],
+                                 (int) units);
+            swap = workspace->previous;
+            workspace->previous = workspace->current;
+            workspace->current = swap;
+        }
+
+        if (workspace->previous[units] < SOLVER_UNREACHABLE)
+        {
+            // Walk the taken table back from the target to recover each denomination's count
+            for (int stage = solver->registerSize - 1; stage >= 0; stage--)
+            {
+                int count = workspace->taken[(size_t) stage * row + (size_t) units];
+
+                result.counts[stage] += count;
+                result.pieces += count;
+                units -= (Cents) count * solver->unitValues[stage];
+            }
+            result.remaining = 0;
+            result.status = ENGINE_OK;
+        }
+    }
+    if (workspace != NULL)
+    {
+        returnWorkspace(solver, workspace);
+    }
+    return result;
+}
+
+/**
+ * @brief Adds a denomination to the reachability index by shifting it onto itself.
+ *
+ * Every amount that was reachable stays reachable, and becomes reachable again with the new
+ * piece on top. Bits are processed from the top down so each source word is read before it is
+ * overwritten.
+ *
+ * @param reachable The reachability index to update.
+ * @param shift The value of the added piece, in units.
+ */
+static void shiftReachable(unsigned long long reachable[], long long shift)
+{
+    if (shift <= REACH_UNITS)
+    {
+        int wordShift = (int) (shift / REACH_WORD_BITS);
+        int bitShift = (int) (shift % REACH_WORD_BITS);
+
+        for (int i = REACH_WORDS - 1; i >= wordShift; i--)
+        {
+            unsigned long long moved = reachable[i - wordShift] << bitShift;
+
+            if (bitShift != 0 && i - wordShift - 1 >= 0)
+            {
+                moved |= reachable[i - wordShift - 1] >> (REACH_WORD_BITS - bitShift);
+            }
+            reachable[i] |= moved;
+        }
+
+        // Drop bits past the last amount the index covers
+        reachable[REACH_WORDS - 1] &= (2ULL << (REACH_UNITS % REACH_WORD_BITS)) - 1;
+    }
+}
+
+/**
+ * @brief Moves the first unreachable amount forward past any amounts that became reachable.
+ * @param solver The solver whose reachability index is scanned.
+ */
+static void advanceFirstGap(ChangeSolver *solver)
+{
+    int gap = solver->firstGap;
+
+    while (gap <= REACH_UNITS &&
+           (solver->reachable[gap / REACH_WORD_BITS] >> (gap % REACH_WORD_BITS)) & 1ULL)
+    {
+        gap++;
+    }
+    solver->firstGap = gap;
+}
+
+/**
+ * @brief Rebuilds the reachability index from the counts in the cash register.
+ *
+ * Each denomination's count is split into pieces of 1, 2, 4, ... so that only a logarithmic
+ * number of shifts is needed per denomination. The counts indexed are kept, so cash added later
+ * is shifted in only if the rebuild did not already see it.
+ *
+ * @param solver The solver whose reachability index is rebuilt; its lock must be held.
+ * @param cash The cash register whose counts are indexed.
+ */
+static void rebuildReachable(ChangeSolver *solver, const CashRegister cash[])
+{
+    // Cleared before the counts are read, so a change noted while rebuilding is not lost
+    __atomic_store_n(&solver->isReachableStale, 0, __ATOMIC_RELEASE);
+    loadCounts(cash, solver->registerSize, solver->indexedCounts);
+    memset(solver->reachable, 0, REACH_WORDS * sizeof(unsigned long long));
+    solver->reachable[0] = 1ULL;  // Nothing at all can always be paid out
+
+    for (int i = 0; i < solver->registerSize; i++)
+    {
+        long long left = solver->indexedCounts[i];
+
+        for (long long chunk = 1; left > 0 && chunk * solver->unitValues[i] <= REACH_UNITS;
+             chunk *= 2)
+        {
+            long long pieces = (chunk < left) ? chunk : left;
+
+            shiftReachable(solver->reachable, pieces * solver->unitValues[i]);
+            left -= pieces;
+        }
+    }
+
+    solver->firstGap = 0;
+    advanceFirstGap(solver);
+}
+
+/**
+ * @brief Builds the change-making tables for a set of cash register denominations.
+ * @param cash The cash register whose denominations are used.
+ * @param registerSize The number of denominations in the cash array.
+ * @return The new solver, or NULL if the register is invalid or memory ran out.
+ */
+ChangeSolver *createChangeSolver(const CashRegister cash[], int registerSize)
+{
+    ChangeSolver *solver = NULL;
+    Cents unitSize = 0;
+    int isValid = (registerSize > 0 && registerSize <= MAX_DENOMINATIONS);
+
+    for (int i = 0; i < registerSize && isValid; i++)
+    {
+        isValid = (cash[i].cashDenomination > 0);
+        unitSize = greatestCommonDivisor(cash[i].cashDenomination, unitSize);
+    }
+
+    if (isValid)
+    {
+        solver = calloc(1, sizeof(ChangeSolver));
+    }
+    if (solver != NULL)
+    {
+        solver->reachable = malloc(REACH_WORDS * sizeof(unsigned long long));
+        if (solver->reachable == NULL || pthread_mutex_init(&solver->lock, NULL) != 0)
+        {
+            free(solver->reachable);
+            free(solver);
+            solver = NULL;
+        }
+    }
+
+    if (solver != NULL)
+    {
+        solver->registerSize = registerSize;
+        solver->unitSize = unitSize;
+
+        // Sort the register slots from the largest denomination down (few slots, insertion sort)
+        for (int i = 0; i < registerSize; i++)
+        {
+            int j = i;
+
+            solver->unitValues[i] = (int) (cash[i].cashDenomination / unitSize);
+            while (j > 0 && cash[solver->order[j - 1]].cashDenomination < cash[i].cashDenomination)
+            {
+                solver->order[j] = solver->order[j - 1];
+                j--;
+            }
+            solver->order[j] = i;
+        }
+
+        solver->isCanonical = checkCanonical(solver);
+        solver->isReachableStale = 1;  // Built from the register counts on first use
+    }
+    return solver;
+}
+
+/**
+ * @brief Frees a solver and its workspaces.
+ * @param solver The solver to free. May be NULL.
+ */
+void destroyChangeSolver(ChangeSolver *solver)
+{
+    if (solver != NULL)
+    {
+        while (solver->workspaces != NULL)
+        {
+            SolverWorkspace *workspace = solver->workspaces;
+
+            solver->workspaces = workspace->next;
+            freeWorkspace(workspace);
+        }
+        pthread_mutex_destroy(&solver->lock);
+        free(solver->reachable);
+        free(solver);
+    }
+}
+
+/**
+ * @brief Breaks an amount into the fewest bills and coins the cash register can give.
+ *
+ * Largest-first change is returned directly when it is exact, never ran short of a
+ * denomination, and the denominations are canonical, since it is then already optimal.
+ * Otherwise a bounded search over the register counts finds the exact breakdown with the
+ * fewest pieces. Amounts above the search window have their excess covered by the largest
+ * denominations first. If no exact breakdown exists, the largest-first partial breakdown is
+ * returned so callers can still pay out what the register holds.
+ *
+ * Any number of threads may solve change with the same solver at once: the register counts are
+ * read once up front, and each search works in a workspace of its own.
+ *
+ * @param solver The solver built for the register's denominations.
+ * @param cash The cash register whose counts limit the breakdown. It is not modified.
+ * @param registerSize The number of denominations in the cash array.
+ * @param amount The amount to break down, in centavos.
+ * @return The breakdown, with status ENGINE_INEXACT_CHANGE and the uncovered remainder if the
+ *         register cannot make the exact amount.
+ */
+ChangeResult solveChange(ChangeSolver *solver, const CashRegister cash[], int registerSize,
+                         Cents amount)
+{
+    ChangeResult result;
+    int counts[MAX_DENOMINATIONS];  // The register counts the breakdown is planned from
+    int isCapped;
+
+    memset(&result, 0, sizeof(result));
+    result.remaining = amount;
+
+    if (amount == 0)
+    {
+        result.status = ENGINE_OK;  // Nothing to give back
+    }
+    else if (amount < 0 || registerSize != solver->registerSize)
+    {
+        result.status = ENGINE_INEXACT_CHANGE;
+    }
+    else
+    {
+        loadCounts(cash, registerSize, counts);
+        result = greedyChange(solver, counts, amount, &isCapped);
+
+        // Largest-first is provably optimal unless it ran short or the denominations are odd
+        if (result.status != ENGINE_OK || isCapped || !solver->isCanonical)
+        {
+            ChangeResult best = searchChange(solver, counts, amount);
+
+            if (best.status == ENGINE_OK &&
+                (result.status != ENGINE_OK || best.pieces < result.pieces))
+            {
+                result = best;
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Records that pieces were added to a register slot.
+ *
+ * The reachability index only grows when cash is added, so it is updated in place with one shift
+ * per piece instead of being rebuilt. The index remembers the counts it describes, so only pieces
+ * it has not seen are shifted in, even if another thread rebuilt it after the count went up.
+ *
+ * @param solver The solver built for the register's denominations.
+ * @param cash The cash register, after the pieces were added.
+ * @param slot The register slot that received the pieces.
+ */
+void markCashAdded(ChangeSolver *solver, const CashRegister cash[], int slot)
+{
+    // A stale index is rebuilt from the counts anyway, so only a current one needs the lock
+    if (slot >= 0 && slot < solver->registerSize && !isIndexStale(solver))
+    {
+        pthread_mutex_lock(&solver->lock);
+        if (!isIndexStale(solver))
+        {
+            int count = __atomic_load_n(&cash[slot].amountLeft, __ATOMIC_ACQUIRE);
+
+            if (count < solver->indexedCounts[slot])
+            {
+                markRegisterChanged(solver);  // Pieces were taken out too; rebuild on next use
+            }
+            while (solver->indexedCounts[slot] < count)
+            {
+                shiftReachable(solver->reachable, solver->unitValues[slot]);
+                solver->indexedCounts[slot]++;
+            }
+            advanceFirstGap(solver);
+        }
+        pthread_mutex_unlock(&solver->lock);
+    }
+}
+
+/**
+ * @brief Records that register counts changed in a way the index cannot follow, such as cash
+ *        being removed. The index is rebuilt the next time it is queried.
+ * @param solver The solver built for the register's denominations.
+ */
+void markRegisterChanged(ChangeSolver *solver)
+{
+    __atomic_store_n(&solver->isReachableStale, 1, __ATOMIC_RELEASE);  // May come from any thread
+}
+
+/**
+ * @brief Checks whether the register can pay out an amount exactly.
+ *
+ * Amounts covered by the reachability index are answered with a single bit test; larger amounts
+ * fall back to solveChange. While the index is stale, an exact largest-first breakdown settles
+ * the question first, so checkouts that follow a payout do not each pay for a rebuild.
+ *
+ * @param solver The solver built for the register's denominations.
+ * @param cash The cash register whose counts are checked.
+ * @param registerSize The number of denominations in the cash array.
+ * @param amount The amount to pay out, in centavos.
+ * @return 1 if the register can pay out the exact amount, 0 otherwise.
+ */
+int isAmountReachable(ChangeSolver *solver, const CashRegister cash[], int registerSize,
+                      Cents amount)
+{
+    int isReachable = 0;
+    int counts[MAX_DENOMINATIONS];
+    int isCapped;
+
+    if (isIndexStale(solver) && amount > 0)
+    {
+        loadCounts(cash, registerSize, counts);
+        isReachable = (greedyChange(solver, counts, amount, &isCapped).status == ENGINE_OK);
+    }
+
+    if (!isReachable && amount >= 0 && amount % solver->unitSize == 0)
+    {
+        Cents units = amount / solver->unitSize;
+
+        if (units <= REACH_UNITS)
+        {
+            pthread_mutex_lock(&solver->lock);
+            if (isIndexStale(solver))
+            {
+                rebuildReachable(solver, cash);
+            }
+            isReachable = (int) ((solver->reachable[units / REACH_WORD_BITS] >>
+                                  (units % REACH_WORD_BITS)) & 1ULL);
+            pthread_mutex_unlock(&solver->lock);
+        }
+        else
+        {
+            isReachable = (solveChange(solver, cash, registerSize, amount).status == ENGINE_OK);
+        }
+    }
+    return isReachable;
+}
+
+/**
+ * @brief Checks whether the register can pay out every amount up to a limit exactly.
+ * @param solver The solver built for the register's denominations.
+ * @param cash The cash register whose counts are checked.
+ * @param limit The largest amount to check, in centavos. Only amounts the denominations can
+ *              express (multiples of the smallest unit) are considered.
+ * @return 1 if every such amount up to the limit can be paid out, 0 otherwise.
+ */
+int isEveryAmountReachable(ChangeSolver *solver, const CashRegister cash[], Cents limit)
+{
+    pthread_mutex_lock(&solver->lock);
+    if (isIndexStale(solver))
+    {
+        rebuildReachable(solver, cash);
+    }
+    int isEveryReachable = (limit / solver->unitSize < solver->firstGap);
+    pthread_mutex_unlock(&solver->lock);
+    return isEveryReachable;
+}
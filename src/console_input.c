@@ -0,0 +1,349 @@
+#define _POSIX_C_SOURCE 200809L  // Expose read
+
+#include "console_input.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "money.h"
+
+/**
+ * @brief Standard input read ahead in large blocks.
+ *
+ * Every prompt takes its answer from this buffer, so a controller that pipes a burst of commands
+ * has them all read with one system call and parsed straight from memory. Input is split into
+ * words at whitespace, as scanf did, and a word is only handed out once the whitespace after it
+ * has arrived, so a word is never split across two reads.
+ */
+typedef struct
+{
+    char data[INPUT_BUFFER_SIZE];  // Bytes read from standard input
+    size_t start;                  // First byte not consumed yet
+    size_t end;                    // Number of bytes held in data
+    int isAtEnd;                   // 1 once standard input is closed or fails
+    int isClosed;                  // 1 once a prompt found no word left to read
+} InputBuffer;
+
+static InputBuffer input;
+
+/**
+ * @brief Checks whether a byte separates words.
+ * @param byte The byte to check.
+ * @return 1 for a space, tab, carriage return or line break, 0 otherwise.
+ */
+static int isSeparator(char byte)
+{
+    return (byte == ' ' || byte == '\t' || byte == '\r' || byte == '\n');
+}
+
+/**
+ * @brief Reads more of standard input after the bytes not consumed yet.
+ *
+ * Pending output is flushed first, so the prompt is on screen before the program waits.
+ *
+ * @return 1 if more bytes were read, 0 if input has ended or the buffer is full.
+ */
+static int fillInput(void)
+{
+    ssize_t count = 0;
+
+    // Move the unconsumed bytes to the front to make room after them
+    memmove(input.data, &input.data[input.start], input.end - input.start);
+    input.end -= input.start;
+    input.start = 0;
+
+    if (!input.isAtEnd && input.end < sizeof(input.data))
+    {
+        fflush(stdout);
+        do
+        {
+            count = read(STDIN_FILENO, &input.data[input.end], sizeof(input.data) - input.end);
+        } while (count == -1 && errno == EINTR);
+        input.isAtEnd = (count <= 0);
+        input.end += (count > 0) ? (size_t) count : 0;
+    }
+    return count > 0;
+}
+
+/**
+ * @brief Finds the next word of input without consuming it, reading more input as needed.
+ *
+ * Once input has ended no prompt can ever be answered, so the input is marked closed and every
+ * later read fails; callers check isInputClosed to unwind instead of asking again.
+ *
+ * @param length Receives the length of the word, which starts at input.start.
+ * @return 1 if a word was found, 0 if input ended before another word.
+ */
+static int peekWord(size_t *length)
+{
+    size_t stop;  // Counted from input.start, which fillInput moves
+    int isComplete = 0;
+
+    while (!isComplete)
+    {
+        while (input.start < input.end && isSeparator(input.data[input.start]))
+        {
+            input.start++;
+        }
+        stop = 0;
+        while (input.start + stop < input.end && !isSeparator(input.data[input.start + stop]))
+        {
+            stop++;
+        }
+
+        // A word running into the end of the buffer may go on in input not read yet
+        isComplete = (input.start + stop < input.end || !fillInput());
+    }
+    *length = stop;
+    input.isClosed = (stop == 0);
+    return !input.isClosed;
+}
+
+/**
+ * @brief Checks whether standard input has ended, so no prompt can be answered any more.
+ * @return 1 once a read found no input left, 0 otherwise.
+ */
+int isInputClosed(void)
+{
+    return input.isClosed;
+}
+
+/**
+ * @brief Reads a whole number typed by the user, such as "3" or "-1".
+ * @param value Receives the number.
+ * @return 1 if a number was read, 0 if the next word is not a number (it is left unread; discard
+ *         it with discardLine).
+ */
+int readInt(int *value)
+{
+    size_t length;
+    int result = 0;
+
+    if (peekWord(&length))
+    {
+        const char *word = &input.data[input.start];
+        size_t i = (word[0] == '-' || word[0] == '+') ? 1 : 0;
+        long long number = 0;
+
+        result = (i < length);
+        for (; i < length && result; i++)
+        {
+            number = number * 10 + (word[i] - '0');
+            result = (word[i] >= '0' && word[i] <= '9' && number <= (long long) INT_MAX + 1);
+        }
+        if (word[0] == '-')
+        {
+            number = -number;
+        }
+        result = result && number >= INT_MIN && number <= INT_MAX;
+        if (result)
+        {
+            *value = (int) number;
+            input.start += length;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Finds the next word on the current line of input without consuming anything.
+ * @param offset Where to start looking, counted from input.start.
+ * @param wordOffset Receives where the word starts, counted from input.start.
+ * @return The length of the word, or 0 if the line or input ends first.
+ */
+static size_t peekLineWord(size_t offset, size_t *wordOffset)
+{
+    size_t at;    // Counted from input.start, which fillInput moves
+    size_t stop;  // Also counted from input.start
+    int isComplete = 0;
+
+    while (!isComplete)
+    {
+        at = offset;
+        while (input.start + at < input.end && isSeparator(input.data[input.start + at]) &&
+               input.data[input.start + at] != '\n')
+        {
+            at++;
+        }
+        stop = at;
+        while (input.start + stop < input.end && !isSeparator(input.data[input.start + stop]))
+        {
+            stop++;
+        }
+
+        // A word running into the end of the buffer may go on in input not read yet
+        isComplete = (input.start + stop < input.end || !fillInput());
+    }
+    *wordOffset = at;
+    return stop - at;
+}
+
+/**
+ * @brief Measures the multiplication sign at the start of some text: "x", "X", "*" or "\u00d7".
+ * @param text The text.
+ * @param length The length of the text.
+ * @return The length of the sign in bytes, or 0 if the text does not start with one.
+ */
+static size_t signLength(const char *text, size_t length)
+{
+    size_t sign = 0;
+
+    if (length >= 1 && (text[0] == 'x' || text[0] == 'X' || text[0] == '*'))
+    {
+        sign = 1;
+    }
+    else if (length >= 2 && (unsigned char) text[0] == 0xC3 && (unsigned char) text[1] == 0x97)
+    {
+        sign = 2;  // The multiplication sign in UTF-8
+    }
+    return sign;
+}
+
+/**
+ * @brief Parses a count made only of digits, such as an item number or a quantity.
+ * @param text The digits.
+ * @param length The number of digits.
+ * @param value Receives the count.
+ * @return 1 if the text is a count that fits in an int, 0 otherwise.
+ */
+static int parseCount(const char *text, size_t length, int *value)
+{
+    long long number = 0;
+    int result = (length > 0);
+
+    for (size_t i = 0; i < length && result; i++)
+    {
+        number = number * 10 + (text[i] - '0');
+        result = (text[i] >= '0' && text[i] <= '9' && number <= INT_MAX);
+    }
+    if (result)
+    {
+        *value = (int) number;
+    }
+    return result;
+}
+
+/**
+ * @brief Reads an item number typed by the user, optionally followed by a quantity: "7",
+ *        "7 x 200", "7x200", "7 * 200" or "7 \u00d7 200".
+ *
+ * The quantity must be on the same line as the item number, so a piped burst of plain item
+ * numbers, one per word, reads exactly as before.
+ *
+ * @param itemNumber Receives the item number.
+ * @param quantity Receives the quantity, 1 if none was typed.
+ * @return 1 if an order was read, 0 if the input is not one (it is left unread; discard it with
+ *         discardLine).
+ */
+int readItemOrder(int *itemNumber, int *quantity)
+{
+    size_t length;
+    int result = 0;
+
+    if (peekWord(&length))
+    {
+        const char *word = &input.data[input.start];
+        size_t digits = 0;
+        size_t consumed = length;  // Bytes the order takes, counted from input.start
+        size_t quantityOffset = 0;
+        size_t quantityLength = 0;
+        size_t sign;
+
+        while (digits < length && word[digits] >= '0' && word[digits] <= '9')
+        {
+            digits++;
+        }
+        result = parseCount(word, digits, itemNumber);
+        sign = signLength(&word[digits], length - digits);
+
+        if (result && digits < length)
+        {
+            // "7x200", or "7x" with the quantity in the next word
+            result = (sign > 0);
+            quantityOffset = digits + sign;
+            quantityLength = length - quantityOffset;
+        }
+        else if (result)
+        {
+            // "7" alone, or followed by "x200" or by "x" and the quantity
+            size_t next;
+            size_t nextLength = peekLineWord(length, &next);
+
+            sign = signLength(&input.data[input.start + next], nextLength);
+            if (sign > 0)
+            {
+                consumed = next + nextLength;
+                quantityOffset = next + sign;
+                quantityLength = nextLength - sign;
+            }
+        }
+        if (result && quantityOffset > 0 && quantityLength == 0)
+        {
+            quantityLength = peekLineWord(consumed, &quantityOffset);
+        }
+
+        *quantity = 1;
+        if (result && quantityOffset > 0)
+        {
+            result = parseCount(&input.data[input.start + quantityOffset], quantityLength,
+                                quantity) &&
+                     *quantity > 0;
+            consumed = quantityOffset + quantityLength;
+        }
+        if (result)
+        {
+            input.start += consumed;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Reads an amount of money typed by the user, such as "20" or "0.25".
+ * @param amount Receives the amount in centavos.
+ * @return 1 if an amount was read, 0 if the next word is not a valid amount (it is left unread;
+ *         discard it with discardLine).
+ */
+int readCents(Cents *amount)
+{
+    size_t length;
+    int result = 0;
+
+    if (peekWord(&length))
+    {
+        result = parseCentsSpan(&input.data[input.start], length, amount);
+        if (result)
+        {
+            input.start += length;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Skips the rest of the current line of input, including its line break.
+ */
+void discardLine(void)
+{
+    int isDiscarded = 0;
+
+    while (!isDiscarded)
+    {
+        while (input.start < input.end && input.data[input.start] != '\n')
+        {
+            input.start++;
+        }
+        if (input.start < input.end)
+        {
+            input.start++;  // The line break itself
+            isDiscarded = 1;
+        }
+        else
+        {
+            isDiscarded = !fillInput();
+        }
+    }
+}
@@ -0,0 +1,84 @@
+#include "crc32.h"
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CRC32_POLYNOMIAL 0xEDB88320u  // Reversed IEEE 802.3 polynomial, as used by zlib
+
+#define CRC32_SLICES 8                // Bytes folded into the checksum per table lookup round
+
+// crcTables[0] holds the CRC of every byte value; crcTables[k] advances that CRC by k more zero
+// bytes, so eight bytes can be folded in with eight independent lookups (slicing-by-8)
+static uint32_t crcTables[CRC32_SLICES][256];
+static pthread_once_t crcTablesOnce = PTHREAD_ONCE_INIT;  // Builds crcTables exactly once
+
+/**
+ * @brief Fills the lookup tables used by updateCrc32.
+ */
+static void buildCrcTables(void)
+{
+    for (uint32_t byte = 0; byte < 256; byte++)
+    {
+        uint32_t crc = byte;
+
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 1u) ? (crc >> 1) ^ CRC32_POLYNOMIAL : crc >> 1;
+        }
+        crcTables[0][byte] = crc;
+    }
+    for (int slice = 1; slice < CRC32_SLICES; slice++)
+    {
+        for (int byte = 0; byte < 256; byte++)
+        {
+            uint32_t previous = crcTables[slice - 1][byte];
+
+            crcTables[slice][byte] = (previous >> 8) ^ crcTables[0][previous & 0xFFu];
+        }
+    }
+}
+
+/**
+ * @brief Continues a CRC-32 over more data, so a checksum can be built up piece by piece.
+ * @param crc The checksum of the data so far (0 for none).
+ * @param data The next piece of data.
+ * @param length The number of bytes in the piece.
+ * @return The checksum of all the data so far.
+ */
+uint32_t updateCrc32(uint32_t crc, const void *data, size_t length)
+{
+    const unsigned char *bytes = data;
+    size_t i = 0;
+
+    pthread_once(&crcTablesOnce, buildCrcTables);
+
+    crc = ~crc;
+    for (; i + CRC32_SLICES <= length; i += CRC32_SLICES)
+    {
+        // Assemble the bytes in little-endian order so the result does not depend on the host
+        uint32_t low = crc ^ ((uint32_t) bytes[i] | (uint32_t) bytes[i + 1] << 8 |
+                              (uint32_t) bytes[i + 2] << 16 | (uint32_t) bytes[i + 3] << 24);
+
+        crc = crcTables[7][low & 0xFFu] ^ crcTables[6][(low >> 8) & 0xFFu] ^
+              crcTables[5][(low >> 16) & 0xFFu] ^ crcTables[4][low >> 24] ^
+              crcTables[3][bytes[i + 4]] ^ crcTables[2][bytes[i + 5]] ^
+              crcTables[1][bytes[i + 6]] ^ crcTables[0][bytes[i + 7]];
+    }
+    for (; i < length; i++)
+    {
+        crc = crcTables[0][(crc ^ bytes[i]) & 0xFFu] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+/**
+ * @brief Computes the CRC-32 checksum of a block of data.
+ * @param data The data to checksum.
+ * @param length The number of bytes of data.
+ * @return The checksum.
+ */
+uint32_t computeCrc32(const void *data, size_t length)
+{
+    return updateCrc32(0, data, length);
+}
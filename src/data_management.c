@@ -1,19 +1,371 @@
+#define _POSIX_C_SOURCE 200809L  // Expose mmap, fstat, fsync and sysconf
+
 #include "data_management.h"  // Include the header for function declarations
 
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include "catalog.h"          // Include the catalog items are loaded into
 #include "data_structures.h"  // Include your data structure definitions
+#include "money.h"            // Include the shared money formatting routine
+#include "perf_counters.h"    // Include the stage latency counters
+
+#define LOADER_MAX_THREADS 16           // Most threads used to parse one file
+#define LOADER_MIN_CHUNK (1024 * 1024)  // Smallest part of a file worth a thread of its own
+
+/**
+ * @brief A field of a CSV line, pointing into the mapped file rather than copied out of it.
+ */
+typedef struct
+{
+    const char *start;  // First character of the field's text
+    const char *end;    // One past the last character of the field's text
+    int hasQuotes;      // 1 if the text contains doubled quotes that stand for one quote
+} CSVField;
+
+/**
+ * @brief One part of the mapped file and the items parsed from it by a loader thread.
+ */
+typedef struct
+{
+    const char *start;  // First character of the part; always the start of a line
+    const char *end;    // One past the last character; always just after a newline or at EOF
+    Catalog items;      // Items parsed from the part, in file order
+    int isOutOfMemory;  // 1 if an item could not be stored
+} LoaderChunk;
+
+/**
+ * @brief Writes text as a quoted CSV field, doubling any quotes inside it.
+ * @param file The file to write to.
+ * @param text The text of the field.
+ */
+static void writeQuotedField(FILE *file, const char *text)
+{
+    fputc('"', file);
+    for (const char *c = text; *c != '\0'; c++)
+    {
+        if (*c == '"')
+        {
+            fputc('"', file);  // A quote inside a quoted field is written twice
+        }
+        fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+/**
+ * @brief Finds one field of a CSV line, quoted or not, without copying it.
+ * @param cursor The start of the field.
+ * @param end The end of the mapped file.
+ * @param field Receives where the field's text starts and ends.
+ * @return The start of the next field, the newline (or end of file) if this was the last field,
+ *         or NULL if the field is malformed.
+ */
+static const char *scanCSVField(const char *cursor, const char *end, CSVField *field)
+{
+    int isMalformed = 0;
+
+    field->hasQuotes = 0;
+    if (cursor < end && *cursor == '"')
+    {
+        cursor++;
+        field->start = cursor;
+
+        // Find the closing quote, stepping over doubled quotes inside the field
+        while (cursor < end && *cursor != '\n' &&
+               !(*cursor == '"' && (cursor + 1 == end || cursor[1] != '"')))
+        {
+            if (*cursor == '"')
+            {
+                field->hasQuotes = 1;
+                cursor++;  // Skip the first quote of the pair
+            }
+            cursor++;
+        }
+        field->end = cursor;
+
+        isMalformed = (cursor == end || *cursor != '"');  // The line ended inside the quotes
+        if (!isMalformed)
+        {
+            cursor++;
+        }
+    }
+    else
+    {
+        field->start = cursor;
+        while (cursor < end && *cursor != ',' && *cursor != '\n' && *cursor != '\r')
+        {
+            cursor++;
+        }
+        field->end = cursor;
+    }
+
+    if (!isMalformed && cursor < end && *cursor == ',')
+    {
+        cursor++;  // Move on to the next field
+    }
+    else if (cursor < end && *cursor == '\r')
+    {
+        cursor++;  // Accept Windows line endings
+        isMalformed = isMalformed || (cursor < end && *cursor != '\n');
+    }
+    else if (cursor < end && *cursor != '\n')
+    {
+        isMalformed = 1;  // Text after a closing quote
+    }
+    return isMalformed ? NULL : cursor;
+}
+
+/**
+ * @brief Parses a whole non-negative number that fills a field.
+ * @param field The field holding the number.
+ * @param value Receives the number when the field is valid.
+ * @return 1 if the field is a number that fits in an int, 0 otherwise.
+ */
+static int parseFieldNumber(const CSVField *field, int *value)
+{
+    long long number = 0;
+    const char *c = field->start;
+
+    while (c < field->end && *c >= '0' && *c <= '9' && number <= 2147483647LL)
+    {
+        number = number * 10 + (*c - '0');
+        c++;
+    }
+    *value = (int) number;
+    return c == field->end && c != field->start && number <= 2147483647LL;
+}
+
+/**
+ * @brief Parses one line of the mapped file and appends its item to a catalog.
+ * @param cursor The start of the line.
+ * @param end The end of the mapped file.
+ * @param chunk The chunk whose catalog receives the item.
+ * @return The start of the next line. Lines that are not valid items, such as the header, are
+ *         skipped.
+ */
+static const char *parseItemLine(const char *cursor, const char *end, LoaderChunk *chunk)
+{
+    CSVField fields[4];
+    const char *lineEnd;
+    int isValid = 1;
+    int itemNumber;
+    int stock;
+    Cents price;
+
+    for (int i = 0; i < 4 && isValid; i++)
+    {
+        cursor = scanCSVField(cursor, end, &fields[i]);
+        isValid = (cursor != NULL);
+    }
+    isValid = isValid && (cursor == end || *cursor == '\n');  // Exactly four fields
+
+    if (isValid && parseFieldNumber(&fields[0], &itemNumber) && itemNumber > 0 &&
+        fields[1].end > fields[1].start &&
+        parseCentsSpan(fields[2].start, (size_t) (fields[2].end - fields[2].start), &price) &&
+        price > 0 && parseFieldNumber(&fields[3], &stock))
+    {
+        VendingItem *item = newCatalogItem(&chunk->items);
+
+        if (item != NULL)
+        {
+            size_t length = 0;
+
+            // Copy the name straight from the mapped file into the item, undoubling quotes
+            for (const char *c = fields[1].start; c < fields[1].end; c++)
+            {
+                if (fields[1].hasQuotes && *c == '"')
+                {
+                    c++;
+                }
+                if (length < ITEM_NAME_SIZE - 1)
+                {
+                    item->name[length++] = *c;
+                }
+            }
+            item->name[length] = '\0';
+            item->itemNumber = itemNumber;
+            item->price = price;
+            item->stock = stock;
+        }
+        else
+        {
+            chunk->isOutOfMemory = 1;
+        }
+    }
+
+    // Resume after the end of this line whether or not it held an item
+    lineEnd = (cursor != NULL) ? cursor : fields[0].start;
+    lineEnd = memchr(lineEnd, '\n', (size_t) (end - lineEnd));
+    return (lineEnd != NULL) ? lineEnd + 1 : end;
+}
+
+/**
+ * @brief Parses every line of one chunk of the mapped file. Runs on a loader thread.
+ * @param argument The LoaderChunk to parse.
+ * @return NULL.
+ */
+static void *parseChunk(void *argument)
+{
+    LoaderChunk *chunk = argument;
+    const char *cursor = chunk->start;
+
+    while (cursor < chunk->end && !chunk->isOutOfMemory)
+    {
+        cursor = parseItemLine(cursor, chunk->end, chunk);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Parses a mapped CSV file, splitting it into chunks parsed by parallel threads.
+ *
+ * Files of several megabytes are split at line boundaries and parsed by one thread per
+ * processor; each thread fills its own catalog, and the parts are joined in file order.
+ *
+ * @param text The start of the mapped file.
+ * @param size The size of the mapped file in bytes.
+ * @param catalog The catalog the items are appended to.
+ * @return The number of items loaded, or -1 if memory ran out.
+ */
+static int parseMappedItems(const char *text, size_t size, Catalog *catalog)
+{
+    LoaderChunk chunks[LOADER_MAX_THREADS];
+    pthread_t threads[LOADER_MAX_THREADS];
+    int isStarted[LOADER_MAX_THREADS] = {0};
+    const char *end = text + size;
+    const char *start = text;
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    int chunkCount = (int) (size / LOADER_MIN_CHUNK);
+    int isOutOfMemory = 0;
+    int loaded = 0;
+
+    // One chunk per processor, but only once the file is big enough to be worth it
+    if (chunkCount > processors)
+    {
+        chunkCount = (int) processors;
+    }
+    if (chunkCount > LOADER_MAX_THREADS)
+    {
+        chunkCount = LOADER_MAX_THREADS;
+    }
+    if (chunkCount < 1)
+    {
+        chunkCount = 1;
+    }
+
+    // Split the file into roughly equal chunks, each ending just after a newline
+    for (int i = 0; i < chunkCount; i++)
+    {
+        const char *chunkEnd = end;
 
-#define CSV_FILE "vending_items.csv"
+        if (i + 1 < chunkCount)
+        {
+            chunkEnd = text + size / chunkCount * (i + 1);
+            chunkEnd = (chunkEnd > start) ? chunkEnd : start;
+            chunkEnd = memchr(chunkEnd, '\n', (size_t) (end - chunkEnd));
+            chunkEnd = (chunkEnd != NULL) ? chunkEnd + 1 : end;
+        }
+
+        chunks[i].start = start;
+        chunks[i].end = chunkEnd;
+        chunks[i].isOutOfMemory = 0;
+        initCatalog(&chunks[i].items);
+        start = chunkEnd;
+    }
+
+    // The first chunk is parsed on this thread, as is any chunk whose thread cannot start
+    for (int i = 1; i < chunkCount; i++)
+    {
+        isStarted[i] = (pthread_create(&threads[i], NULL, parseChunk, &chunks[i]) == 0);
+    }
+    parseChunk(&chunks[0]);
+    for (int i = 1; i < chunkCount; i++)
+    {
+        if (isStarted[i])
+        {
+            pthread_join(threads[i], NULL);
+        }
+        else
+        {
+            parseChunk(&chunks[i]);
+        }
+    }
+
+    // Join the chunks in file order
+    for (int i = 0; i < chunkCount; i++)
+    {
+        isOutOfMemory = isOutOfMemory || chunks[i].isOutOfMemory ||
+                        !appendCatalog(catalog, &chunks[i].items);
+        loaded += chunks[i].items.count;
+        freeCatalog(&chunks[i].items);
+    }
+    return isOutOfMemory ? -1 : loaded;
+}
+
+/**
+ * @brief Loads the vending items saved by saveItemsToCSV into a catalog.
+ *
+ * The file is memory-mapped and parsed in place: fields are located by pointer and converted
+ * straight into the catalog, without reading lines or fields into buffers. The header and any
+ * line that is not a valid item are skipped. Each item must be on a single line.
+ *
+ * @param catalog The catalog the items are appended to.
+ * @param path The CSV file to read.
+ * @return The number of items loaded, or -1 if the file could not be read or memory ran out.
+ */
+int loadItemsFromCSV(Catalog *catalog, const char *path)
+{
+    struct stat info;
+    int loaded = -1;
+    int file = open(path, O_RDONLY);
+
+    if (file != -1 && fstat(file, &info) == 0)
+    {
+        size_t size = (size_t) info.st_size;
+
+        if (size == 0)
+        {
+            loaded = 0;  // An empty file has no items, and cannot be mapped
+        }
+        else
+        {
+            void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file, 0);
+
+            if (mapping != MAP_FAILED)
+            {
+                posix_madvise(mapping, size, POSIX_MADV_SEQUENTIAL);  // Read ahead aggressively
+                loaded = parseMappedItems(mapping, size, catalog);
+                munmap(mapping, size);
+            }
+        }
+    }
+
+    if (file != -1)
+    {
+        close(file);
+    }
+    return loaded;
+}
 
 /**
  * @brief Saves the details of the vending items to a CSV file.
  * @param items An array of VendingItem structures, each containing the details of a vending item.
  * @param menuSize The total number of items in the items array.
+ * @return 1 if the file was written, 0 if it could not be opened.
  * @pre The items array must be populated with valid vending item data.
  */
-void saveItemsToCSV(VendingItem items[], int menuSize)
+int saveItemsToCSV(VendingItem items[], int menuSize)
 {
+    PERF_START(start);
+
     // Open the file for writing (creates or overwrites the CSV file)
     FILE *file = fopen(CSV_FILE, "w");
 
@@ -21,6 +373,7 @@ void saveItemsToCSV(VendingItem items[], int menuSize)
     if (file == NULL)
     {
         perror("Error opening file for writing");
+        return 0;
     }
 
     // Write the CSV header with column names
@@ -30,14 +383,87 @@ void saveItemsToCSV(VendingItem items[], int menuSize)
     // Loop through all items and write their details to the CSV file
     for (int i = 0; i < menuSize; i++)
     {
+        char price[MONEY_TEXT_SIZE];  // Price formatted as PHP with two decimals
+
         // Enclose item names in double quotes to handle commas or special characters in item names
-        fprintf(file, "\"%d\",\"%s\",\"%.2f\",\"%d\"\n", items[i].itemNumber, items[i].name,
-                items[i].price, items[i].stock);
+        fprintf(file, "\"%d\",", items[i].itemNumber);
+        writeQuotedField(file, items[i].name);
+        fprintf(file, ",\"%s\",\"%d\"\n", formatCents(items[i].price, price), items[i].stock);
     }
 
     // Close the file after writing
     fclose(file);
+    PERF_STOP(PERF_SAVE_ITEMS_TO_CSV, start);
+
+    return 1;  // The data has been saved successfully
+}
+
+/**
+ * @brief Writes a block of bytes to a file, retrying short and interrupted writes.
+ * @param fd The file to write to.
+ * @param data The bytes to write.
+ * @param size The number of bytes.
+ * @return 1 if every byte was written, 0 otherwise.
+ */
+int writeFully(int fd, const void *data, size_t size)
+{
+    const char *cursor = data;
+    size_t remaining = size;
+    int isWritten = 1;
 
-    // Print confirmation message that the data has been saved successfully
-    printf("Data saved to %s successfully.\n", CSV_FILE);
+    while (isWritten && remaining > 0)
+    {
+        ssize_t written = write(fd, cursor, remaining);
+
+        if (written > 0)
+        {
+            cursor += written;
+            remaining -= (size_t) written;
+        }
+        else
+        {
+            isWritten = (written < 0 && errno == EINTR);
+        }
+    }
+    return isWritten;
+}
+
+/**
+ * @brief Syncs the directory holding a file, so a file renamed into it survives a crash.
+ * @param path The path of the file.
+ * @return 1 if the directory was synced, 0 otherwise.
+ */
+int syncParentDirectory(const char *path)
+{
+    char directory[FILE_PATH_SIZE];
+    const char *slash = strrchr(path, '/');
+    size_t length = (slash == NULL) ? 0 : (size_t) (slash - path);
+    int isSynced = 0;
+
+    if (slash == path)
+    {
+        length = 1;  // The file is in the root directory
+    }
+    if (length < FILE_PATH_SIZE)
+    {
+        int fd;
+
+        if (slash == NULL)
+        {
+            strcpy(directory, ".");
+        }
+        else
+        {
+            memcpy(directory, path, length);
+            directory[length] = '\0';
+        }
+
+        fd = open(directory, O_RDONLY);
+        if (fd != -1)
+        {
+            isSynced = (fsync(fd) == 0);
+            close(fd);
+        }
+    }
+    return isSynced;
 }
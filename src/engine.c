@@ -0,0 +1,1088 @@
+#include "engine.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cart.h"
+#include "change_solver.h"
+#include "constants.h"
+#include "data_structures.h"
+#include "journal.h"
+#include "perf_counters.h"
+#include "transaction_log.h"
+
+/**
+ * @brief Hashes an item name for the name index (FNV-1a).
+ * @param name The name to hash.
+ * @return The hash of the name.
+ */
+static unsigned int hashItemName(const char *name)
+{
+    unsigned int hash = 2166136261u;
+
+    for (const char *c = name; *c != '\0'; c++)
+    {
+        hash = (hash ^ (unsigned char) *c) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Hashes an item number for the item number index (Fibonacci hashing).
+ * @param itemNumber The item number to hash.
+ * @return The hash of the item number.
+ */
+static unsigned int hashItemNumber(int itemNumber)
+{
+    return (unsigned int) itemNumber * 2654435769u;
+}
+
+/**
+ * @brief Builds the indexes from item names and item numbers to inventory indexes.
+ *
+ * Both tables are kept at most half full so every probe sequence ends at an empty slot quickly.
+ * If two items share a name or a number, the first one is found, as with a scan of the
+ * inventory.
+ *
+ * @param machine The vending machine whose inventory is indexed.
+ * @return 1 if the indexes were built, 0 if memory ran out.
+ */
+static int buildItemIndexes(VendingMachine *machine)
+{
+    int slotCount = 8;
+    int isBuilt;
+
+    while (slotCount < 2 * machine->menuSize)
+    {
+        slotCount *= 2;
+    }
+
+    machine->itemSlotCount = slotCount;
+    machine->nameSlots = malloc((size_t) slotCount * sizeof(int));
+    machine->numberSlots = malloc((size_t) slotCount * sizeof(int));
+    isBuilt = (machine->nameSlots != NULL && machine->numberSlots != NULL);
+
+    if (isBuilt)
+    {
+        unsigned int mask = (unsigned int) slotCount - 1;
+
+        memset(machine->nameSlots, -1, (size_t) slotCount * sizeof(int));
+        memset(machine->numberSlots, -1, (size_t) slotCount * sizeof(int));
+        for (int i = 0; i < machine->menuSize; i++)
+        {
+            const VendingItem *item = &machine->items[i];
+            unsigned int slot = hashItemName(item->name) & mask;
+            int isDuplicate = 0;
+
+            while (!isDuplicate && machine->nameSlots[slot] != -1)
+            {
+                isDuplicate =
+                    (strcmp(machine->items[machine->nameSlots[slot]].name, item->name) == 0);
+                slot = (slot + 1) & mask;
+            }
+            if (!isDuplicate)
+            {
+                machine->nameSlots[slot] = i;
+            }
+
+            slot = hashItemNumber(item->itemNumber) & mask;
+            isDuplicate = 0;
+            while (!isDuplicate && machine->numberSlots[slot] != -1)
+            {
+                isDuplicate = (machine->items[machine->numberSlots[slot]].itemNumber ==
+                               item->itemNumber);
+                slot = (slot + 1) & mask;
+            }
+            if (!isDuplicate)
+            {
+                machine->numberSlots[slot] = i;
+            }
+        }
+    }
+    return isBuilt;
+}
+
+/**
+ * @brief Takes units from a stock or register count, unless too few are left.
+ *
+ * Several kiosks may sell from the same inventory and register at once, so counts are only ever
+ * lowered by compare-and-swap: a kiosk that loses a race sees the new count and tries again, and
+ * no two kiosks can take the same unit. Each item and each denomination has its own counter, so
+ * kiosks working on different ones never wait on each other.
+ *
+ * @param count The stock or register count to take from.
+ * @param quantity The number of units to take; must be positive.
+ * @return 1 if the units were taken, 0 if fewer than quantity are left.
+ */
+static int takeUnits(int *count, int quantity)
+{
+    int left = __atomic_load_n(count, __ATOMIC_ACQUIRE);
+    int isTaken = 0;
+
+    while (!isTaken && left >= quantity)
+    {
+        // A failed swap reloads left with the current count
+        isTaken = __atomic_compare_exchange_n(count, &left, left - quantity, 1, __ATOMIC_ACQ_REL,
+                                              __ATOMIC_ACQUIRE);
+    }
+    return isTaken;
+}
+
+/**
+ * @brief Adds units to a stock or register count, safely against kiosks taking from it at the
+ *        same time.
+ * @param count The stock or register count to add to.
+ * @param quantity The number of units.
+ */
+static void addUnits(int *count, int quantity)
+{
+    __atomic_fetch_add(count, quantity, __ATOMIC_ACQ_REL);
+}
+
+/**
+ * @brief Checks whether one item ranks below another in the sales report: fewer units sold, then
+ *        less revenue, then a later place in the inventory.
+ * @param sales The sales totals of the inventory.
+ * @param first The inventory index of the first item.
+ * @param second The inventory index of the second item.
+ * @return 1 if the first item ranks below the second, 0 otherwise.
+ */
+static int isOutsold(const ItemSales *sales, int first, int second)
+{
+    int isBelow;
+
+    if (sales[first].unitsSold != sales[second].unitsSold)
+    {
+        isBelow = (sales[first].unitsSold < sales[second].unitsSold);
+    }
+    else if (sales[first].revenue != sales[second].revenue)
+    {
+        isBelow = (sales[first].revenue < sales[second].revenue);
+    }
+    else
+    {
+        isBelow = (first > second);
+    }
+    return isBelow;
+}
+
+/**
+ * @brief Moves the root of a heap of inventory indices down until the lowest-ranked item is on
+ *        top again.
+ * @param sales The sales totals of the inventory.
+ * @param heap The heap of inventory indices; only the root may be out of place.
+ * @param count The number of indices in the heap.
+ */
+static void siftDownSeller(const ItemSales *sales, int heap[], int count)
+{
+    int parent = 0;
+    int isSettled = 0;
+
+    while (!isSettled)
+    {
+        int lowest = parent;
+        int left = 2 * parent + 1;
+        int right = left + 1;
+
+        if (left < count && isOutsold(sales, heap[left], heap[lowest]))
+        {
+            lowest = left;
+        }
+        if (right < count && isOutsold(sales, heap[right], heap[lowest]))
+        {
+            lowest = right;
+        }
+        isSettled = (lowest == parent);
+        if (!isSettled)
+        {
+            int swap = heap[parent];
+
+            heap[parent] = heap[lowest];
+            heap[lowest] = swap;
+            parent = lowest;
+        }
+    }
+}
+
+/**
+ * @brief Pays an amount out of the register, planning again whenever another thread claims
+ *        planned pieces first.
+ *
+ * The solver plans from a copy of the counts it reads up front, so it never reads counts that
+ * change under it; the claim then checks the plan against the live register.
+ *
+ * @param machine The vending machine whose cash register pays out.
+ * @param amount The amount to pay out, in centavos.
+ * @param isExactRequired 1 to take nothing unless the exact amount can be paid out, 0 to pay out
+ *                        as much of it as the register can.
+ * @return The breakdown that was taken out of the register, or nothing with status
+ *         ENGINE_INSUFFICIENT_CASH if other threads took planned pieces CHANGE_CLAIM_ATTEMPTS
+ *         times in a row.
+ */
+static ChangeResult takeChange(VendingMachine *machine, Cents amount, int isExactRequired)
+{
+    ChangeResult result;
+    int isSettled = 0;
+
+    for (int attempt = 0; !isSettled && attempt < CHANGE_CLAIM_ATTEMPTS; attempt++)
+    {
+        result = solveChange(machine->changeSolver, machine->cash, machine->registerSize, amount);
+        isSettled = (isExactRequired && result.status != ENGINE_OK) ||
+                    applyChange(machine, &result) == ENGINE_OK;
+    }
+
+    if (!isSettled)
+    {
+        memset(&result, 0, sizeof(result));  // Nothing was taken out
+        result.status = ENGINE_INSUFFICIENT_CASH;
+        result.remaining = amount;
+    }
+    return result;
+}
+
+/**
+ * @brief Records a change in the machine's journal, if it keeps one, under the order being
+ *        served.
+ * @param machine The vending machine that changed.
+ * @param type The kind of change.
+ * @param first The first operand of the change.
+ * @param second The second operand of the change, or 0.
+ */
+static void journalChange(const VendingMachine *machine, JournalType type, long long first,
+                          long long second)
+{
+    if (machine->journal != NULL)
+    {
+        appendJournal(machine->journal, type, machine->journalOrder, first, second);
+    }
+}
+
+/**
+ * @brief Waits until every change journaled so far is on disk, if the machine keeps a journal.
+ *        Called before a sale or cash out is reported done, so a crash right after it cannot
+ *        lose it.
+ * @param machine The vending machine whose journal is flushed.
+ */
+static void makeChangesDurable(const VendingMachine *machine)
+{
+    if (machine->journal != NULL)
+    {
+        flushJournal(machine->journal);
+    }
+}
+
+/**
+ * @brief Compacts the machine's journal if it has grown long enough. Only called as a console
+ *        order ends, so the compacted journal has no order in progress to describe; while socket
+ *        sessions are served other orders may still be open, so the server compacts instead once
+ *        none is.
+ * @param machine The vending machine whose journal is checked.
+ */
+static void compactJournalIfDue(VendingMachine *machine)
+{
+    if (machine->journal != NULL && machine->journalOrder == 0 &&
+        isJournalCompactionDue(machine->journal))
+    {
+        compactJournal(machine->journal, machine, NULL, 0);
+    }
+}
+
+/**
+ * @brief Sets up a vending machine over its inventory and cash register.
+ * @param machine The vending machine to set up.
+ * @param items The array of items sold by the machine.
+ * @param menuSize The number of items in the items array.
+ * @param cash The array of denominations held by the cash register.
+ * @param registerSize The number of denominations in the cash array.
+ * @return 1 if the machine is ready, 0 if the register is invalid or memory ran out. A machine
+ *         that is not ready must still be released with freeVendingMachine.
+ */
+int initVendingMachine(VendingMachine *machine, VendingItem items[], int menuSize,
+                       CashRegister cash[], int registerSize)
+{
+    int isReady = 1;
+
+    machine->items = items;
+    machine->menuSize = menuSize;
+    machine->sales = NULL;
+    machine->cash = cash;
+    machine->registerSize = registerSize;
+    machine->changeSolver = NULL;
+    machine->nameSlots = NULL;
+    machine->numberSlots = NULL;
+    machine->journal = NULL;  // Attached by the caller once the machine state is rebuilt
+    machine->journalOrder = 0;
+    machine->transactions = NULL;  // Attached by the caller if recent transactions are kept
+
+    // Index every register slot by its denomination; each needs a bucket of its own
+    memset(machine->denominationSlots, -1, sizeof(machine->denominationSlots));
+    for (int i = 0; i < registerSize && isReady; i++)
+    {
+        int bucket = DENOMINATION_HASH(cash[i].cashDenomination);
+
+        isReady = (cash[i].cashDenomination > 0 && machine->denominationSlots[bucket] == -1);
+        machine->denominationSlots[bucket] = (signed char) i;
+    }
+
+    if (isReady)
+    {
+        machine->changeSolver = createChangeSolver(cash, registerSize);  // Change-making tables
+        machine->sales = calloc((size_t) (menuSize > 0 ? menuSize : 1), sizeof(ItemSales));
+        isReady = (machine->changeSolver != NULL && machine->sales != NULL &&
+                   buildItemIndexes(machine));
+    }
+    return isReady;
+}
+
+/**
+ * @brief Releases the memory held by a vending machine set up with initVendingMachine.
+ * @param machine The vending machine to release. Its items and cash arrays are not freed.
+ */
+void freeVendingMachine(VendingMachine *machine)
+{
+    destroyChangeSolver(machine->changeSolver);
+    machine->changeSolver = NULL;
+    free(machine->sales);
+    machine->sales = NULL;
+    free(machine->nameSlots);
+    free(machine->numberSlots);
+    machine->nameSlots = NULL;
+    machine->numberSlots = NULL;
+}
+
+/**
+ * @brief Finds the inventory index of an item by its item number.
+ * @param machine The vending machine whose inventory is searched.
+ * @param itemNumber The item number shown to the user.
+ * @return The index of the item in the inventory, or -1 if no item has that number.
+ * @pre The machine must have been set up with initVendingMachine, which builds the number index.
+ */
+int findItemByNumber(const VendingMachine *machine, int itemNumber)
+{
+    int found = -1;
+    unsigned int mask = (unsigned int) machine->itemSlotCount - 1;
+    unsigned int slot = hashItemNumber(itemNumber) & mask;
+
+    // Probe from the number's home slot until the number or an empty slot is reached
+    while (found == -1 && machine->numberSlots[slot] != -1)
+    {
+        if (machine->items[machine->numberSlots[slot]].itemNumber == itemNumber)
+        {
+            found = machine->numberSlots[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+    return found;
+}
+
+/**
+ * @brief Finds the inventory index of an item by its name.
+ * @param machine The vending machine whose inventory is searched.
+ * @param name The name of the item.
+ * @return The index of the item in the inventory, or -1 if no item has that name.
+ * @pre The machine must have been set up with initVendingMachine, which builds the name index.
+ */
+int findItemByName(const VendingMachine *machine, const char *name)
+{
+    int found = -1;
+    unsigned int mask = (unsigned int) machine->itemSlotCount - 1;
+    unsigned int slot = hashItemName(name) & mask;
+
+    // Probe from the name's home slot until the name or an empty slot is reached
+    while (found == -1 && machine->nameSlots[slot] != -1)
+    {
+        if (strcmp(machine->items[machine->nameSlots[slot]].name, name) == 0)
+        {
+            found = machine->nameSlots[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+    return found;
+}
+
+/**
+ * @brief Finds the cash register slot holding a denomination.
+ * @param machine The vending machine whose cash register is searched.
+ * @param denomination The denomination to look for.
+ * @return The index of the denomination in the register, or -1 if the register does not hold it.
+ * @pre The machine must have been set up with initVendingMachine, which builds the index.
+ */
+int findDenominationSlot(const VendingMachine *machine, Cents denomination)
+{
+    int found = -1;
+
+    if (denomination > 0)
+    {
+        int slot = machine->denominationSlots[DENOMINATION_HASH(denomination)];
+
+        // Different amounts can share a bucket, so confirm the slot holds this denomination
+        if (slot != -1 && machine->cash[slot].cashDenomination == denomination)
+        {
+            found = slot;
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief Computes the total value of the cash held by the register.
+ * @param machine The vending machine whose cash register is totalled.
+ * @return The total value of every bill and coin in the register, in centavos.
+ */
+Cents registerTotal(const VendingMachine *machine)
+{
+    Cents total = 0;
+
+    for (int i = 0; i < machine->registerSize; i++)
+    {
+        total += machine->cash[i].cashDenomination * machine->cash[i].amountLeft;
+    }
+    return total;
+}
+
+/**
+ * @brief Checks if the inserted money is a valid denomination.
+ * @param machine The vending machine receiving the money.
+ * @param moneyInserted The amount of money to be checked for validity, in centavos.
+ * @return 1 if the denomination is valid, 0 otherwise.
+ * @pre The machine must have been set up with initVendingMachine.
+ */
+int isValidDenomination(const VendingMachine *machine, Cents moneyInserted)
+{
+    // The register holds a slot for exactly the denominations the machine accepts
+    return findDenominationSlot(machine, moneyInserted) != -1;
+}
+
+/**
+ * @brief Accepts one bill or coin from the user into the cash register.
+ * @param machine The vending machine receiving the money.
+ * @param denomination The value of the bill or coin inserted, in centavos.
+ * @param userMoney Pointer to the total money the user has inserted so far.
+ * @return ENGINE_OK if the money was accepted, ENGINE_INVALID_DENOMINATION otherwise.
+ */
+EngineStatus insertMoney(VendingMachine *machine, Cents denomination, Cents *userMoney)
+{
+    EngineStatus status = ENGINE_INVALID_DENOMINATION;
+    int slot = findDenominationSlot(machine, denomination);
+
+    if (slot != -1)
+    {
+        *userMoney += denomination;        // Credit the user with the inserted money
+        addUnits(&machine->cash[slot].amountLeft, 1);  // Keep the money in the register
+        markCashAdded(machine->changeSolver, machine->cash, slot);
+        journalChange(machine, JOURNAL_MONEY_INSERTED, denomination, 0);
+        status = ENGINE_OK;
+    }
+    return status;
+}
+
+/**
+ * @brief Adds one unit of an item to the user's cart if it is in stock and affordable.
+ * @param machine The vending machine selling the item.
+ * @param index The index of the item in the inventory.
+ * @param selection Pointer to the user's cart.
+ * @param userMoney The total money the user has inserted.
+ * @return The outcome of the request and the resulting cart total.
+ * @pre The selection structure should be initialized.
+ */
+CartResult addItemToCart(VendingMachine *machine, int index, UserSelection *selection,
+                         Cents userMoney)
+{
+    return addQuantityToCart(machine, index, selection, userMoney, 1);
+}
+
+/**
+ * @brief Adds several units of an item to the user's cart in one step, if they are all in stock
+ *        and affordable.
+ *
+ * Stock and funds are checked once for the whole quantity and the units are reserved with a
+ * single compare-and-swap, so a catering order of hundreds of units costs the same as one unit.
+ * Nothing is added unless every unit is; when too few are in stock, the result reports how many
+ * are, so the caller can offer those instead. Units of an item already in the cart are charged
+ * at the price its line was started at.
+ *
+ * @param machine The vending machine selling the item.
+ * @param index The index of the item in the inventory.
+ * @param selection Pointer to the user's cart.
+ * @param userMoney The total money the user has inserted.
+ * @param quantity The number of units to add.
+ * @return The outcome of the request and the resulting cart total.
+ * @pre The selection structure should be initialized.
+ */
+CartResult addQuantityToCart(VendingMachine *machine, int index, UserSelection *selection,
+                             Cents userMoney, int quantity)
+{
+    CartResult result;
+
+    result.status = ENGINE_OK;
+    result.itemPrice = 0;
+    result.totalCost = selection->totalItemCost;
+    result.shortfall = 0;
+    result.available = 0;
+
+    if (index < 0 || index >= machine->menuSize)
+    {
+        result.status = ENGINE_INVALID_ITEM;
+    }
+    else if (quantity <= 0)
+    {
+        result.status = ENGINE_INVALID_AMOUNT;
+    }
+    else
+    {
+        VendingItem *selectedItem = &machine->items[index];
+        Cents unitPrice = cartUnitPrice(selection, index, selectedItem->price);
+        Cents totalCost = selection->totalItemCost + unitPrice * quantity;
+
+        result.itemPrice = unitPrice;
+        result.available = __atomic_load_n(&selectedItem->stock, __ATOMIC_ACQUIRE);
+
+        if (result.available < quantity)
+        {
+            result.status = ENGINE_OUT_OF_STOCK;
+        }
+        else if (userMoney < totalCost)
+        {
+            result.status = ENGINE_INSUFFICIENT_FUNDS;
+            result.shortfall = totalCost - userMoney;  // Amount still needed for these units
+        }
+        else if (!takeUnits(&selectedItem->stock, quantity))
+        {
+            result.status = ENGINE_OUT_OF_STOCK;  // Another kiosk took the units first
+            result.available = __atomic_load_n(&selectedItem->stock, __ATOMIC_ACQUIRE);
+        }
+        else if (!updateSelectedItems(selection, selectedItem, index, quantity))
+        {
+            addUnits(&selectedItem->stock, quantity);  // The cart could not grow; put them back
+            result.status = ENGINE_CART_FULL;
+        }
+        else
+        {
+            journalChange(machine, JOURNAL_ITEM_RESERVED, selectedItem->itemNumber, quantity);
+            result.totalCost = selection->totalItemCost;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Updates the user's selection with the selected vending item, at the price of the item's
+ *        line if the cart has one and at the item's current price otherwise.
+ * @param selection Pointer to a UserSelection structure
+ * @param selectedItem Pointer to the VendingItem that the user has selected.
+ * @param index The inventory index of the selected item, which keys its cart line.
+ * @param quantity The number of units to add.
+ * @return 1 if the item was added, 0 if the cart needed a new line and memory ran out.
+ * @pre The selection structure should be initialized.
+ */
+int updateSelectedItems(UserSelection *selection, const VendingItem *selectedItem, int index,
+                        int quantity)
+{
+    PERF_START(start);
+    Cents unitPrice = cartUnitPrice(selection, index, selectedItem->price);  // Price charged
+    int isAdded = addCartUnits(selection, index, quantity, unitPrice);  // Add to line or start one
+
+    if (isAdded)
+    {
+        // Update the total cost of all selected items
+        selection->totalItemCost += unitPrice * quantity;
+    }
+    PERF_STOP(PERF_UPDATE_SELECTED_ITEMS, start);
+    return isAdded;
+}
+
+/**
+ * @brief Breaks an amount down into the fewest bills and coins available in the cash register.
+ *
+ * The register itself is not modified; pass the result to applyChange to take the cash out.
+ *
+ * @param machine The vending machine whose cash register is used.
+ * @param amount The amount to break down, in centavos.
+ * @return The breakdown, with status ENGINE_INEXACT_CHANGE and the uncovered remainder if the
+ *         register cannot make the exact amount.
+ * @pre The machine must have been set up with initVendingMachine.
+ */
+ChangeResult computeChange(const VendingMachine *machine, Cents amount)
+{
+    return solveChange(machine->changeSolver, machine->cash, machine->registerSize, amount);
+}
+
+/**
+ * @brief Claims the bills and coins of a breakdown from the cash register, all or nothing.
+ *
+ * Each denomination is claimed with a compare-and-swap on its count, so no lock is held and
+ * claims on different denominations never wait on each other. If another thread took planned
+ * pieces first, the denominations already claimed are put back and nothing is taken. Claimed
+ * pieces are out of the register until the reservation is committed with commitChange or
+ * handed back with abortChange.
+ *
+ * @param machine The vending machine whose cash register is claimed from.
+ * @param plan A breakdown for the same register, such as one produced by computeChange.
+ * @return ENGINE_OK if every piece was claimed, ENGINE_INSUFFICIENT_CASH if the register no
+ *         longer holds them.
+ */
+EngineStatus reserveChange(VendingMachine *machine, const ChangeResult *plan)
+{
+    EngineStatus status = ENGINE_OK;
+    int claimed = 0;  // Register slots claimed so far
+
+    while (claimed < machine->registerSize &&
+           (plan->counts[claimed] == 0 ||
+            takeUnits(&machine->cash[claimed].amountLeft, plan->counts[claimed])))
+    {
+        claimed++;
+    }
+
+    if (claimed < machine->registerSize)
+    {
+        for (int i = 0; i < claimed; i++)
+        {
+            addUnits(&machine->cash[i].amountLeft, plan->counts[i]);  // Undo the partial claim
+        }
+        markRegisterChanged(machine->changeSolver);  // The index may have been built without them
+        status = ENGINE_INSUFFICIENT_CASH;
+    }
+    return status;
+}
+
+/**
+ * @brief Completes a reservation made with reserveChange: the claimed pieces leave the machine.
+ * @param machine The vending machine whose cash register was claimed from.
+ * @param plan The breakdown that was reserved.
+ */
+void commitChange(VendingMachine *machine, const ChangeResult *plan)
+{
+    for (int i = 0; i < machine->registerSize; i++)
+    {
+        if (plan->counts[i] > 0)
+        {
+            journalChange(machine, JOURNAL_CASH_REMOVED, machine->cash[i].cashDenomination,
+                          plan->counts[i]);
+        }
+    }
+    markRegisterChanged(machine->changeSolver);
+}
+
+/**
+ * @brief Cancels a reservation made with reserveChange, putting the claimed pieces back.
+ * @param machine The vending machine whose cash register was claimed from.
+ * @param plan The breakdown that was reserved.
+ */
+void abortChange(VendingMachine *machine, const ChangeResult *plan)
+{
+    for (int i = 0; i < machine->registerSize; i++)
+    {
+        if (plan->counts[i] > 0)
+        {
+            addUnits(&machine->cash[i].amountLeft, plan->counts[i]);
+        }
+    }
+    markRegisterChanged(machine->changeSolver);  // The index may have been built without them
+}
+
+/**
+ * @brief Removes the bills and coins of a breakdown from the cash register.
+ * @param machine The vending machine whose cash register is updated.
+ * @param change A breakdown produced by computeChange for the same register.
+ * @return ENGINE_OK, or ENGINE_INSUFFICIENT_CASH with the register unchanged if another thread
+ *         took some of the pieces first.
+ */
+EngineStatus applyChange(VendingMachine *machine, const ChangeResult *change)
+{
+    EngineStatus status = reserveChange(machine, change);
+
+    if (status == ENGINE_OK)
+    {
+        commitChange(machine, change);
+    }
+    return status;
+}
+
+/**
+ * @brief Pays change out of the cash register, as much of the amount as it can make.
+ * @param machine The vending machine whose cash register pays out.
+ * @param amount The change to pay out, in centavos.
+ * @return The breakdown paid out, with status ENGINE_INEXACT_CHANGE and the unpaid remainder if
+ *         the register could not make the exact amount.
+ */
+ChangeResult payOutChange(VendingMachine *machine, Cents amount)
+{
+    return takeChange(machine, amount, 0);
+}
+
+/**
+ * @brief Checks whether the cash register can pay out an amount of change exactly.
+ * @param machine The vending machine whose cash register is checked.
+ * @param amount The change to pay out, in centavos.
+ * @return 1 if the exact amount can be paid out, 0 otherwise.
+ */
+int canMakeChange(const VendingMachine *machine, Cents amount)
+{
+    return isAmountReachable(machine->changeSolver, machine->cash, machine->registerSize, amount);
+}
+
+/**
+ * @brief Checks whether the machine should ask customers for exact change.
+ *
+ * The machine is in exact change only mode while there is some amount below EXACT_CHANGE_LIMIT
+ * that the cash register cannot pay out.
+ *
+ * @param machine The vending machine whose cash register is checked.
+ * @return 1 if the machine is in exact change only mode, 0 otherwise.
+ */
+int isExactChangeOnly(const VendingMachine *machine)
+{
+    return !isEveryAmountReachable(machine->changeSolver, machine->cash, EXACT_CHANGE_LIMIT);
+}
+
+/**
+ * @brief Tells the engine that the cash register counts were changed directly, without going
+ *        through an engine function.
+ * @param machine The vending machine whose cash register was changed.
+ */
+void noteRegisterChanged(VendingMachine *machine)
+{
+    markRegisterChanged(machine->changeSolver);
+}
+
+/**
+ * @brief Resets the user's order and related data when the order is canceled.
+ * @param userSelection Pointer to a UserSelection structure containing the user's current order.
+ * @param insertedMoney Pointer to the total amount of money inserted, in centavos.
+ * @param machine The vending machine whose inventory receives the returned stock.
+ * @pre The userSelection structure must contain valid data, including selected items, quantities,
+ *      and total cost.
+ */
+void resetOrderAfterCancel(UserSelection *userSelection, Cents *insertedMoney,
+                           VendingMachine *machine)
+{
+    const CartLine *lines = cartLines(userSelection);
+
+    // Loop through the user's selection to return stock for each item
+    for (int i = 0; i < userSelection->count; i++)
+    {
+        // Each line knows its inventory index, so the stock goes straight back
+        int index = lines[i].itemIndex;
+
+        addUnits(&machine->items[index].stock, lines[i].quantity);
+        if (machine->sales != NULL)
+        {
+            __atomic_fetch_add(&machine->sales[index].unitsCancelled,
+                               (long long) lines[i].quantity, __ATOMIC_RELAXED);
+        }
+    }
+
+    // Reset the user's order details
+    clearCart(userSelection);
+
+    // Reset the inserted money
+    *insertedMoney = 0;  // Set the inserted money to zero
+
+    journalChange(machine, JOURNAL_ORDER_CANCELLED, 0, 0);
+    compactJournalIfDue(machine);
+}
+
+/**
+ * @brief Resets the user's order details after confirming the transaction.
+ * @param userSelection Pointer to a UserSelection structure containing the user's selected items.
+ * @param insertedMoney Pointer to the total amount of money inserted, in centavos.
+ * @param machine The vending machine that sold the order.
+ * @pre The userSelection structure must contain valid data, including selected items, quantities,
+ *      and total cost.
+ */
+void resetOrderAfterConfirm(UserSelection *userSelection, Cents *insertedMoney,
+                            VendingMachine *machine)
+{
+    resetOrderAfterConfirmAt(userSelection, insertedMoney, machine, (long long) time(NULL));
+}
+
+/**
+ * @brief Resets the user's order details after confirming the transaction, recording the sale
+ *        at a given time. Used to replay sales from the journal at the time they were made.
+ *
+ * Each line of the order is added to the running totals of its item, so keeping the sales report
+ * current costs a few additions per line and the report never reads past orders. Revenue is
+ * booked from each line's subtotal, which is what the customer paid even if the item was
+ * repriced while the order was open.
+ *
+ * @param userSelection Pointer to a UserSelection structure containing the user's selected items.
+ * @param insertedMoney Pointer to the total amount of money inserted, in centavos.
+ * @param machine The vending machine that sold the order.
+ * @param soldTime Seconds since the epoch when the order was sold, or 0 if unknown.
+ * @pre The userSelection structure must contain valid data, including selected items, quantities,
+ *      and total cost.
+ */
+void resetOrderAfterConfirmAt(UserSelection *userSelection, Cents *insertedMoney,
+                              VendingMachine *machine, long long soldTime)
+{
+    const CartLine *lines = cartLines(userSelection);
+
+    // Add every line to the sales totals of its item; kiosks may confirm orders at the same time
+    for (int i = 0; i < userSelection->count && machine->sales != NULL; i++)
+    {
+        ItemSales *sales = &machine->sales[lines[i].itemIndex];
+
+        __atomic_fetch_add(&sales->unitsSold, (long long) lines[i].quantity, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&sales->revenue, cartLineSubtotal(userSelection, i),
+                           __ATOMIC_RELAXED);
+        if (soldTime > 0)
+        {
+            __atomic_store_n(&sales->lastSoldTime, soldTime, __ATOMIC_RELAXED);
+        }
+    }
+
+    // Reset the user's order details after confirming the transaction
+    clearCart(userSelection);
+    *insertedMoney = 0;  // Set the inserted money to zero
+
+    journalChange(machine, JOURNAL_ORDER_CONFIRMED, soldTime, 0);
+    makeChangesDurable(machine);  // The items are dispensed once this returns
+    compactJournalIfDue(machine);
+}
+
+/**
+ * @brief Records a finished order in the machine's log of recent transactions, if it keeps one.
+ *
+ * Call it once per order, after the change is paid out and before the order is reset. The record
+ * is filled in on the stack and copied into the log, so nothing is allocated.
+ *
+ * @param machine The vending machine that served the order.
+ * @param selection The order, still holding its cart.
+ * @param moneyIn The money inserted for the order, in centavos.
+ * @param change The change or refund paid out for the order.
+ * @param outcome Whether the order was confirmed or canceled.
+ */
+void logTransaction(VendingMachine *machine, const UserSelection *selection, Cents moneyIn,
+                    const ChangeResult *change, TransactionOutcome outcome)
+{
+    if (machine->transactions != NULL)
+    {
+        const CartLine *lines = cartLines(selection);
+        TransactionRecord record;
+
+        memset(&record, 0, sizeof(record));
+        record.time = (int64_t) time(NULL);
+        record.moneyIn = moneyIn;
+        record.totalCost = selection->totalItemCost;
+        record.changeShort = (change->status == ENGINE_OK) ? 0 : change->remaining;
+        record.lineCount = selection->count;
+        record.outcome = (uint8_t) outcome;
+        for (int i = 0; i < selection->count; i++)
+        {
+            if (i < TRANSACTION_MAX_LINES)
+            {
+                record.itemNumbers[i] = machine->items[lines[i].itemIndex].itemNumber;
+                record.quantities[i] = lines[i].quantity;
+            }
+            else
+            {
+                record.otherUnits += lines[i].quantity;
+            }
+        }
+        for (int slot = 0; slot < machine->registerSize; slot++)
+        {
+            record.dispensed[slot] = (uint16_t) change->counts[slot];
+            record.changeGiven += change->counts[slot] * machine->cash[slot].cashDenomination;
+        }
+        appendTransaction(machine->transactions, &record);
+    }
+}
+
+/**
+ * @brief Sets the price of an item.
+ * @param machine The vending machine whose inventory is updated.
+ * @param index The index of the item in the inventory.
+ * @param newPrice The new price in centavos.
+ * @return ENGINE_OK, ENGINE_INVALID_ITEM or ENGINE_INVALID_AMOUNT.
+ */
+EngineStatus setItemPrice(VendingMachine *machine, int index, Cents newPrice)
+{
+    EngineStatus status = ENGINE_OK;
+
+    if (index < 0 || index >= machine->menuSize)
+    {
+        status = ENGINE_INVALID_ITEM;
+    }
+    else if (newPrice <= 0)
+    {
+        status = ENGINE_INVALID_AMOUNT;
+    }
+    else
+    {
+        machine->items[index].price = newPrice;
+        journalChange(machine, JOURNAL_PRICE_CHANGED, machine->items[index].itemNumber, newPrice);
+    }
+    return status;
+}
+
+/**
+ * @brief Adds stock to an item.
+ * @param machine The vending machine whose inventory is updated.
+ * @param index The index of the item in the inventory.
+ * @param quantity The number of units to add.
+ * @return ENGINE_OK, ENGINE_INVALID_ITEM or ENGINE_INVALID_AMOUNT.
+ */
+EngineStatus restockItem(VendingMachine *machine, int index, int quantity)
+{
+    EngineStatus status = ENGINE_OK;
+
+    if (index < 0 || index >= machine->menuSize)
+    {
+        status = ENGINE_INVALID_ITEM;
+    }
+    else if (quantity <= 0)
+    {
+        status = ENGINE_INVALID_AMOUNT;
+    }
+    else
+    {
+        addUnits(&machine->items[index].stock, quantity);
+        journalChange(machine, JOURNAL_ITEM_RESTOCKED, machine->items[index].itemNumber, quantity);
+    }
+    return status;
+}
+
+/**
+ * @brief Adds bills or coins of one denomination to the cash register.
+ * @param machine The vending machine whose cash register is updated.
+ * @param denomination The denomination to restock, in centavos.
+ * @param quantity The number of bills or coins to add.
+ * @return ENGINE_OK, ENGINE_INVALID_DENOMINATION or ENGINE_INVALID_AMOUNT.
+ */
+EngineStatus restockRegister(VendingMachine *machine, Cents denomination, int quantity)
+{
+    EngineStatus status = ENGINE_OK;
+    int slot = findDenominationSlot(machine, denomination);
+
+    if (slot == -1)
+    {
+        status = ENGINE_INVALID_DENOMINATION;
+    }
+    else if (quantity <= 0)
+    {
+        status = ENGINE_INVALID_AMOUNT;
+    }
+    else
+    {
+        addUnits(&machine->cash[slot].amountLeft, quantity);
+        markRegisterChanged(machine->changeSolver);  // Rebuilt once instead of per piece
+        journalChange(machine, JOURNAL_CASH_RESTOCKED, denomination, quantity);
+    }
+    return status;
+}
+
+/**
+ * @brief Takes an exact amount out of the cash register.
+ * @param machine The vending machine whose cash register is emptied.
+ * @param amount The amount to take out, in centavos.
+ * @return The breakdown of bills and coins taken out. The register is only changed when the
+ *         status is ENGINE_OK.
+ */
+ChangeResult cashOutAmount(VendingMachine *machine, Cents amount)
+{
+    ChangeResult result;
+
+    if (amount <= 0)
+    {
+        memset(&result, 0, sizeof(result));
+        result.status = ENGINE_INVALID_AMOUNT;
+        result.remaining = amount;
+    }
+    else
+    {
+        result = takeChange(machine, amount, 1);  // Only take the cash out if the amount is exact
+        if (result.status == ENGINE_OK)
+        {
+            makeChangesDurable(machine);
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Takes a number of bills or coins of one denomination out of the cash register.
+ * @param machine The vending machine whose cash register is emptied.
+ * @param denomination The denomination to take out, in centavos.
+ * @param quantity The number of bills or coins to take out.
+ * @return ENGINE_OK, ENGINE_INVALID_DENOMINATION, ENGINE_INVALID_AMOUNT or
+ *         ENGINE_INSUFFICIENT_CASH.
+ */
+EngineStatus cashOutDenomination(VendingMachine *machine, Cents denomination, int quantity)
+{
+    EngineStatus status = ENGINE_OK;
+    int slot = findDenominationSlot(machine, denomination);
+
+    if (slot == -1)
+    {
+        status = ENGINE_INVALID_DENOMINATION;
+    }
+    else if (quantity <= 0)
+    {
+        status = ENGINE_INVALID_AMOUNT;
+    }
+    else if (!takeUnits(&machine->cash[slot].amountLeft, quantity))
+    {
+        status = ENGINE_INSUFFICIENT_CASH;
+    }
+    else
+    {
+        markRegisterChanged(machine->changeSolver);
+        journalChange(machine, JOURNAL_CASH_REMOVED, denomination, quantity);
+        makeChangesDurable(machine);
+    }
+    return status;
+}
+
+/**
+ * @brief Finds the best-selling items, best first.
+ *
+ * The running sales totals are read once and the best items kept in a heap of at most limit
+ * entries, so the report takes one pass over the inventory and never sorts all of it.
+ *
+ * @param machine The vending machine whose sales are ranked.
+ * @param indices Receives the inventory indices of the best sellers; must hold limit entries.
+ * @param limit The most items to return.
+ * @return The number of indices written: at most limit, and only items that have sold.
+ */
+int findTopSellers(const VendingMachine *machine, int indices[], int limit)
+{
+    const ItemSales *sales = machine->sales;
+    int count = 0;
+
+    // Keep the best items seen so far in a heap with the lowest-ranked of them on top
+    for (int i = 0; sales != NULL && limit > 0 && i < machine->menuSize; i++)
+    {
+        if (sales[i].unitsSold > 0 && count < limit)
+        {
+            int child = count++;
+
+            indices[child] = i;
+            while (child > 0 && isOutsold(sales, indices[child], indices[(child - 1) / 2]))
+            {
+                int parent = (child - 1) / 2;
+                int swap = indices[parent];
+
+                indices[parent] = indices[child];
+                indices[child] = swap;
+                child = parent;
+            }
+        }
+        else if (sales[i].unitsSold > 0 && isOutsold(sales, indices[0], i))
+        {
+            indices[0] = i;
+            siftDownSeller(sales, indices, count);
+        }
+    }
+
+    // Move the lowest-ranked item to the back until the heap is sorted best first
+    for (int last = count - 1; last > 0; last--)
+    {
+        int swap = indices[0];
+
+        indices[0] = indices[last];
+        indices[last] = swap;
+        siftDownSeller(sales, indices, last);
+    }
+    return count;
+}
@@ -0,0 +1,913 @@
+#define _POSIX_C_SOURCE 200809L  // Expose clock_gettime and sysconf
+
+#include "fleet_simulator.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cart.h"
+#include "change_solver.h"
+#include "constants.h"
+#include "data_structures.h"
+#include "engine.h"
+#include "money.h"
+
+#define FLEET_ROW_ALIGN 16       // Ints per cache line; each machine's rows start on a new line
+#define FLEET_MAX_THREADS 256    // Most worker threads a simulation may use
+#define FLEET_MIN_BILL 2000      // Smallest denomination customers pay with (a 20 PHP bill)
+#define FLEET_MAX_ORDER_ITEMS 3  // Most units a simulated customer asks for
+#define FLEET_RESTOCK_LEVEL 2    // Units left of an item when it is refilled to its starting stock
+#define KIOSK_CANCEL_ODDS 4       // One kiosk order in this many is canceled
+#define KIOSK_MAX_BILLS 2         // Most bills a kiosk customer inserts
+#define KIOSK_STAFF_SHARE 8       // The staff services the register once per this many sessions
+#define KIOSK_REFILL_PIECES 10    // Coins of one denomination the staff puts in at a time
+#define KIOSK_LOW_STOCK 10        // The staff refills an item once its stock falls below this
+#define KIOSK_REFILL_UNITS 40     // Units of one item the staff puts in at a time
+#define KIOSK_MAX_CASH_OUT 20000  // Largest amount the staff takes out at a time (200 PHP)
+
+/**
+ * @brief State of every machine of the fleet, stored as struct-of-arrays.
+ *
+ * The fields a sale touches (stock and coin counts) live in flat arrays with one row per
+ * machine, padded to whole cache lines, so a machine's hot state is packed together and no two
+ * threads ever write the same cache line. Names and prices are the same for every machine and
+ * are shared from one catalog.
+ */
+typedef struct
+{
+    int machineCount;                        // Number of machines in the fleet
+    int itemCount;                           // Number of items each machine sells
+    int registerSize;                        // Number of denominations in each register
+    int stockStride;                         // Ints between the stock rows of adjacent machines
+    int cashStride;                          // Ints between the coin rows of adjacent machines
+    const VendingItem *catalog;              // Numbers, names and prices shared by every machine
+    Cents denominations[MAX_DENOMINATIONS];  // Denomination of each register slot
+    int startingCoins[MAX_DENOMINATIONS];    // Pieces of each slot a machine starts with
+    int billSlots[MAX_DENOMINATIONS];        // Register slots customers pay with
+    int billCount;                           // Number of slots in billSlots
+    int *stock;                              // stock[machine * stockStride + item]
+    int *coins;                              // coins[machine * cashStride + slot]
+    Cents *credit;                           // Money inserted for each machine's active order
+    UserSelection *selections;               // Active order of each machine
+} FleetState;
+
+/**
+ * @brief Counters collected by one worker thread.
+ */
+typedef struct
+{
+    long sessions;        // Customer sessions run
+    long sales;           // Orders confirmed and paid for
+    long itemsSold;       // Units handed out by confirmed orders
+    Cents revenue;        // Money kept for confirmed orders
+    long stockOuts;       // Units requested while the item was out of stock
+    long walkAways;       // Sessions that ended with nothing in stock to buy
+    long changeFailures;  // Orders canceled because the change could not be made exactly
+    long restocks;        // Times an item ran low and was refilled
+    long unitsRestocked;  // Units put back on the shelves by the refills
+    Cents cashCollected;  // Bills taken out less coins put in when the register was serviced
+} FleetStats;
+
+/**
+ * @brief One worker thread and the contiguous range of machines it simulates.
+ */
+typedef struct
+{
+    FleetState *fleet;       // The fleet being simulated
+    int isThreaded;          // 1 if the worker runs on a thread of its own that must be joined
+    int firstMachine;        // First machine of the worker's range
+    int lastMachine;         // One past the last machine of the range
+    int sessionsPerMachine;  // Sessions run on every machine of the range
+    unsigned long long rng;  // State of the worker's random number generator
+    FleetStats stats;        // Counters, written once when the worker finishes
+} FleetWorker;
+
+/**
+ * @brief Counters collected by one kiosk.
+ */
+typedef struct
+{
+    long sessions;        // Customer sessions run
+    long sales;           // Orders confirmed
+    long unitsSold;       // Units handed out by confirmed orders
+    long stockOuts;       // Units refused because the item was sold out
+    long cancelled;       // Orders canceled, returning their units to the shared stock
+    long changeFailures;  // Orders canceled because the register could not make the change
+    long changeRetries;   // Change plans lost to another thread and made again
+    Cents cashIn;         // Bills customers put into the register
+    Cents cashOut;        // Change and refunds paid out of the register
+    Cents unrefunded;     // Refunds the register could not make exactly
+} KioskStats;
+
+/**
+ * @brief One kiosk: a front panel on its own thread selling from the shared inventory and
+ *        register.
+ */
+typedef struct
+{
+    VendingMachine *machine;  // The machine whose inventory and register every kiosk uses
+    const int *billSlots;     // Register slots customers pay with
+    int billCount;            // Number of slots in billSlots
+    int isThreaded;           // 1 if the kiosk runs on a thread of its own that must be joined
+    int sessions;             // Sessions the kiosk runs
+    long *sessionsStarted;    // Sessions started by all kiosks, which paces the staff
+    unsigned long long rng;   // State of the kiosk's random number generator
+    KioskStats stats;         // Counters, written once when the kiosk finishes
+} KioskWorker;
+
+/**
+ * @brief The staff member who empties and refills the register and the shelves while the kiosks
+ *        sell.
+ */
+typedef struct
+{
+    VendingMachine *machine;  // The machine whose register is serviced
+    int isThreaded;           // 1 if the staff runs on a thread of its own that must be joined
+    int operations;           // Cash-outs and refills to perform
+    long sessionsStarted;     // Sessions started by all kiosks; one visit per KIOSK_STAFF_SHARE
+    unsigned long long rng;   // State of the staff's random number generator
+    Cents cashedOut;          // Cash taken out of the register
+    Cents restocked;          // Coins put into the register
+    long unitsRestocked;      // Units put on the shelves
+    long failedCashOuts;      // Cash-outs the register could not make exactly
+} KioskStaff;
+
+/**
+ * @brief Returns the current monotonic time in nanoseconds.
+ * @return Nanoseconds elapsed since an arbitrary fixed point.
+ */
+static long long currentTimeNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long) now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * @brief Draws the next number from a worker's random number generator (xorshift64*).
+ * @param state The generator state; must not be 0.
+ * @return A pseudo-random 32-bit number.
+ */
+static unsigned int nextRandom(unsigned long long *state)
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return (unsigned int) ((*state * 2685821657736338717ull) >> 32);
+}
+
+/**
+ * @brief Rounds a row length up to whole cache lines.
+ * @param length The number of ints in the row.
+ * @return The padded length.
+ */
+static int paddedRow(int length)
+{
+    return (length + FLEET_ROW_ALIGN - 1) / FLEET_ROW_ALIGN * FLEET_ROW_ALIGN;
+}
+
+/**
+ * @brief Empties a machine's active order.
+ * @param selection The order to empty.
+ * @param credit The money inserted for the order.
+ */
+static void clearOrder(UserSelection *selection, Cents *credit)
+{
+    clearCart(selection);
+    *credit = 0;
+}
+
+/**
+ * @brief Lists the register slots simulated customers pay with.
+ * @param machine The machine whose register is searched.
+ * @param billSlots Receives the slots holding bills, or every slot if the register has no bills.
+ * @return The number of slots listed.
+ */
+static int findBillSlots(const VendingMachine *machine, int billSlots[])
+{
+    int billCount = 0;
+
+    for (int slot = 0; slot < machine->registerSize; slot++)
+    {
+        if (machine->cash[slot].cashDenomination >= FLEET_MIN_BILL)
+        {
+            billSlots[billCount++] = slot;
+        }
+    }
+    if (billCount == 0)  // A register without bills is paid with whatever it accepts
+    {
+        for (int slot = 0; slot < machine->registerSize; slot++)
+        {
+            billSlots[slot] = slot;
+        }
+        billCount = machine->registerSize;
+    }
+    return billCount;
+}
+
+/**
+ * @brief Services a machine the way the route driver would before the next customer arrives:
+ *        the items an order took low are refilled to their starting stock and, on the same
+ *        visit, the register is set back to its starting float.
+ * @param fleet The fleet the machine belongs to.
+ * @param stock The machine's stock row.
+ * @param coins The machine's coin row.
+ * @param selection The order just sold.
+ * @param stats The worker's counters.
+ */
+static void serviceMachine(const FleetState *fleet, int *stock, int *coins,
+                           const UserSelection *selection, FleetStats *stats)
+{
+    const CartLine *lines = cartLines(selection);
+    int isVisited = 0;
+
+    for (int line = 0; line < selection->count; line++)
+    {
+        int item = lines[line].itemIndex;
+        int startingStock = fleet->catalog[item].stock;
+
+        if (stock[item] <= FLEET_RESTOCK_LEVEL && stock[item] < startingStock)
+        {
+            stats->restocks++;
+            stats->unitsRestocked += startingStock - stock[item];
+            stock[item] = startingStock;
+            isVisited = 1;
+        }
+    }
+    for (int slot = 0; isVisited && slot < fleet->registerSize; slot++)
+    {
+        int surplus = coins[slot] - fleet->startingCoins[slot];  // Negative when coins are added
+
+        stats->cashCollected += surplus * fleet->denominations[slot];
+        coins[slot] = fleet->startingCoins[slot];
+    }
+}
+
+/**
+ * @brief Simulates one customer at one machine: choose items, pay, take the change.
+ *
+ * If the register cannot make the change exactly, the order is canceled: the stock is returned
+ * and the money the customer inserted is handed back. A sale that takes an item low brings the
+ * route driver.
+ *
+ * @param fleet The fleet the machine belongs to.
+ * @param machine The index of the machine.
+ * @param solver The worker's change solver, built for the fleet's denominations.
+ * @param scratch The worker's register view used to solve change, holding the denominations.
+ * @param rng The worker's random number generator.
+ * @param stats The worker's counters.
+ */
+static void runFleetSession(FleetState *fleet, int machine, ChangeSolver *solver,
+                            CashRegister scratch[], unsigned long long *rng, FleetStats *stats)
+{
+    int *stock = &fleet->stock[(size_t) machine * fleet->stockStride];
+    int *coins = &fleet->coins[(size_t) machine * fleet->cashStride];
+    UserSelection *selection = &fleet->selections[machine];
+    Cents *credit = &fleet->credit[machine];
+    int inserted[MAX_DENOMINATIONS] = {0};  // Money the customer put in, per register slot
+    int wanted = 1 + (int) (nextRandom(rng) % FLEET_MAX_ORDER_ITEMS);
+
+    stats->sessions++;
+
+    // Choose items, reserving each unit that is in stock
+    for (int unit = 0; unit < wanted; unit++)
+    {
+        int item = (int) (nextRandom(rng) % (unsigned int) fleet->itemCount);
+
+        if (stock[item] > 0 && updateSelectedItems(selection, &fleet->catalog[item], item, 1))
+        {
+            stock[item]--;
+        }
+        else
+        {
+            stats->stockOuts++;
+        }
+    }
+
+    if (selection->count == 0)
+    {
+        stats->walkAways++;
+    }
+    else
+    {
+        // Half the customers pay the exact amount where they can, which keeps coins flowing in;
+        // the rest, and any shortfall, is paid with random bills
+        int paysExact = (int) (nextRandom(rng) & 1u);
+        for (int slot = 0; paysExact && slot < fleet->registerSize; slot++)
+        {
+            Cents denomination = fleet->denominations[slot];
+            int pieces = (int) ((selection->totalItemCost - *credit) / denomination);
+
+            *credit += pieces * denomination;
+            coins[slot] += pieces;
+            inserted[slot] += pieces;
+        }
+        while (*credit < selection->totalItemCost)
+        {
+            int slot = fleet->billSlots[nextRandom(rng) % (unsigned int) fleet->billCount];
+
+            *credit += fleet->denominations[slot];
+            coins[slot]++;
+            inserted[slot]++;
+        }
+
+        for (int slot = 0; slot < fleet->registerSize; slot++)
+        {
+            scratch[slot].amountLeft = coins[slot];
+        }
+        ChangeResult change =
+            solveChange(solver, scratch, fleet->registerSize, *credit - selection->totalItemCost);
+
+        if (change.status == ENGINE_OK)
+        {
+            for (int slot = 0; slot < fleet->registerSize; slot++)
+            {
+                coins[slot] -= change.counts[slot];
+            }
+            for (int line = 0; line < selection->count; line++)
+            {
+                stats->itemsSold += cartLines(selection)[line].quantity;
+            }
+            stats->sales++;
+            stats->revenue += selection->totalItemCost;
+            serviceMachine(fleet, stock, coins, selection, stats);
+        }
+        else
+        {
+            // Hand the money back and put the items back on the shelf
+            for (int slot = 0; slot < fleet->registerSize; slot++)
+            {
+                coins[slot] -= inserted[slot];
+            }
+            for (int line = 0; line < selection->count; line++)
+            {
+                stock[cartLines(selection)[line].itemIndex] += cartLines(selection)[line].quantity;
+            }
+            stats->changeFailures++;
+        }
+    }
+    clearOrder(selection, credit);
+}
+
+/**
+ * @brief Body of a worker thread: runs every session of its range of machines, one round of
+ *        customers across the range at a time.
+ * @param argument The worker.
+ * @return NULL.
+ */
+static void *runFleetWorker(void *argument)
+{
+    FleetWorker *worker = argument;
+    FleetState *fleet = worker->fleet;
+    FleetStats stats = {0};  // Kept on the worker's own stack while it runs
+    CashRegister scratch[MAX_DENOMINATIONS];
+
+    for (int slot = 0; slot < fleet->registerSize; slot++)
+    {
+        scratch[slot].cashDenomination = fleet->denominations[slot];
+        scratch[slot].amountLeft = 0;
+    }
+
+    // Each thread gets a solver of its own, since the solver's tables double as scratch space
+    ChangeSolver *solver = createChangeSolver(scratch, fleet->registerSize);
+    if (solver != NULL)
+    {
+        for (int round = 0; round < worker->sessionsPerMachine; round++)
+        {
+            for (int machine = worker->firstMachine; machine < worker->lastMachine; machine++)
+            {
+                runFleetSession(fleet, machine, solver, scratch, &worker->rng, &stats);
+            }
+        }
+        destroyChangeSolver(solver);
+    }
+
+    worker->stats = stats;
+    return NULL;
+}
+
+/**
+ * @brief Releases the arrays of a fleet.
+ * @param fleet The fleet to release.
+ */
+static void freeFleet(FleetState *fleet)
+{
+    free(fleet->stock);
+    free(fleet->coins);
+    free(fleet->credit);
+    free(fleet->selections);
+}
+
+/**
+ * @brief Simulates a fleet of identical machines on several threads and reports the totals.
+ *
+ * Every machine starts with the inventory and cash register of the given machine. The machines
+ * are split into contiguous ranges, one per thread, and each thread runs the same number of
+ * random customer sessions on each of its machines. Once sales take an item down to
+ * FLEET_RESTOCK_LEVEL units, the machine is refilled and its register set back to the starting
+ * float, so a long simulation keeps counting real purchases rather than customers walking away
+ * from sold-out machines or change the register can no longer make.
+ *
+ * @param machine The machine every fleet member is copied from; it is not modified.
+ * @param machineCount The number of machines in the fleet.
+ * @param sessionsPerMachine The number of customer sessions run on each machine.
+ * @param threadCount The number of worker threads, or 0 for one per processor; capped at the
+ *        number of machines.
+ * @return 0 on success, 1 if the arguments are invalid or memory ran out.
+ */
+int runFleetSimulation(const VendingMachine *machine, int machineCount, int sessionsPerMachine,
+                       int threadCount)
+{
+    FleetState fleet;
+    FleetWorker *workers = NULL;
+    pthread_t *threads = NULL;
+
+    if (threadCount == 0)
+    {
+        threadCount = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (machineCount < 1 || sessionsPerMachine < 1 || threadCount < 1 || machine->menuSize < 1)
+    {
+        printf("The fleet needs at least one machine, session, thread and item.\n");
+        return 1;
+    }
+    if (threadCount > machineCount)
+    {
+        threadCount = machineCount;
+    }
+    if (threadCount > FLEET_MAX_THREADS)
+    {
+        threadCount = FLEET_MAX_THREADS;
+    }
+
+    // Lay out the hot per-machine state as padded rows, one per machine
+    memset(&fleet, 0, sizeof(fleet));
+    fleet.machineCount = machineCount;
+    fleet.itemCount = machine->menuSize;
+    fleet.registerSize = machine->registerSize;
+    fleet.stockStride = paddedRow(machine->menuSize);
+    fleet.cashStride = paddedRow(machine->registerSize);
+    fleet.catalog = machine->items;
+    for (int slot = 0; slot < machine->registerSize; slot++)
+    {
+        fleet.denominations[slot] = machine->cash[slot].cashDenomination;
+        fleet.startingCoins[slot] = machine->cash[slot].amountLeft;
+    }
+    fleet.billCount = findBillSlots(machine, fleet.billSlots);
+    fleet.stock = malloc((size_t) machineCount * fleet.stockStride * sizeof(int));
+    fleet.coins = malloc((size_t) machineCount * fleet.cashStride * sizeof(int));
+    fleet.credit = calloc((size_t) machineCount, sizeof(Cents));
+    fleet.selections = calloc((size_t) machineCount, sizeof(UserSelection));
+    workers = calloc((size_t) threadCount, sizeof(FleetWorker));
+    threads = malloc((size_t) threadCount * sizeof(pthread_t));
+    if (fleet.stock == NULL || fleet.coins == NULL || fleet.credit == NULL ||
+        fleet.selections == NULL || workers == NULL || threads == NULL)
+    {
+        fprintf(stderr, "Not enough memory to simulate %d machines.\n", machineCount);
+        freeFleet(&fleet);
+        free(workers);
+        free(threads);
+        return 1;
+    }
+
+    for (int m = 0; m < machineCount; m++)
+    {
+        int *stock = &fleet.stock[(size_t) m * fleet.stockStride];
+        int *coins = &fleet.coins[(size_t) m * fleet.cashStride];
+
+        for (int i = 0; i < fleet.itemCount; i++)
+        {
+            stock[i] = machine->items[i].stock;
+        }
+        for (int slot = 0; slot < fleet.registerSize; slot++)
+        {
+            coins[slot] = fleet.startingCoins[slot];
+        }
+    }
+
+    // Split the machines into contiguous ranges, one per thread
+    int started = 0;
+    long long startTime = currentTimeNs();
+    for (int t = 0; t < threadCount; t++)
+    {
+        workers[t].fleet = &fleet;
+        workers[t].firstMachine = (int) ((long long) machineCount * t / threadCount);
+        workers[t].lastMachine = (int) ((long long) machineCount * (t + 1) / threadCount);
+        workers[t].sessionsPerMachine = sessionsPerMachine;
+        workers[t].rng = 0x9E3779B97F4A7C15ull * (unsigned long long) (t + 1);
+        workers[t].isThreaded =
+            (pthread_create(&threads[t], NULL, runFleetWorker, &workers[t]) == 0);
+        if (workers[t].isThreaded)
+        {
+            started++;
+        }
+        else
+        {
+            runFleetWorker(&workers[t]);  // Run the range here rather than skip it
+        }
+    }
+    for (int t = 0; t < threadCount; t++)
+    {
+        if (workers[t].isThreaded)
+        {
+            pthread_join(threads[t], NULL);
+        }
+    }
+    long long elapsed = currentTimeNs() - startTime;
+
+    // Add up the workers' counters and what is left in the machines
+    FleetStats total = {0};
+    long soldOutSlots = 0;
+    Cents fleetCash = 0;
+    for (int t = 0; t < threadCount; t++)
+    {
+        total.sessions += workers[t].stats.sessions;
+        total.sales += workers[t].stats.sales;
+        total.itemsSold += workers[t].stats.itemsSold;
+        total.revenue += workers[t].stats.revenue;
+        total.stockOuts += workers[t].stats.stockOuts;
+        total.walkAways += workers[t].stats.walkAways;
+        total.changeFailures += workers[t].stats.changeFailures;
+        total.restocks += workers[t].stats.restocks;
+        total.unitsRestocked += workers[t].stats.unitsRestocked;
+        total.cashCollected += workers[t].stats.cashCollected;
+    }
+    for (int m = 0; m < machineCount; m++)
+    {
+        for (int i = 0; i < fleet.itemCount; i++)
+        {
+            soldOutSlots += (fleet.stock[(size_t) m * fleet.stockStride + i] == 0);
+        }
+        for (int slot = 0; slot < fleet.registerSize; slot++)
+        {
+            fleetCash +=
+                fleet.coins[(size_t) m * fleet.cashStride + slot] * fleet.denominations[slot];
+        }
+    }
+
+    char amountText[MONEY_TEXT_SIZE];
+    double seconds = elapsed / 1e9;
+    printf(SEPARATOR "\nFleet Simulation Report: %d machines x %d sessions (%d threads)\n" SEPARATOR
+           "\n",
+           machineCount, sessionsPerMachine, started > 0 ? started : 1);
+    printf("%-22s: %ld\n", "Sessions", total.sessions);
+    printf("%-22s: %ld\n", "Sales", total.sales);
+    printf("%-22s: %ld\n", "Items Sold", total.itemsSold);
+    printf("%-22s: %s PHP\n", "Revenue", formatCents(total.revenue, amountText));
+    printf("%-22s: %ld\n", "Stock-Outs", total.stockOuts);
+    printf("%-22s: %ld\n", "Walk-Aways", total.walkAways);
+    printf("%-22s: %ld\n", "Change Failures", total.changeFailures);
+    printf("%-22s: %ld (%ld units)\n", "Restocks", total.restocks, total.unitsRestocked);
+    printf("%-22s: %s PHP\n", "Cash Collected", formatCents(total.cashCollected, amountText));
+    printf("%-22s: %ld of %ld\n", "Sold-Out Slots", soldOutSlots,
+           (long) machineCount * fleet.itemCount);
+    printf("%-22s: %s PHP\n", "Cash in Fleet", formatCents(fleetCash, amountText));
+    printf("%-22s: %.3f s\n", "Elapsed", seconds);
+    printf("%-22s: %.0f\n", "Sales/sec", total.sales / seconds);
+    printf("%-22s: %.0f\n", "Sessions/sec", total.sessions / seconds);
+    printf(SEPARATOR "\n");
+
+    freeFleet(&fleet);
+    free(workers);
+    free(threads);
+    return 0;
+}
+
+/**
+ * @brief Claims change for a kiosk from the shared register, planning again whenever another
+ *        thread takes planned pieces first.
+ * @param machine The machine whose register pays out.
+ * @param amount The amount to pay out, in centavos.
+ * @param plan Receives the claimed breakdown, to be committed or aborted.
+ * @param stats The kiosk's counters.
+ * @return 1 if the change was reserved, 0 if the register cannot make it exactly or other threads
+ *         kept taking the planned pieces.
+ */
+static int reserveKioskChange(VendingMachine *machine, Cents amount, ChangeResult *plan,
+                              KioskStats *stats)
+{
+    EngineStatus status = ENGINE_INSUFFICIENT_CASH;
+
+    for (int attempt = 0; status == ENGINE_INSUFFICIENT_CASH && attempt < CHANGE_CLAIM_ATTEMPTS;
+         attempt++)
+    {
+        *plan = computeChange(machine, amount);
+        status = plan->status;
+        if (status == ENGINE_OK)
+        {
+            status = reserveChange(machine, plan);
+            stats->changeRetries += (status != ENGINE_OK);
+        }
+    }
+    return status == ENGINE_OK;
+}
+
+/**
+ * @brief Runs one kiosk customer: insert bills, choose items, then buy with change or cancel
+ *        with a refund.
+ * @param kiosk The kiosk.
+ * @param selection The kiosk's cart, empty between customers.
+ * @param stats The kiosk's counters.
+ */
+static void runKioskSession(KioskWorker *kiosk, UserSelection *selection, KioskStats *stats)
+{
+    VendingMachine *machine = kiosk->machine;
+    ChangeResult plan;
+    Cents credit = 0;
+    int bills = 1 + (int) (nextRandom(&kiosk->rng) % KIOSK_MAX_BILLS);
+    int wanted = 1 + (int) (nextRandom(&kiosk->rng) % FLEET_MAX_ORDER_ITEMS);
+
+    stats->sessions++;
+    __atomic_fetch_add(kiosk->sessionsStarted, 1, __ATOMIC_RELAXED);
+
+    // The bills go into the shared register the way the console puts a customer's in
+    for (int bill = 0; bill < bills; bill++)
+    {
+        int slot = kiosk->billSlots[nextRandom(&kiosk->rng) % (unsigned int) kiosk->billCount];
+        Cents denomination = machine->cash[slot].cashDenomination;
+
+        if (insertMoney(machine, denomination, &credit) == ENGINE_OK)
+        {
+            stats->cashIn += denomination;
+        }
+    }
+
+    for (int unit = 0; unit < wanted; unit++)
+    {
+        int index = (int) (nextRandom(&kiosk->rng) % (unsigned int) machine->menuSize);
+
+        if (addItemToCart(machine, index, selection, credit).status == ENGINE_OUT_OF_STOCK)
+        {
+            stats->stockOuts++;
+        }
+    }
+
+    int isCancelled = (selection->count == 0 || nextRandom(&kiosk->rng) % KIOSK_CANCEL_ODDS == 0);
+    if (!isCancelled)
+    {
+        Cents change = credit - selection->totalItemCost;
+
+        // The change is claimed before the sale is confirmed, so a confirmed sale always pays out
+        if (reserveKioskChange(machine, change, &plan, stats))
+        {
+            for (int line = 0; line < selection->count; line++)
+            {
+                stats->unitsSold += cartLines(selection)[line].quantity;
+            }
+            stats->sales++;
+            stats->cashOut += change;
+            resetOrderAfterConfirm(selection, &credit, machine);
+            commitChange(machine, &plan);
+        }
+        else
+        {
+            stats->changeFailures++;
+            isCancelled = 1;
+        }
+    }
+
+    if (isCancelled)
+    {
+        Cents refund = credit;
+
+        stats->cancelled++;
+        resetOrderAfterCancel(selection, &credit, machine);
+        if (reserveKioskChange(machine, refund, &plan, stats))
+        {
+            commitChange(machine, &plan);
+            stats->cashOut += refund;
+        }
+        else
+        {
+            stats->unrefunded += refund;
+        }
+    }
+}
+
+/**
+ * @brief Body of a kiosk thread: runs cash-paid customer sessions against the shared inventory
+ *        and register.
+ * @param argument The kiosk.
+ * @return NULL.
+ */
+static void *runKiosk(void *argument)
+{
+    KioskWorker *kiosk = argument;
+    KioskStats stats = {0};  // Kept on the kiosk's own stack while it runs
+    UserSelection selection = {{{0}}, NULL, 0, 0};
+
+    // Every kiosk plans change with the machine's own solver, as the staff does
+    for (int session = 0; session < kiosk->sessions; session++)
+    {
+        runKioskSession(kiosk, &selection, &stats);
+    }
+
+    kiosk->stats = stats;
+    return NULL;
+}
+
+/**
+ * @brief Body of the staff thread: takes cash out of the register, refills its coins and tops up
+ *        items running low while the kiosks sell.
+ * @param argument The staff.
+ * @return NULL.
+ */
+static void *runKioskStaff(void *argument)
+{
+    KioskStaff *staff = argument;
+    VendingMachine *machine = staff->machine;
+
+    for (int operation = 0; operation < staff->operations; operation++)
+    {
+        // Visit once per KIOSK_STAFF_SHARE sessions so the shelves are serviced for the whole run
+        while (__atomic_load_n(&staff->sessionsStarted, __ATOMIC_RELAXED) <
+               (long) operation * KIOSK_STAFF_SHARE)
+        {
+            sched_yield();
+        }
+
+        int slot = (int) (nextRandom(&staff->rng) % (unsigned int) machine->registerSize);
+        int index = (int) (nextRandom(&staff->rng) % (unsigned int) machine->menuSize);
+        Cents denomination = machine->cash[slot].cashDenomination;
+
+        // Like a route driver, check one shelf on every visit
+        if (__atomic_load_n(&machine->items[index].stock, __ATOMIC_ACQUIRE) < KIOSK_LOW_STOCK &&
+            restockItem(machine, index, KIOSK_REFILL_UNITS) == ENGINE_OK)
+        {
+            staff->unitsRestocked += KIOSK_REFILL_UNITS;
+        }
+
+        if (nextRandom(&staff->rng) & 1u)
+        {
+            Cents amount = (1 + (Cents) (nextRandom(&staff->rng) % (KIOSK_MAX_CASH_OUT / 1000))) *
+                           1000;
+
+            if (cashOutAmount(machine, amount).status == ENGINE_OK)
+            {
+                staff->cashedOut += amount;
+            }
+            else
+            {
+                staff->failedCashOuts++;
+            }
+        }
+        else if (denomination < FLEET_MIN_BILL)
+        {
+            restockRegister(machine, denomination, KIOSK_REFILL_PIECES);
+            staff->restocked += denomination * KIOSK_REFILL_PIECES;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Runs several kiosks selling from one machine's inventory and register at once, with a
+ *        staff member servicing the register and the shelves, and checks that nothing was sold or
+ *        paid twice.
+ *
+ * Kiosks insert money, reserve units and plan change through the engine, which claims units and
+ * pieces by compare-and-swap, so at the end the units sold must equal the stock that left the
+ * shelves counting the staff's refills, the register must hold exactly the cash that went in
+ * minus the cash that came out, and no count may be below zero. Every kiosk and the staff share
+ * the machine's change solver.
+ *
+ * @param machine The machine whose inventory and register the kiosks share.
+ * @param kioskCount The number of kiosks, each on its own thread.
+ * @param sessionsPerKiosk The number of customer sessions each kiosk runs.
+ * @return 0 if the stock and cash add up, 1 if the arguments are invalid, memory ran out or the
+ *         counts do not add up.
+ * @pre The machine must not be journaling.
+ */
+int runKioskSimulation(VendingMachine *machine, int kioskCount, int sessionsPerKiosk)
+{
+    KioskWorker *kiosks = NULL;
+    pthread_t *threads = NULL;
+    KioskStaff staff = {0};
+    pthread_t staffThread;
+    int billSlots[MAX_DENOMINATIONS];
+
+    if (kioskCount < 1 || kioskCount > FLEET_MAX_THREADS || sessionsPerKiosk < 1 ||
+        machine->menuSize < 1 || machine->registerSize < 1)
+    {
+        printf("Kiosk mode needs 1 to %d kiosks, at least one session, item and denomination.\n",
+               FLEET_MAX_THREADS);
+        return 1;
+    }
+
+    kiosks = calloc((size_t) kioskCount, sizeof(KioskWorker));
+    threads = malloc((size_t) kioskCount * sizeof(pthread_t));
+    if (kiosks == NULL || threads == NULL)
+    {
+        fprintf(stderr, "Not enough memory to run %d kiosks.\n", kioskCount);
+        free(kiosks);
+        free(threads);
+        return 1;
+    }
+
+    long startingStock = 0;
+    for (int i = 0; i < machine->menuSize; i++)
+    {
+        startingStock += machine->items[i].stock;
+    }
+    Cents startingCash = registerTotal(machine);
+    int billCount = findBillSlots(machine, billSlots);
+
+    long long startTime = currentTimeNs();
+    staff.machine = machine;
+    staff.operations = (int) ((long long) kioskCount * sessionsPerKiosk / KIOSK_STAFF_SHARE) + 1;
+    staff.rng = 0x2545F4914F6CDD1Dull;
+    staff.isThreaded = (pthread_create(&staffThread, NULL, runKioskStaff, &staff) == 0);
+    for (int k = 0; k < kioskCount; k++)
+    {
+        kiosks[k].machine = machine;
+        kiosks[k].billSlots = billSlots;
+        kiosks[k].billCount = billCount;
+        kiosks[k].sessions = sessionsPerKiosk;
+        kiosks[k].sessionsStarted = &staff.sessionsStarted;
+        kiosks[k].rng = 0xD1B54A32D192ED03ull * (unsigned long long) (k + 1);
+        kiosks[k].isThreaded = (pthread_create(&threads[k], NULL, runKiosk, &kiosks[k]) == 0);
+        if (!kiosks[k].isThreaded)
+        {
+            runKiosk(&kiosks[k]);  // Run the kiosk here rather than skip it
+        }
+    }
+    if (staff.isThreaded)
+    {
+        pthread_join(staffThread, NULL);
+    }
+    else
+    {
+        runKioskStaff(&staff);
+    }
+    for (int k = 0; k < kioskCount; k++)
+    {
+        if (kiosks[k].isThreaded)
+        {
+            pthread_join(threads[k], NULL);
+        }
+    }
+    long long elapsed = currentTimeNs() - startTime;
+
+    // Every unit that left the shelves and every piece that left the register is accounted for
+    KioskStats total = {0};
+    long endingStock = 0;
+    long negativeCounts = 0;
+    for (int k = 0; k < kioskCount; k++)
+    {
+        total.sessions += kiosks[k].stats.sessions;
+        total.sales += kiosks[k].stats.sales;
+        total.unitsSold += kiosks[k].stats.unitsSold;
+        total.stockOuts += kiosks[k].stats.stockOuts;
+        total.cancelled += kiosks[k].stats.cancelled;
+        total.changeFailures += kiosks[k].stats.changeFailures;
+        total.changeRetries += kiosks[k].stats.changeRetries;
+        total.cashIn += kiosks[k].stats.cashIn;
+        total.cashOut += kiosks[k].stats.cashOut;
+        total.unrefunded += kiosks[k].stats.unrefunded;
+    }
+    for (int i = 0; i < machine->menuSize; i++)
+    {
+        endingStock += machine->items[i].stock;
+        negativeCounts += (machine->items[i].stock < 0);
+    }
+    for (int slot = 0; slot < machine->registerSize; slot++)
+    {
+        negativeCounts += (machine->cash[slot].amountLeft < 0);
+    }
+    noteRegisterChanged(machine);
+    long oversold = total.unitsSold - (startingStock + staff.unitsRestocked - endingStock);
+    Cents unaccounted = startingCash + total.cashIn + staff.restocked - total.cashOut -
+                        staff.cashedOut - registerTotal(machine);
+
+    char amountText[MONEY_TEXT_SIZE];
+    double seconds = elapsed / 1e9;
+    printf(SEPARATOR "\nKiosk Simulation Report: %d kiosks x %d sessions\n" SEPARATOR "\n",
+           kioskCount, sessionsPerKiosk);
+    printf("%-22s: %ld\n", "Sessions", total.sessions);
+    printf("%-22s: %ld\n", "Sales", total.sales);
+    printf("%-22s: %ld\n", "Units Sold", total.unitsSold);
+    printf("%-22s: %ld\n", "Stock-Outs", total.stockOuts);
+    printf("%-22s: %ld\n", "Canceled", total.cancelled);
+    printf("%-22s: %ld\n", "Change Failures", total.changeFailures);
+    printf("%-22s: %ld\n", "Change Retries", total.changeRetries);
+    printf("%-22s: %s PHP\n", "Unrefunded", formatCents(total.unrefunded, amountText));
+    printf("%-22s: %s PHP\n", "Staff Cash-Outs", formatCents(staff.cashedOut, amountText));
+    printf("%-22s: %ld\n", "Failed Cash-Outs", staff.failedCashOuts);
+    printf("%-22s: %ld\n", "Units Restocked", staff.unitsRestocked);
+    printf("%-22s: %ld -> %ld\n", "Stock", startingStock, endingStock);
+    printf("%-22s: %ld\n", "Oversold Units", oversold);
+    printf("%-22s: %s PHP\n", "Cash Unaccounted", formatCents(unaccounted, amountText));
+    printf("%-22s: %ld\n", "Negative Counts", negativeCounts);
+    printf("%-22s: %.3f s\n", "Elapsed", seconds);
+    printf("%-22s: %.0f\n", "Sessions/sec", total.sessions / seconds);
+    printf(SEPARATOR "\n");
+
+    free(kiosks);
+    free(threads);
+    return (oversold == 0 && unaccounted == 0 && negativeCounts == 0) ? 0 : 1;
+}
@@ -0,0 +1,736 @@
+#define _POSIX_C_SOURCE 200809L  // Expose fdatasync and clock_gettime
+
+#include "journal.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cart.h"
+#include "crc32.h"
+#include "data_management.h"
+#include "data_structures.h"
+#include "engine.h"
+#include "snapshot.h"
+
+/**
+ * @brief A growable array of journal records.
+ */
+typedef struct
+{
+    JournalRecord *records;  // Records in the order they are written
+    int count;               // Number of records in the array
+    int capacity;            // Number of records the array can hold before it must grow
+} RecordBuffer;
+
+/**
+ * @brief An order of a socket session being rebuilt from the journal, apart from the console's
+ * order and from the orders of other sessions its records are interleaved with.
+ */
+typedef struct
+{
+    int order;                // Order id its records carry
+    UserSelection selection;  // The order's cart
+    Cents userMoney;          // Money inserted for the order
+} ReplayOrder;
+
+/**
+ * @brief The socket session orders open at the point of the journal being replayed.
+ */
+typedef struct
+{
+    ReplayOrder *orders;  // Open orders, in no particular order
+    int count;            // Number of open orders
+    int capacity;         // Number of orders the array can hold before it must grow
+} ReplayOrders;
+
+/**
+ * @brief A copy of the machine state taken for a snapshot, in buffers owned by the journal.
+ */
+typedef struct
+{
+    MachineSnapshot state;    // The captured state, pointing into the buffers below
+    VendingItem *items;       // Copy of the inventory
+    ItemSales *sales;         // Copy of the sales totals of the inventory
+    int itemCapacity;         // Number of items the items and sales buffers can hold
+    CashRegister *cash;       // Copy of the cash register
+    int cashCapacity;         // Number of slots the cash buffer can hold
+    SnapshotLine *lines;      // Copy of the lines of the order in progress
+    int lineCapacity;         // Number of lines the lines buffer can hold
+} SnapshotImage;
+
+/**
+ * @brief An open journal: the records waiting to be written and the thread that writes them.
+ *
+ * Appending only copies a record into the pending buffer. The flusher thread collects everything
+ * appended within JOURNAL_GROUP_COMMIT_MS and writes it with one write and one fdatasync, so a
+ * burst of changes costs one disk sync instead of one each (group commit).
+ */
+struct Journal
+{
+    char path[FILE_PATH_SIZE];          // Journal file path
+    char snapshotPath[FILE_PATH_SIZE];  // Snapshot file the journal is compacted into
+    int fd;                             // Journal file, open for appending; owned by the flusher
+    pthread_t flusher;                  // Thread writing and syncing the pending records
+    pthread_mutex_t lock;               // Guards every field below
+    pthread_cond_t wake;                // Signals the flusher that there is work
+    pthread_cond_t durable;             // Signals flushJournal that more records reached the disk
+    RecordBuffer pending;               // Records appended but not yet handed to the flusher
+    SnapshotImage image;                // State captured for a requested snapshot
+    int imageOffset;                    // Pending records that belong before the image
+    int hasImage;                       // 1 if a snapshot is waiting for the flusher
+    uint64_t nextSequence;              // Sequence number of the next record appended
+    uint64_t durableSequence;           // Last sequence number known to be on disk
+    long recordsSinceCompaction;        // Records appended since the last snapshot was requested
+    int isFlushRequested;               // 1 if a caller is waiting, so the batch is written now
+    int isClosing;                      // 1 once closeJournal has been called
+    int hasFailed;                      // 1 if a write or sync failed and records may be lost
+};
+
+/**
+ * @brief Makes room for one more record in a buffer.
+ * @param buffer The buffer to grow.
+ * @return The slot for the new record, or NULL if memory ran out.
+ */
+static JournalRecord *pushRecord(RecordBuffer *buffer)
+{
+    JournalRecord *record = NULL;
+
+    if (buffer->count == buffer->capacity)
+    {
+        int capacity = (buffer->capacity == 0) ? 256 : buffer->capacity * 2;
+        JournalRecord *grown = realloc(buffer->records, (size_t) capacity * sizeof(JournalRecord));
+
+        if (grown != NULL)
+        {
+            buffer->records = grown;
+            buffer->capacity = capacity;
+        }
+    }
+    if (buffer->count < buffer->capacity)
+    {
+        record = &buffer->records[buffer->count++];
+    }
+    return record;
+}
+
+/**
+ * @brief Computes the checksum of a record: a CRC-32 of everything after the checksum field.
+ * @param record The record to checksum.
+ * @return The checksum.
+ */
+static uint32_t checksumRecord(const JournalRecord *record)
+{
+    return computeCrc32((const char *) record + sizeof(record->checksum),
+                        sizeof(JournalRecord) - sizeof(record->checksum));
+}
+
+/**
+ * @brief Copies the state of a machine into an image, growing its buffers as needed.
+ * @param image The image to fill in.
+ * @param machine The vending machine to copy.
+ * @param selection The order in progress, or NULL if there is none.
+ * @param userMoney The money inserted for the order in progress.
+ * @param sequence The last journal record the state includes.
+ * @return 1 if the state was copied, 0 if memory ran out.
+ */
+static int captureImage(SnapshotImage *image, const VendingMachine *machine,
+                        const UserSelection *selection, Cents userMoney, uint64_t sequence)
+{
+    int isCaptured = 1;
+    int lineCount = (selection != NULL) ? selection->count : 0;
+
+    if (machine->menuSize > image->itemCapacity)
+    {
+        VendingItem *items =
+            realloc(image->items, (size_t) machine->menuSize * sizeof(VendingItem));
+        ItemSales *sales = NULL;
+
+        if (items != NULL)
+        {
+            image->items = items;
+            sales = realloc(image->sales, (size_t) machine->menuSize * sizeof(ItemSales));
+        }
+        isCaptured = (sales != NULL);
+        if (isCaptured)
+        {
+            image->sales = sales;
+            image->itemCapacity = machine->menuSize;
+        }
+    }
+    if (isCaptured && machine->registerSize > image->cashCapacity)
+    {
+        CashRegister *cash =
+            realloc(image->cash, (size_t) machine->registerSize * sizeof(CashRegister));
+
+        isCaptured = (cash != NULL);
+        if (isCaptured)
+        {
+            image->cash = cash;
+            image->cashCapacity = machine->registerSize;
+        }
+    }
+
+    if (isCaptured && lineCount > image->lineCapacity)
+    {
+        SnapshotLine *lines = realloc(image->lines, (size_t) lineCount * sizeof(SnapshotLine));
+
+        isCaptured = (lines != NULL);
+        if (isCaptured)
+        {
+            image->lines = lines;
+            image->lineCapacity = lineCount;
+        }
+    }
+
+    if (isCaptured)
+    {
+        memcpy(image->items, machine->items, (size_t) machine->menuSize * sizeof(VendingItem));
+        memcpy(image->sales, machine->sales, (size_t) machine->menuSize * sizeof(ItemSales));
+        memcpy(image->cash, machine->cash, (size_t) machine->registerSize * sizeof(CashRegister));
+        for (int i = 0; i < lineCount; i++)
+        {
+            const CartLine *line = &cartLines(selection)[i];
+
+            image->lines[i].unitPrice = line->unitPrice;
+            image->lines[i].itemNumber = machine->items[line->itemIndex].itemNumber;
+            image->lines[i].quantity = line->quantity;
+        }
+
+        memset(&image->state, 0, sizeof(image->state));
+        image->state.sequence = sequence;
+        image->state.userMoney = (selection != NULL) ? userMoney : 0;
+        image->state.items = image->items;
+        image->state.sales = image->sales;
+        image->state.itemCount = machine->menuSize;
+        image->state.cash = image->cash;
+        image->state.registerSize = machine->registerSize;
+        image->state.lines = image->lines;
+        image->state.lineCount = lineCount;
+    }
+    return isCaptured;
+}
+
+/**
+ * @brief Starts a new journal file holding only the records appended after a snapshot.
+ *
+ * The file is written and synced under a temporary name and then renamed over the journal, so a
+ * crash at any point leaves either the old journal or the new one complete.
+ *
+ * @param journal The journal being compacted.
+ * @param records The records appended after the snapshot was taken.
+ * @param count The number of records.
+ * @return 1 if the journal was replaced, 0 if the old journal was kept.
+ */
+static int restartJournalFile(Journal *journal, const JournalRecord *records, int count)
+{
+    char tempPath[FILE_PATH_SIZE + 4];
+    int isReplaced = 0;
+    int fd;
+
+    strcpy(tempPath, journal->path);
+    strcat(tempPath, ".tmp");
+
+    fd = open(tempPath, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (fd != -1)
+    {
+        isReplaced = writeFully(fd, records, (size_t) count * sizeof(JournalRecord)) &&
+                     fdatasync(fd) == 0 && rename(tempPath, journal->path) == 0;
+        if (isReplaced)
+        {
+            syncParentDirectory(journal->path);
+            close(journal->fd);
+            journal->fd = fd;  // The renamed file is the journal from now on
+        }
+        else
+        {
+            close(fd);
+            unlink(tempPath);
+        }
+    }
+    return isReplaced;
+}
+
+/**
+ * @brief Writes one batch of records handed over by the flusher.
+ *
+ * With an image, the snapshot is written first and the journal is then restarted with only the
+ * records after it. If either step fails the batch is appended to the old journal instead; its
+ * records up to the snapshot are skipped at replay if the new snapshot did make it to disk.
+ *
+ * @param journal The journal being written.
+ * @param batch The records appended since the last batch.
+ * @param image The state captured for a snapshot, or NULL if none was requested.
+ * @param imageOffset The number of batch records that belong before the image.
+ * @return 1 if every record reached the disk, 0 otherwise.
+ */
+static int writeBatch(Journal *journal, const RecordBuffer *batch, const SnapshotImage *image,
+                      int imageOffset)
+{
+    int isWritten = (image != NULL && writeSnapshot(journal->snapshotPath, &image->state) &&
+                     restartJournalFile(journal, &batch->records[imageOffset],
+                                        batch->count - imageOffset));
+
+    if (!isWritten)
+    {
+        isWritten = writeFully(journal->fd, batch->records,
+                               (size_t) batch->count * sizeof(JournalRecord)) &&
+                    fdatasync(journal->fd) == 0;
+    }
+    return isWritten;
+}
+
+/**
+ * @brief Body of the flusher thread: writes and syncs the pending records in batches until the
+ *        journal is closed.
+ * @param argument The journal to flush.
+ * @return NULL.
+ */
+static void *runFlusher(void *argument)
+{
+    Journal *journal = argument;
+    RecordBuffer batch = {NULL, 0, 0};  // Records being written, swapped with the pending buffer
+    SnapshotImage *image = calloc(1, sizeof(SnapshotImage));  // Image being written, swapped
+                                                              // with the requested one
+    int isRunning = 1;
+
+    pthread_mutex_lock(&journal->lock);
+    while (isRunning)
+    {
+        while (!journal->isClosing && journal->pending.count == 0 && !journal->hasImage)
+        {
+            pthread_cond_wait(&journal->wake, &journal->lock);
+        }
+
+        // Let the rest of a burst arrive so one sync covers all of it
+        if (!journal->isClosing && !journal->isFlushRequested)
+        {
+            struct timespec deadline;
+
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += JOURNAL_GROUP_COMMIT_MS * 1000000L;
+            deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+            deadline.tv_nsec %= 1000000000L;
+            pthread_cond_timedwait(&journal->wake, &journal->lock, &deadline);
+        }
+
+        // Take the pending records and leave an empty buffer for appenders
+        RecordBuffer swap = journal->pending;
+        journal->pending = batch;
+        journal->pending.count = 0;
+        batch = swap;
+
+        // Take the requested image, if the spare one could be allocated to replace it
+        int hasImage = (journal->hasImage && image != NULL);
+        int imageOffset = journal->imageOffset;
+        if (hasImage)
+        {
+            SnapshotImage spare = journal->image;
+            journal->image = *image;
+            *image = spare;
+            image->state.lines = image->lines;  // The lines live inside the image, which moved
+        }
+        journal->hasImage = 0;
+
+        uint64_t lastSequence = journal->nextSequence - 1;
+        journal->isFlushRequested = 0;
+        isRunning = !journal->isClosing;
+        pthread_mutex_unlock(&journal->lock);
+
+        int isWritten = writeBatch(journal, &batch, hasImage ? image : NULL, imageOffset);
+
+        pthread_mutex_lock(&journal->lock);
+        journal->hasFailed |= !isWritten;
+        journal->durableSequence = lastSequence;
+        pthread_cond_broadcast(&journal->durable);
+    }
+    pthread_mutex_unlock(&journal->lock);
+
+    free(batch.records);
+    if (image != NULL)
+    {
+        free(image->items);
+        free(image->sales);
+        free(image->cash);
+        free(image->lines);
+        free(image);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Applies one journaled change to the machine and the order in progress.
+ * @param record The change to apply.
+ * @param machine The vending machine being rebuilt.
+ * @param selection The order in progress.
+ * @param userMoney The money inserted for the order in progress.
+ */
+static void applyRecord(const JournalRecord *record, VendingMachine *machine,
+                        UserSelection *selection, Cents *userMoney)
+{
+    int index = findItemByNumber(machine, (int) record->operands[0]);
+    int slot = findDenominationSlot(machine, record->operands[0]);
+
+    // Records for items or denominations the machine no longer has are skipped
+    switch (record->type)
+    {
+        case JOURNAL_MONEY_INSERTED:
+            insertMoney(machine, record->operands[0], userMoney);
+            break;
+
+        case JOURNAL_ITEM_RESERVED:
+            if (index != -1)
+            {
+                // Records written before bulk ordering hold 0 units and stand for one
+                int units = (record->operands[1] > 0) ? (int) record->operands[1] : 1;
+
+                updateSelectedItems(selection, &machine->items[index], index, units);
+                machine->items[index].stock -= units;
+            }
+            break;
+
+        case JOURNAL_ORDER_CONFIRMED:
+            resetOrderAfterConfirmAt(selection, userMoney, machine, record->operands[0]);
+            break;
+
+        case JOURNAL_ORDER_CANCELLED:
+            resetOrderAfterCancel(selection, userMoney, machine);
+            break;
+
+        case JOURNAL_ITEM_RESTOCKED:
+            restockItem(machine, index, (int) record->operands[1]);
+            break;
+
+        case JOURNAL_PRICE_CHANGED:
+            setItemPrice(machine, index, record->operands[1]);
+            break;
+
+        case JOURNAL_CASH_RESTOCKED:
+            restockRegister(machine, record->operands[0], (int) record->operands[1]);
+            break;
+
+        case JOURNAL_CASH_REMOVED:
+            if (slot != -1)
+            {
+                machine->cash[slot].amountLeft -= (int) record->operands[1];
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Checks whether a kind of change belongs to an order rather than to the machine.
+ * @param type The kind of change.
+ * @return 1 for money inserted, items reserved, and orders confirmed or canceled; 0 otherwise.
+ */
+static int isOrderChange(uint32_t type)
+{
+    return (type == JOURNAL_MONEY_INSERTED || type == JOURNAL_ITEM_RESERVED ||
+            type == JOURNAL_ORDER_CONFIRMED || type == JOURNAL_ORDER_CANCELLED);
+}
+
+/**
+ * @brief Finds the open socket session order with an id, starting it if it is not open.
+ * @param open The open orders.
+ * @param order The order id.
+ * @return The order, or NULL if memory ran out.
+ */
+static ReplayOrder *openReplayOrder(ReplayOrders *open, int order)
+{
+    ReplayOrder *found = NULL;
+
+    for (int i = 0; found == NULL && i < open->count; i++)
+    {
+        if (open->orders[i].order == order)
+        {
+            found = &open->orders[i];
+        }
+    }
+    if (found == NULL && open->count == open->capacity)
+    {
+        int capacity = (open->capacity == 0) ? 16 : open->capacity * 2;
+        ReplayOrder *grown = realloc(open->orders, (size_t) capacity * sizeof(ReplayOrder));
+
+        if (grown != NULL)
+        {
+            open->orders = grown;
+            open->capacity = capacity;
+        }
+    }
+    if (found == NULL && open->count < open->capacity)
+    {
+        found = &open->orders[open->count++];
+        memset(found, 0, sizeof(*found));
+        found->order = order;
+    }
+    return found;
+}
+
+/**
+ * @brief Rebuilds the state of a machine from its journal.
+ *
+ * Records up to the snapshot the machine was restored from are skipped; the rest are applied in
+ * order until the end of the file or the first record that is torn or out of sequence, which
+ * marks where a crash interrupted a write. Any console order that was in progress is rebuilt into
+ * the selection and money. Socket session orders are rebuilt apart by their order id; any still
+ * open at the end had their controller cut off by the crash, so they are canceled: their stock
+ * goes back on sale and their money stays in the register for staff to refund.
+ *
+ * @param path The journal file.
+ * @param machine The vending machine to rebuild, holding the state the journal continues from.
+ * @param selection The order in progress at that state.
+ * @param userMoney The money inserted for the order in progress at that state.
+ * @param afterSequence The last record already included in the machine's state, 0 for none.
+ * @param nextSequence Receives the sequence number the journal continues from.
+ * @return The number of records applied (0 if there is no journal), or -1 if it could not be read.
+ * @pre The machine must not be journaling yet, so replayed changes are not journaled again.
+ */
+int replayJournal(const char *path, VendingMachine *machine, UserSelection *selection,
+                  Cents *userMoney, uint64_t afterSequence, uint64_t *nextSequence)
+{
+    int applied = 0;
+    int fd = open(path, O_RDONLY);
+
+    *nextSequence = afterSequence + 1;
+    if (fd == -1)
+    {
+        applied = (errno == ENOENT) ? 0 : -1;
+    }
+    else
+    {
+        struct stat status;
+        JournalRecord *records = NULL;
+        size_t count = 0;
+
+        if (fstat(fd, &status) == 0 && status.st_size > 0)
+        {
+            size_t size;
+
+            count = (size_t) status.st_size / sizeof(JournalRecord);
+            size = count * sizeof(JournalRecord);
+            records = malloc(size);
+            applied = (records != NULL && read(fd, records, size) == (ssize_t) size) ? 0 : -1;
+        }
+
+        ReplayOrders open = {NULL, 0, 0};  // Socket session orders open at the current record
+        int isValid = (applied == 0);
+        for (size_t i = 0; isValid && i < count; i++)
+        {
+            const JournalRecord *record = &records[i];
+            ReplayOrder *order = NULL;
+
+            isValid = (record->checksum == checksumRecord(record) &&
+                       (record->sequence <= afterSequence || record->sequence == *nextSequence));
+            if (isValid && record->sequence > afterSequence && record->order != 0 &&
+                isOrderChange(record->type))
+            {
+                order = openReplayOrder(&open, record->order);
+                isValid = (order != NULL);
+            }
+            if (isValid && record->sequence > afterSequence)
+            {
+                applyRecord(record, machine, (order != NULL) ? &order->selection : selection,
+                            (order != NULL) ? &order->userMoney : userMoney);
+                *nextSequence = record->sequence + 1;
+                applied++;
+            }
+            if (order != NULL && (record->type == JOURNAL_ORDER_CONFIRMED ||
+                                  record->type == JOURNAL_ORDER_CANCELLED))
+            {
+                *order = open.orders[--open.count];  // Ended; its cart is already empty
+            }
+        }
+
+        // The controllers of orders left open are gone with the crashed server
+        for (int i = 0; i < open.count; i++)
+        {
+            resetOrderAfterCancel(&open.orders[i].selection, &open.orders[i].userMoney, machine);
+        }
+        free(open.orders);
+
+        noteRegisterChanged(machine);
+        free(records);
+        close(fd);
+    }
+    return applied;
+}
+
+/**
+ * @brief Opens a journal for appending and starts its flusher thread.
+ * @param path The journal file; created if it does not exist.
+ * @param snapshotPath The snapshot file the journal is compacted into.
+ * @param nextSequence The sequence number of the first record appended, from replayJournal.
+ * @return The journal, or NULL if the file could not be opened or memory ran out.
+ */
+Journal *openJournal(const char *path, const char *snapshotPath, uint64_t nextSequence)
+{
+    Journal *journal = NULL;
+
+    if (strlen(path) + 4 < FILE_PATH_SIZE && strlen(snapshotPath) < FILE_PATH_SIZE)
+    {
+        journal = calloc(1, sizeof(Journal));
+    }
+    if (journal != NULL)
+    {
+        strcpy(journal->path, path);
+        strcpy(journal->snapshotPath, snapshotPath);
+        journal->nextSequence = nextSequence;
+        journal->durableSequence = nextSequence - 1;
+        journal->fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+        pthread_mutex_init(&journal->lock, NULL);
+        pthread_cond_init(&journal->wake, NULL);
+        pthread_cond_init(&journal->durable, NULL);
+
+        if (journal->fd == -1 || pthread_create(&journal->flusher, NULL, runFlusher, journal) != 0)
+        {
+            if (journal->fd != -1)
+            {
+                close(journal->fd);
+            }
+            pthread_mutex_destroy(&journal->lock);
+            pthread_cond_destroy(&journal->wake);
+            pthread_cond_destroy(&journal->durable);
+            free(journal);
+            journal = NULL;
+        }
+    }
+    return journal;
+}
+
+/**
+ * @brief Appends a change to the journal. The record reaches the disk within
+ *        JOURNAL_GROUP_COMMIT_MS; call flushJournal to wait for it, as the engine does before a
+ *        sale or cash out is reported done.
+ * @param journal The journal to append to.
+ * @param type The kind of change.
+ * @param order The order the change belongs to, from 0 to JOURNAL_MAX_ORDER.
+ * @param first The first operand, as listed for the type.
+ * @param second The second operand, as listed for the type, or 0.
+ */
+void appendJournal(Journal *journal, JournalType type, int order, int64_t first, int64_t second)
+{
+    pthread_mutex_lock(&journal->lock);
+
+    JournalRecord *record = pushRecord(&journal->pending);
+    if (record != NULL)
+    {
+        record->type = (uint16_t) type;
+        record->order = (uint16_t) order;
+        record->sequence = journal->nextSequence++;
+        record->operands[0] = first;
+        record->operands[1] = second;
+        record->checksum = checksumRecord(record);
+        journal->recordsSinceCompaction++;
+        if (journal->pending.count == 1)
+        {
+            pthread_cond_signal(&journal->wake);  // The flusher sleeps until a batch starts
+        }
+    }
+    else
+    {
+        journal->hasFailed = 1;
+    }
+
+    pthread_mutex_unlock(&journal->lock);
+}
+
+/**
+ * @brief Checks whether enough records were appended that the journal should be compacted.
+ * @param journal The journal to check.
+ * @return 1 if compactJournal should be called, 0 otherwise.
+ */
+int isJournalCompactionDue(Journal *journal)
+{
+    pthread_mutex_lock(&journal->lock);
+    int isDue = (journal->recordsSinceCompaction >= JOURNAL_COMPACT_RECORDS && !journal->hasImage);
+    pthread_mutex_unlock(&journal->lock);
+    return isDue;
+}
+
+/**
+ * @brief Compacts the journal into a snapshot of the current state of the machine.
+ *
+ * The state is copied now; the flusher then writes the snapshot and restarts the journal after
+ * it in the background, so the caller does not wait for the disk.
+ *
+ * @param journal The journal to compact.
+ * @param machine The vending machine whose state replaces the journaled history.
+ * @param selection The order in progress, or NULL if there is none.
+ * @param userMoney The money inserted for the order in progress.
+ */
+void compactJournal(Journal *journal, const VendingMachine *machine,
+                    const UserSelection *selection, Cents userMoney)
+{
+    pthread_mutex_lock(&journal->lock);
+
+    // If memory runs out the journal simply keeps its full history
+    journal->hasImage = captureImage(&journal->image, machine, selection, userMoney,
+                                     journal->nextSequence - 1);
+    journal->imageOffset = journal->pending.count;
+    journal->recordsSinceCompaction = 0;
+    pthread_cond_signal(&journal->wake);
+
+    pthread_mutex_unlock(&journal->lock);
+}
+
+/**
+ * @brief Waits until every record appended so far is on disk.
+ * @param journal The journal to flush.
+ */
+void flushJournal(Journal *journal)
+{
+    pthread_mutex_lock(&journal->lock);
+
+    uint64_t target = journal->nextSequence - 1;
+    journal->isFlushRequested = 1;
+    pthread_cond_signal(&journal->wake);
+    while (journal->durableSequence < target && !journal->isClosing)
+    {
+        pthread_cond_wait(&journal->durable, &journal->lock);
+    }
+
+    pthread_mutex_unlock(&journal->lock);
+}
+
+/**
+ * @brief Writes out every pending record and snapshot, stops the flusher and closes the journal.
+ * @param journal The journal to close, or NULL.
+ * @return 1 if every record appended was written and synced, 0 if some may have been lost.
+ */
+int closeJournal(Journal *journal)
+{
+    int isIntact = 1;
+
+    if (journal != NULL)
+    {
+        pthread_mutex_lock(&journal->lock);
+        journal->isClosing = 1;
+        pthread_cond_signal(&journal->wake);
+        pthread_mutex_unlock(&journal->lock);
+
+        pthread_join(journal->flusher, NULL);  // The flusher writes the last batch before exiting
+
+        isIntact = !journal->hasFailed;
+        close(journal->fd);
+        free(journal->pending.records);
+        free(journal->image.items);
+        free(journal->image.sales);
+        free(journal->image.cash);
+        free(journal->image.lines);
+        pthread_mutex_destroy(&journal->lock);
+        pthread_cond_destroy(&journal->wake);
+        pthread_cond_destroy(&journal->durable);
+        free(journal);
+    }
+    return isIntact;
+}
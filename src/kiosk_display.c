@@ -0,0 +1,222 @@
+#define _POSIX_C_SOURCE 200809L  // Expose isatty and fileno
+
+#include "kiosk_display.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#define DISPLAY_MAX_ROWS 256      // Tallest panel the screen copy can hold
+#define DISPLAY_FRAME_SIZE 16384  // Bytes of output collected before a write
+
+/**
+ * @brief The state of the console display.
+ *
+ * In delta mode the top of the screen is a fixed panel holding the item table and the cart, and
+ * the prompts scroll in the region below it. The panel rows as last sent are kept in screen, so
+ * a frame only sends the rows that differ. Otherwise every frame is printed in full where the
+ * prompts are, as on a plain terminal.
+ */
+typedef struct
+{
+    int isDelta;                                     // 1 if frames are diffed into the panel
+    int sectionStart[2];                             // First panel row of each section, from 0
+    int sectionRows[2];                              // Rows of the panel given to each section
+    char screen[DISPLAY_MAX_ROWS][DISPLAY_ROW_SIZE];  // Text of each panel row as last sent
+    char frame[DISPLAY_MAX_ROWS][DISPLAY_ROW_SIZE];   // Rows of the frame being built
+    DisplaySection section;                          // Section of the frame being built
+    int rowCount;                                    // Rows added to the frame so far
+    char output[DISPLAY_FRAME_SIZE];                 // Bytes waiting to be written
+    size_t outputLength;                             // Number of bytes in output
+} Display;
+
+static Display display;
+
+/**
+ * @brief Writes out the bytes collected so far with a single write.
+ */
+static void flushOutput(void)
+{
+    fwrite(display.output, 1, display.outputLength, stdout);
+    fflush(stdout);
+    display.outputLength = 0;
+}
+
+/**
+ * @brief Adds bytes to the output, writing out what was collected first if they do not fit.
+ * @param text The bytes to add.
+ * @param length The number of bytes.
+ */
+static void appendOutput(const char *text, size_t length)
+{
+    if (display.outputLength + length > sizeof(display.output))
+    {
+        flushOutput();
+    }
+    if (length > sizeof(display.output))
+    {
+        fwrite(text, 1, length, stdout);  // Too long to collect; only a huge menu gets here
+    }
+    else
+    {
+        memcpy(&display.output[display.outputLength], text, length);
+        display.outputLength += length;
+    }
+}
+
+/**
+ * @brief Sets up the console display.
+ *
+ * Delta mode needs an ANSI terminal tall enough for the panel and the prompts; a dumb terminal, a
+ * redirected output or a short window falls back to printing every frame in full.
+ *
+ * @param isDeltaRequested 1 to use delta mode when the terminal allows it.
+ * @param menuSize The number of items the menu table shows.
+ * @return 1 if delta mode is in use, 0 if frames are printed in full.
+ */
+int openDisplay(int isDeltaRequested, int menuSize)
+{
+    const char *terminal = getenv("TERM");
+    struct winsize window;
+    int menuRows = menuSize + 4;  // Blank line, header, separator, items, separator
+    int panelRows = menuRows + DISPLAY_CART_ROWS;
+
+    memset(&display, 0, sizeof(display));
+    display.isDelta = (isDeltaRequested && isatty(fileno(stdout)) && terminal != NULL &&
+                       strcmp(terminal, "dumb") != 0 && panelRows <= DISPLAY_MAX_ROWS &&
+                       ioctl(fileno(stdout), TIOCGWINSZ, &window) == 0 &&
+                       window.ws_row >= panelRows + DISPLAY_MIN_PROMPT_ROWS);
+    if (display.isDelta)
+    {
+        char setup[64];
+        int length;
+
+        display.sectionStart[DISPLAY_MENU] = 0;
+        display.sectionRows[DISPLAY_MENU] = menuRows;
+        display.sectionStart[DISPLAY_CART] = menuRows;
+        display.sectionRows[DISPLAY_CART] = DISPLAY_CART_ROWS;
+
+        // Clear the screen, keep the prompts scrolling below the panel and start them there
+        length = snprintf(setup, sizeof(setup), "\033[2J\033[%d;%dr\033[%d;1H", panelRows + 1,
+                          (int) window.ws_row, panelRows + 1);
+        appendOutput(setup, (size_t) length);
+        flushOutput();
+        atexit(closeDisplay);  // Also give the screen back if the program exits early
+    }
+    return display.isDelta;
+}
+
+/**
+ * @brief Gives the whole screen back to scrolling output.
+ */
+void closeDisplay(void)
+{
+    if (display.isDelta)
+    {
+        const char *reset = "\033[r\033[999;1H\n";  // Scroll the whole screen, cursor at the bottom
+
+        appendOutput(reset, strlen(reset));
+        flushOutput();
+        display.isDelta = 0;
+    }
+}
+
+/**
+ * @brief Tells whether tables are drawn into the fixed panel.
+ * @return 1 in delta mode, 0 if frames are printed in full.
+ */
+int isDeltaDisplay(void)
+{
+    return display.isDelta;
+}
+
+/**
+ * @brief Starts a frame: the full contents of one section, added row by row with addRow.
+ * @param section The section the frame replaces.
+ */
+void beginFrame(DisplaySection section)
+{
+    display.section = section;
+    display.rowCount = 0;
+}
+
+/**
+ * @brief Adds the next row to the frame being built.
+ *
+ * In delta mode rows beyond the section are only counted; otherwise the row is added to the
+ * output straight away.
+ *
+ * @param format A printf format for the row, without the line break.
+ */
+void addRow(const char *format, ...)
+{
+    char row[DISPLAY_ROW_SIZE];
+    va_list arguments;
+    int length;
+
+    va_start(arguments, format);
+    length = vsnprintf(row, sizeof(row), format, arguments);
+    va_end(arguments);
+    if (length >= (int) sizeof(row))
+    {
+        length = (int) sizeof(row) - 1;  // Cut rows too long to keep
+    }
+
+    if (!display.isDelta)
+    {
+        row[length] = '\n';
+        appendOutput(row, (size_t) length + 1);
+    }
+    else if (display.rowCount < display.sectionRows[display.section])
+    {
+        memcpy(display.frame[display.rowCount], row, (size_t) length + 1);
+    }
+    display.rowCount++;
+}
+
+/**
+ * @brief Finishes the frame and sends it as one write.
+ *
+ * In delta mode each row of the section is compared with the screen and only the rows that
+ * changed are sent, each with a cursor move; the cursor is saved and restored around them so the
+ * prompt below the panel carries on where it was.
+ */
+void endFrame(void)
+{
+    if (display.isDelta)
+    {
+        int start = display.sectionStart[display.section];
+        int rows = display.sectionRows[display.section];
+
+        // Rows past the end of the section are summed up on its last row
+        if (display.rowCount > rows)
+        {
+            snprintf(display.frame[rows - 1], DISPLAY_ROW_SIZE, "... %d more rows not shown",
+                     display.rowCount - rows + 1);
+        }
+        for (int i = display.rowCount; i < rows; i++)
+        {
+            display.frame[i][0] = '\0';  // Rows the frame does not fill are cleared
+        }
+
+        appendOutput("\0337", 2);  // Save the cursor
+        for (int i = 0; i < rows; i++)
+        {
+            if (strcmp(display.frame[i], display.screen[start + i]) != 0)
+            {
+                char move[16];
+                int length = snprintf(move, sizeof(move), "\033[%d;1H", start + i + 1);
+
+                appendOutput(move, (size_t) length);
+                appendOutput(display.frame[i], strlen(display.frame[i]));
+                appendOutput("\033[K", 3);  // Clear what is left of the old row
+                strcpy(display.screen[start + i], display.frame[i]);
+            }
+        }
+        appendOutput("\0338", 2);  // Restore the cursor
+    }
+    flushOutput();
+}
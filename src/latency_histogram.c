@@ -0,0 +1,142 @@
+#include "latency_histogram.h"
+
+#include <string.h>
+
+#define HISTOGRAM_SUB_BITS 4  // log2 of HISTOGRAM_SUB_BUCKETS
+
+/**
+ * @brief Finds the bucket a latency falls in.
+ *
+ * Latencies below HISTOGRAM_SUB_BUCKETS get a bucket each; above that, the highest set bit picks
+ * the power of two and the next HISTOGRAM_SUB_BITS bits pick the bucket within it.
+ *
+ * @param latency The latency, in nanoseconds; must not be negative.
+ * @return The index of the bucket.
+ */
+int histogramBucket(long long latency)
+{
+    int bucket = (int) latency;
+
+    if (latency >= HISTOGRAM_SUB_BUCKETS)
+    {
+        int exponent = 63 - __builtin_clzll((unsigned long long) latency);
+        int shift = exponent - HISTOGRAM_SUB_BITS;
+
+        bucket = (shift + 1) * HISTOGRAM_SUB_BUCKETS +
+                 (int) ((latency >> shift) & (HISTOGRAM_SUB_BUCKETS - 1));
+    }
+    return bucket;
+}
+
+/**
+ * @brief Empties a histogram.
+ * @param histogram The histogram to empty.
+ */
+void initHistogram(LatencyHistogram *histogram)
+{
+    memset(histogram, 0, sizeof(*histogram));
+}
+
+/**
+ * @brief Records one latency.
+ * @param histogram The histogram to record into.
+ * @param latency The latency, in nanoseconds. Negative latencies are recorded as 0.
+ */
+void recordLatency(LatencyHistogram *histogram, long long latency)
+{
+    if (latency < 0)
+    {
+        latency = 0;  // A clock that stepped back still counts as an operation
+    }
+    histogram->counts[histogramBucket(latency)]++;
+    if (histogram->count == 0 || latency < histogram->min)
+    {
+        histogram->min = latency;
+    }
+    if (latency > histogram->max)
+    {
+        histogram->max = latency;
+    }
+    histogram->count++;
+    histogram->total += latency;
+}
+
+/**
+ * @brief Adds every latency of one histogram to another.
+ * @param into The histogram that receives the latencies.
+ * @param from The histogram whose latencies are added.
+ */
+void mergeHistogram(LatencyHistogram *into, const LatencyHistogram *from)
+{
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        into->counts[i] += from->counts[i];
+    }
+    if (from->count > 0 && (into->count == 0 || from->min < into->min))
+    {
+        into->min = from->min;
+    }
+    if (from->max > into->max)
+    {
+        into->max = from->max;
+    }
+    into->count += from->count;
+    into->total += from->total;
+}
+
+/**
+ * @brief Returns the largest latency a bucket holds.
+ * @param bucket The index of the bucket.
+ * @return The upper bound of the bucket, in nanoseconds.
+ */
+long long histogramBucketLimit(int bucket)
+{
+    long long limit = bucket;
+
+    if (bucket >= HISTOGRAM_SUB_BUCKETS)
+    {
+        int shift = bucket / HISTOGRAM_SUB_BUCKETS - 1;
+        long long first = (long long) (HISTOGRAM_SUB_BUCKETS + bucket % HISTOGRAM_SUB_BUCKETS)
+                          << shift;
+
+        limit = first + (1LL << shift) - 1;
+    }
+    return limit;
+}
+
+/**
+ * @brief Finds the latency below which a fraction of the recorded latencies fall.
+ * @param histogram The histogram.
+ * @param fraction The fraction, such as 0.99 for the 99th percentile.
+ * @return The upper bound of the bucket holding that latency, capped at the largest latency
+ *         recorded, or 0 if nothing was recorded.
+ */
+long long histogramPercentile(const LatencyHistogram *histogram, double fraction)
+{
+    long long rank = (long long) (fraction * histogram->count + 0.999999);  // Ranks count from 1
+    long long seen = 0;
+    long long latency = 0;
+    int bucket = 0;
+
+    if (rank < 1)
+    {
+        rank = 1;
+    }
+    while (histogram->count > 0 && bucket < HISTOGRAM_BUCKETS && seen < rank)
+    {
+        seen += histogram->counts[bucket];
+        latency = histogramBucketLimit(bucket);
+        bucket++;
+    }
+    return (latency > histogram->max) ? histogram->max : latency;
+}
+
+/**
+ * @brief Returns the mean of the recorded latencies.
+ * @param histogram The histogram.
+ * @return The mean latency in nanoseconds, or 0 if nothing was recorded.
+ */
+double histogramMean(const LatencyHistogram *histogram)
+{
+    return (histogram->count > 0) ? (double) histogram->total / histogram->count : 0.0;
+}
@@ -0,0 +1,546 @@
+#define _POSIX_C_SOURCE 200809L  // Expose clock_gettime and clock_nanosleep
+
+#include "load_generator.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "constants.h"
+#include "data_structures.h"
+#include "engine.h"
+#include "latency_histogram.h"
+#include "money.h"
+
+#define LOAD_ZIPF_EXPONENT 1.0    // Skew of add-on popularity; the top add-on sells most
+#define LOAD_MAX_ADD_ONS 4        // Most add-ons one customer picks
+#define LOAD_MORE_ADD_ON_ODDS 35  // Percent of customers who pick another add-on after each one
+#define LOAD_CANCEL_ODDS 8        // Percent of customers who cancel at the confirmation
+#define LOAD_TOP_UP_ODDS 80       // Percent of short customers who insert more money and retry
+#define LOAD_MAX_TOP_UPS 3        // Most times one customer inserts more money
+#define LOAD_BAD_COIN_ODDS 2      // Percent of insertions that are not an accepted denomination
+#define LOAD_BAD_COIN 300         // A 3 PHP piece the machine does not accept
+#define LOAD_MIN_BUDGET 5000      // Least a customer inserts before choosing (50 PHP)
+#define LOAD_MAX_BUDGET 15000     // Most a customer plans to insert before choosing (150 PHP)
+#define LOAD_MAX_RESTOCKS 64      // Sold-out items one customer can leave for the attendant
+
+/**
+ * @brief Stages of a customer session, each timed into its own histogram.
+ */
+typedef enum
+{
+    STAGE_MONEY_IN,   // Inserting money, including top-ups after a shortfall
+    STAGE_SELECTION,  // Looking items up and adding them to the cart
+    STAGE_CHANGE,     // Working out the change or refund
+    STAGE_DISPENSE,   // Taking the change out of the register and closing the order
+    STAGE_SESSION,    // The whole session, from the customer's arrival
+    STAGE_COUNT
+} LoadStage;
+
+static const char *const stageNames[STAGE_COUNT] = {"Money In", "Selection", "Change", "Dispense",
+                                                    "Session"};
+
+/**
+ * @brief One kind of money customers pay with, and how often they reach for it.
+ */
+typedef struct
+{
+    Cents denomination;  // Amount of the bill or coin, in centavos
+    int weight;          // Relative share of insertions that use it
+} CoinMix;
+
+// What customers put in: mostly 20-100 PHP bills, some larger bills and a handful of coins
+static const CoinMix coinMix[] = {{10000, 30}, {5000, 20}, {2000, 18}, {50000, 6}, {20000, 6},
+                                  {1000, 8},   {500, 5},   {100, 4},   {25, 2},    {5, 1}};
+
+/**
+ * @brief Counters collected while generating load.
+ */
+typedef struct
+{
+    long customers;       // Customers served
+    long purchases;       // Orders confirmed and paid for
+    long cancelled;       // Orders the customer canceled at the confirmation
+    long walkAways;       // Customers who left without any add-on
+    long insertions;      // Bills and coins inserted
+    long rejectedMoney;   // Insertions rejected as invalid denominations
+    long topUps;          // Times a short customer inserted more money and retried
+    long givenUp;         // Add-ons dropped because the customer would not pay more
+    long outOfStock;      // Selections refused because the item was sold out
+    long changeRefused;   // Orders refunded because the change could not be made
+    long changeFailures;  // Change or refunds that could not be paid out exactly
+    long restocks;        // Sold-out items the attendant refilled
+    Cents revenue;        // Money kept for confirmed orders
+} LoadStats;
+
+/**
+ * @brief Everything one load run works with.
+ */
+typedef struct
+{
+    VendingMachine *machine;               // Working copy of the machine under load
+    const VendingMachine *original;        // The machine as loaded, used to refill stock
+    int eggIndex;                          // Inventory index of the default Egg
+    int riceIndex;                         // Inventory index of the default Rice
+    int *addOns;                           // Inventory indexes of the add-ons, most popular first
+    double *popularity;                    // Cumulative share of each add-on, ending at 1
+    int addOnCount;                        // Number of add-ons
+    int coinWeightTotal;                   // Sum of the coin mix weights
+    unsigned long long rng;                // State of the random number generator
+    LatencyHistogram stages[STAGE_COUNT];  // Latency of each stage
+    LoadStats stats;                       // Counters
+} LoadRun;
+
+/**
+ * @brief Returns the current monotonic time in nanoseconds.
+ */
+static long long currentTimeNs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long) now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * @brief Advances a xorshift64* generator and returns its next value.
+ */
+static unsigned long long nextRandom(unsigned long long *state)
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ull;
+}
+
+/**
+ * @brief Returns a uniform random number in (0, 1].
+ */
+static double nextUniform(unsigned long long *state)
+{
+    return ((nextRandom(state) >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * @brief Returns 1 with the given chance.
+ * @param run The load run whose generator is used.
+ * @param percent The chance, in percent.
+ */
+static int chance(LoadRun *run, int percent)
+{
+    return (int) (nextRandom(&run->rng) % 100) < percent;
+}
+
+/**
+ * @brief Picks the next bill or coin a customer inserts from the coin mix.
+ * @param run The load run.
+ * @return The amount inserted, which is occasionally one the machine does not accept.
+ */
+static Cents pickMoney(LoadRun *run)
+{
+    Cents money = LOAD_BAD_COIN;
+
+    if (!chance(run, LOAD_BAD_COIN_ODDS))
+    {
+        int ticket = (int) (nextRandom(&run->rng) % (unsigned int) run->coinWeightTotal);
+        int i = 0;
+
+        while (ticket >= coinMix[i].weight)
+        {
+            ticket -= coinMix[i].weight;
+            i++;
+        }
+        money = coinMix[i].denomination;
+    }
+    return money;
+}
+
+/**
+ * @brief Picks the add-on a customer chooses, favoring the popular ones (Zipf distribution).
+ * @param run The load run.
+ * @return The inventory index of the add-on.
+ */
+static int pickAddOn(LoadRun *run)
+{
+    double share = nextUniform(&run->rng);
+    int low = 0;
+    int high = run->addOnCount - 1;
+
+    // Binary search for the first add-on whose cumulative share covers the draw
+    while (low < high)
+    {
+        int middle = (low + high) / 2;
+
+        if (run->popularity[middle] < share)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return run->addOns[low];
+}
+
+/**
+ * @brief Inserts one bill or coin, as userMoneyInput would.
+ * @param run The load run.
+ * @param userMoney The customer's credit.
+ */
+static void insertOne(LoadRun *run, Cents *userMoney)
+{
+    run->stats.insertions++;
+    if (insertMoney(run->machine, pickMoney(run), userMoney) != ENGINE_OK)
+    {
+        run->stats.rejectedMoney++;
+    }
+}
+
+/**
+ * @brief Adds an item to the cart, topping up and retrying when the customer is short, as
+ *        processSelection lets them.
+ * @param run The load run.
+ * @param index The inventory index of the item.
+ * @param selection The customer's cart.
+ * @param userMoney The customer's credit.
+ * @param soldOut Collects items found sold out, for the attendant to refill.
+ * @param soldOutCount Number of items in soldOut.
+ * @return 1 if the item was added, 0 otherwise.
+ */
+static int selectItem(LoadRun *run, int index, UserSelection *selection, Cents *userMoney,
+                      int soldOut[], int *soldOutCount)
+{
+    CartResult result = addItemToCart(run->machine, index, selection, *userMoney);
+    int topUps = 0;
+
+    while (result.status == ENGINE_INSUFFICIENT_FUNDS && topUps < LOAD_MAX_TOP_UPS &&
+           chance(run, LOAD_TOP_UP_ODDS))
+    {
+        // Inserting the money is timed as money in, not as selection
+        long long start = currentTimeNs();
+        insertOne(run, userMoney);
+        recordLatency(&run->stages[STAGE_MONEY_IN], currentTimeNs() - start);
+
+        run->stats.topUps++;
+        topUps++;
+        result = addItemToCart(run->machine, index, selection, *userMoney);
+    }
+
+    if (result.status == ENGINE_INSUFFICIENT_FUNDS)
+    {
+        run->stats.givenUp++;
+    }
+    else if (result.status == ENGINE_OUT_OF_STOCK)
+    {
+        run->stats.outOfStock++;
+        if (*soldOutCount < LOAD_MAX_RESTOCKS)
+        {
+            soldOut[(*soldOutCount)++] = index;
+        }
+    }
+    return result.status == ENGINE_OK;
+}
+
+/**
+ * @brief Pays an amount back to the customer, timing the plan and the payout separately.
+ * @param run The load run.
+ * @param amount The change or refund, in centavos.
+ */
+static void payBack(LoadRun *run, Cents amount)
+{
+    long long start = currentTimeNs();
+    ChangeResult change = computeChange(run->machine, amount);
+    long long planned = currentTimeNs();
+
+    recordLatency(&run->stages[STAGE_CHANGE], planned - start);
+    if (change.status != ENGINE_OK || applyChange(run->machine, &change) != ENGINE_OK)
+    {
+        // Pay out what the register can, as dispenseChange does
+        change = payOutChange(run->machine, amount);
+        run->stats.changeFailures += (change.status != ENGINE_OK);
+    }
+    recordLatency(&run->stages[STAGE_DISPENSE], currentTimeNs() - planned);
+}
+
+/**
+ * @brief Runs one customer through the purchase flow: money in, a silog with add-ons, then
+ *        confirm or cancel.
+ * @param run The load run.
+ * @param arrival When the customer arrived, in nanoseconds; the session latency counts from it.
+ */
+static void runCustomer(LoadRun *run, long long arrival)
+{
+    UserSelection selection = {{{0}}, NULL, 0, 0};
+    Cents userMoney = 0;
+    Cents budget = LOAD_MIN_BUDGET +
+                   (Cents) (nextRandom(&run->rng) % (LOAD_MAX_BUDGET - LOAD_MIN_BUDGET + 1));
+    int soldOut[LOAD_MAX_RESTOCKS];
+    int soldOutCount = 0;
+    int addOnCount = 0;
+    int isRegisterShort = 0;
+
+    run->stats.customers++;
+
+    long long start = currentTimeNs();
+    while (userMoney < budget)
+    {
+        insertOne(run, &userMoney);
+    }
+    recordLatency(&run->stages[STAGE_MONEY_IN], currentTimeNs() - start);
+
+    // A silog always comes with Egg and Rice, then at least one add-on
+    start = currentTimeNs();
+    selectItem(run, run->eggIndex, &selection, &userMoney, soldOut, &soldOutCount);
+    selectItem(run, run->riceIndex, &selection, &userMoney, soldOut, &soldOutCount);
+    int wantsMore = 1;
+    for (int i = 0; i < LOAD_MAX_ADD_ONS && wantsMore; i++)
+    {
+        addOnCount += selectItem(run, pickAddOn(run), &selection, &userMoney, soldOut,
+                                 &soldOutCount);
+        wantsMore = chance(run, LOAD_MORE_ADD_ON_ODDS);
+    }
+    recordLatency(&run->stages[STAGE_SELECTION], currentTimeNs() - start);
+
+    Cents change = userMoney - selection.totalItemCost;
+    if (addOnCount == 0)
+    {
+        run->stats.walkAways++;  // processPurchase will not finalize an order without an add-on
+    }
+    else if (chance(run, LOAD_CANCEL_ODDS))
+    {
+        run->stats.cancelled++;
+    }
+    else if (!canMakeChange(run->machine, change))
+    {
+        run->stats.changeRefused++;  // getChange refunds instead of short-changing
+        isRegisterShort = 1;
+    }
+    else
+    {
+        run->stats.purchases++;
+        run->stats.revenue += selection.totalItemCost;
+        payBack(run, change);
+        resetOrderAfterConfirm(&selection, &userMoney, run->machine);
+    }
+    if (selection.count > 0 || userMoney > 0)
+    {
+        payBack(run, userMoney);
+        resetOrderAfterCancel(&selection, &userMoney, run->machine);
+    }
+    recordLatency(&run->stages[STAGE_SESSION], currentTimeNs() - arrival);
+
+    // The attendant refills sold-out items and the register between customers
+    for (int i = 0; i < soldOutCount; i++)
+    {
+        int index = soldOut[i];
+        int missing = run->original->items[index].stock - run->machine->items[index].stock;
+
+        if (missing > 0 && restockItem(run->machine, index, missing) == ENGINE_OK)
+        {
+            run->stats.restocks++;
+        }
+    }
+    if (isRegisterShort)
+    {
+        memcpy(run->machine->cash, run->original->cash,
+               (size_t) run->machine->registerSize * sizeof(CashRegister));
+        noteRegisterChanged(run->machine);
+    }
+}
+
+/**
+ * @brief Ranks the add-ons and builds the cumulative popularity table.
+ * @param run The load run, with its machine, Egg and Rice set.
+ * @return 1 if the table was built, 0 if there are no add-ons or memory ran out.
+ */
+static int buildPopularity(LoadRun *run)
+{
+    int menuSize = run->machine->menuSize;
+    double total = 0.0;
+
+    run->addOns = malloc((size_t) menuSize * sizeof(int));
+    run->popularity = malloc((size_t) menuSize * sizeof(double));
+    run->addOnCount = 0;
+    if (run->addOns != NULL && run->popularity != NULL)
+    {
+        // Add-ons keep their menu order as their popularity rank
+        for (int i = 0; i < menuSize; i++)
+        {
+            if (i != run->eggIndex && i != run->riceIndex)
+            {
+                total += 1.0 / pow(run->addOnCount + 1, LOAD_ZIPF_EXPONENT);
+                run->popularity[run->addOnCount] = total;
+                run->addOns[run->addOnCount++] = i;
+            }
+        }
+        for (int i = 0; i < run->addOnCount; i++)
+        {
+            run->popularity[i] /= total;
+        }
+        if (run->addOnCount > 0)
+        {
+            run->popularity[run->addOnCount - 1] = 1.0;  // Rounding must not leave a gap at the end
+        }
+    }
+    return run->addOnCount > 0;
+}
+
+/**
+ * @brief Prints the latency distribution of each stage.
+ * @param run The finished load run.
+ */
+static void printStages(const LoadRun *run)
+{
+    printf("\n%-12s %10s %10s %10s %10s %10s %10s\n", "Stage (ns)", "Count", "Mean", "p50",
+           "p99", "p999", "Max");
+    for (int stage = 0; stage < STAGE_COUNT; stage++)
+    {
+        const LatencyHistogram *histogram = &run->stages[stage];
+
+        printf("%-12s %10lld %10.0f %10lld %10lld %10lld %10lld\n", stageNames[stage],
+               histogram->count, histogramMean(histogram),
+               histogramPercentile(histogram, 0.50), histogramPercentile(histogram, 0.99),
+               histogramPercentile(histogram, 0.999), histogram->max);
+    }
+
+    // The session distribution, one row per power of two
+    const LatencyHistogram *session = &run->stages[STAGE_SESSION];
+    printf("\nSession latency histogram:\n");
+    for (int first = 0; first < HISTOGRAM_BUCKETS && session->count > 0;
+         first += HISTOGRAM_SUB_BUCKETS)
+    {
+        long long count = 0;
+
+        for (int bucket = first; bucket < first + HISTOGRAM_SUB_BUCKETS; bucket++)
+        {
+            count += session->counts[bucket];
+        }
+        if (count > 0)
+        {
+            int width = (int) (50 * count / session->count);
+
+            printf("  <= %10lld ns %9lld |%.*s\n",
+                   histogramBucketLimit(first + HISTOGRAM_SUB_BUCKETS - 1), count, width,
+                   "##################################################");
+        }
+    }
+}
+
+/**
+ * @brief Drives synthetic customers through the purchase flow and reports throughput and the
+ *        latency of each stage.
+ *
+ * Customers arrive as a Poisson process at the given rate, or back to back if the rate is 0.
+ * Each one inserts money from a realistic coin mix, orders a silog (the default Egg and Rice,
+ * then add-ons chosen by Zipf popularity), tops up when short, and then confirms or cancels.
+ * Session latency is measured from the scheduled arrival, so a generator that falls behind
+ * shows the queueing delay instead of hiding it. Sold-out items are refilled between customers
+ * so the load stays steady.
+ *
+ * @param machine The initial state of the machine; it is not modified.
+ * @param customerCount The number of customers to serve.
+ * @param arrivalRate Customers per second, or 0 to run as fast as possible.
+ * @param seed Seed of the random number generator, so a run can be repeated.
+ * @return 0 on success, 1 if the arguments are invalid, the menu has no silog or memory ran out.
+ */
+int runLoadGenerator(const VendingMachine *machine, long customerCount, double arrivalRate,
+                     unsigned long long seed)
+{
+    LoadRun run;
+    VendingMachine work = *machine;  // Shares the change tables built for the same denominations
+    int isReady;
+
+    memset(&run, 0, sizeof(run));
+    run.machine = &work;
+    run.original = machine;
+    run.rng = seed | 1u;  // xorshift must not start from 0
+    run.eggIndex = findItemByName(machine, "Egg");
+    run.riceIndex = findItemByName(machine, "Rice");
+    for (size_t i = 0; i < sizeof(coinMix) / sizeof(coinMix[0]); i++)
+    {
+        run.coinWeightTotal += coinMix[i].weight;
+    }
+    for (int stage = 0; stage < STAGE_COUNT; stage++)
+    {
+        initHistogram(&run.stages[stage]);
+    }
+
+    work.items = malloc((size_t) machine->menuSize * sizeof(VendingItem));
+    work.cash = malloc((size_t) machine->registerSize * sizeof(CashRegister));
+    work.journal = NULL;  // Generated customers never reach the machine's journal
+    work.sales = NULL;    // Nor its sales totals
+    isReady = (customerCount > 0 && arrivalRate >= 0 && run.eggIndex != -1 &&
+               run.riceIndex != -1 && work.items != NULL && work.cash != NULL &&
+               buildPopularity(&run));
+    if (!isReady)
+    {
+        printf("Load generation needs a positive customer count, a rate of 0 or more, memory, "
+               "and a menu with Egg, Rice and at least one add-on.\n");
+    }
+    else
+    {
+        memcpy(work.items, machine->items, (size_t) machine->menuSize * sizeof(VendingItem));
+        memcpy(work.cash, machine->cash, (size_t) machine->registerSize * sizeof(CashRegister));
+        noteRegisterChanged(&work);
+
+        long long startTime = currentTimeNs();
+        double arrival = (double) startTime;
+        for (long customer = 0; customer < customerCount; customer++)
+        {
+            if (arrivalRate > 0)
+            {
+                // Exponential gaps between arrivals make a Poisson process
+                arrival += -log(nextUniform(&run.rng)) * 1e9 / arrivalRate;
+                if (currentTimeNs() < (long long) arrival)
+                {
+                    struct timespec wake;
+
+                    wake.tv_sec = (time_t) ((long long) arrival / 1000000000LL);
+                    wake.tv_nsec = (long) ((long long) arrival % 1000000000LL);
+                    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL);
+                }
+            }
+            else
+            {
+                arrival = (double) currentTimeNs();
+            }
+            runCustomer(&run, (long long) arrival);
+        }
+        double seconds = (currentTimeNs() - startTime) / 1e9;
+
+        char amountText[MONEY_TEXT_SIZE];
+        const LoadStats *stats = &run.stats;
+        printf(SEPARATOR "\nLoad Generator Report: %ld customers", customerCount);
+        if (arrivalRate > 0)
+        {
+            printf(" at %.0f/sec", arrivalRate);
+        }
+        printf("\n" SEPARATOR "\n");
+        printf("%-22s: %ld\n", "Customers", stats->customers);
+        printf("%-22s: %ld\n", "Purchases", stats->purchases);
+        printf("%-22s: %ld\n", "Canceled", stats->cancelled);
+        printf("%-22s: %ld\n", "Walk-Aways", stats->walkAways);
+        printf("%-22s: %ld\n", "Insertions", stats->insertions);
+        printf("%-22s: %ld\n", "Invalid Money", stats->rejectedMoney);
+        printf("%-22s: %ld\n", "Top-Ups", stats->topUps);
+        printf("%-22s: %ld\n", "Add-Ons Given Up", stats->givenUp);
+        printf("%-22s: %ld\n", "Out of Stock", stats->outOfStock);
+        printf("%-22s: %ld\n", "Change Refused", stats->changeRefused);
+        printf("%-22s: %ld\n", "Change Failures", stats->changeFailures);
+        printf("%-22s: %ld\n", "Restocks", stats->restocks);
+        printf("%-22s: %s PHP\n", "Revenue", formatCents(stats->revenue, amountText));
+        printf("%-22s: %.3f s\n", "Elapsed", seconds);
+        printf("%-22s: %.0f\n", "Customers/sec", stats->customers / seconds);
+        printStages(&run);
+        printf(SEPARATOR "\n");
+    }
+
+    free(run.addOns);
+    free(run.popularity);
+    free(work.items);
+    free(work.cash);
+    return isReady ? 0 : 1;
+}
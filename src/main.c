@@ -29,39 +29,226 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include "data_management.c"
-#include "main_menu.c"
-#include "maintenance.c"
-#include "vending_machine.c"
+#include "catalog.h"
+#include "console_input.h"
+#include "data_management.h"
+#include "data_structures.h"
+#include "engine.h"
+#include "fleet_simulator.h"
+#include "journal.h"
+#include "kiosk_display.h"
+#include "load_generator.h"
+#include "main_menu.h"
+#include "maintenance.h"
+#include "money.h"
+#include "purchase_session.h"
+#include "snapshot.h"
+#include "socket_server.h"
+#include "transaction_log.h"
+#include "workload_driver.h"
 
-int main()
+int main(int argc, char *argv[])
 {
-    // Initialize vending machine items with their attributes: item number, name, price, and stock
-    // count
-    VendingItem items[] = {{1, "Hotdog", 9.50, 10}, {2, "Longganisa", 20.75, 10},
-                           {3, "Bacon", 12.00, 10}, {4, "Sausage", 35.00, 10},
-                           {5, "Tapa", 22.50, 10},  {6, "Tocino", 18.00, 10},
-                           {7, "Rice", 15.00, 10},  {8, "Egg", 8.00, 10}};
+    // Default vending machine items with their attributes: item number, name, price (in
+    // centavos), and stock count. Used when no saved inventory exists yet.
+    const VendingItem defaultItems[] = {{1, "Hotdog", 950, 10}, {2, "Longganisa", 2075, 10},
+                                        {3, "Bacon", 1200, 10}, {4, "Sausage", 3500, 10},
+                                        {5, "Tapa", 2250, 10},  {6, "Tocino", 1800, 10},
+                                        {7, "Rice", 1500, 10},  {8, "Egg", 800, 10}};
+    int defaultItemCount = sizeof(defaultItems) / sizeof(defaultItems[0]);
 
-    // Initialize the cash register with denominations and their counts
-    CashRegister cash[] = {{500, 10}, {200, 10}, {100, 10},  {50, 10},   {20, 10},  {10, 10},
-                           {5, 10},   {1, 10},   {0.25, 10}, {0.10, 10}, {0.05, 10}};
+    // Load the last snapshot of the machine, else the inventory saved at the last shutdown, else
+    // start from the default items
+    Catalog catalog;
+    initCatalog(&catalog);
+    MachineSnapshot snapshot;
+    int hasSnapshot = loadSnapshot(SNAPSHOT_FILE, &snapshot) &&
+                      copySnapshotItems(&snapshot, &catalog) && catalog.count > 0;
+    int loadedItems = hasSnapshot ? 0 : loadItemsFromCSV(&catalog, CSV_FILE);
+    if (hasSnapshot)
+    {
+        printf("Loaded %d items from %s.\n", catalog.count, SNAPSHOT_FILE);
+    }
+    else if (loadedItems > 0)
+    {
+        printf("Loaded %d items from %s.\n", loadedItems, CSV_FILE);
+    }
+    else
+    {
+        for (int i = 0; i < defaultItemCount; i++)
+        {
+            addCatalogItem(&catalog, defaultItems[i].itemNumber, defaultItems[i].name,
+                           defaultItems[i].price, defaultItems[i].stock);
+        }
+    }
 
-    float userMoney = 0.0f;  // Track the total money inserted by the user during transactions
+    // Initialize the cash register with every accepted denomination (in centavos), 10 of each
+#define INITIAL_REGISTER_SLOT(cents) {cents, 10},
+    CashRegister cash[] = {DENOMINATIONS(INITIAL_REGISTER_SLOT)};
+#undef INITIAL_REGISTER_SLOT
+    int registerSize = NUM_VALID_DENOMINATIONS;  // One register slot per accepted denomination
 
-    // Initialize UserSelection to store selected items, quantities, and costs
-    UserSelection selection = {{{0}}, {0}, {0.0}, 0, 0.0};
+    // The console customer's order: money inserted, selected items and costs, advanced by the
+    // same purchase session events as the orders of socket controllers
+    PurchaseSession console;
+    startPurchaseSession(&console, NULL, 0);
 
     // Define additional parameters for the program
-    int registerSize = 11;             // Number of cash register denominations
-    int menuSize = 8;                  // Number of vending machine items
     int userMenuSelection = 0;         // Stores the user's menu selection
-    int confirmation = 0;              // Tracks if a transaction is confirmed (1 for yes, 0 for no)
     int maintenancePassword = 123456;  // Predefined password for accessing maintenance features
     int isRunning = 1;  // Condition to control the main loop (1 for running, 0 for stop)
 
-    // Main loop: Show the main menu until the user shuts down the machine
-    while (isRunning)
+    // Bundle the inventory and cash register into the machine state used by every feature
+    VendingMachine machine;
+    if (!initVendingMachine(&machine, catalog.items, catalog.count, cash, registerSize))
+    {
+        printf("Unable to set up the vending machine.\n");
+        releaseSnapshot(&snapshot);
+        freeVendingMachine(&machine);
+        freeCatalog(&catalog);
+        return 1;
+    }
+
+    // Restore the cash register and any unfinished order kept with the snapshot's items
+    uint64_t snapshotSequence = 0;
+    if (hasSnapshot)
+    {
+        restoreSnapshot(&snapshot, &machine, &console.selection, &console.userMoney);
+        snapshotSequence = snapshot.sequence;
+    }
+    releaseSnapshot(&snapshot);
+
+    // Headless mode: replay scripted sessions instead of serving the console
+    // Usage: program --script <file> [repeat count]
+    if (argc >= 3 && strcmp(argv[1], "--script") == 0)
+    {
+        int repeatCount = (argc >= 4) ? atoi(argv[3]) : 1;
+        int exitCode = 1;
+        if (repeatCount < 1)
+        {
+            printf("Repeat count must be a positive number.\n");
+        }
+        else
+        {
+            exitCode = runWorkloadDriver(argv[2], repeatCount, &machine);
+        }
+        freeVendingMachine(&machine);
+        freeCatalog(&catalog);
+        return exitCode;
+    }
+
+    // Fleet mode: simulate many copies of this machine in parallel instead of serving the console
+    // Usage: program --fleet <machines> [sessions per machine] [threads]
+    if (argc >= 3 && strcmp(argv[1], "--fleet") == 0)
+    {
+        int sessionsPerMachine = (argc >= 4) ? atoi(argv[3]) : 1000;
+        int threadCount = (argc >= 5) ? atoi(argv[4]) : 0;  // 0 uses one thread per processor
+        int exitCode = runFleetSimulation(&machine, atoi(argv[2]), sessionsPerMachine,
+                                          threadCount);
+        freeVendingMachine(&machine);
+        freeCatalog(&catalog);
+        return exitCode;
+    }
+
+    // Load mode: drive synthetic customers through the purchase flow and time each stage
+    // Usage: program --load <customers> [customers per second] [seed]
+    if (argc >= 3 && strcmp(argv[1], "--load") == 0)
+    {
+        double arrivalRate = (argc >= 4) ? atof(argv[3]) : 0.0;  // 0 runs as fast as possible
+        unsigned long long seed = (argc >= 5) ? strtoull(argv[4], NULL, 10) : 1;
+        int exitCode = runLoadGenerator(&machine, atol(argv[2]), arrivalRate, seed);
+        freeVendingMachine(&machine);
+        freeCatalog(&catalog);
+        return exitCode;
+    }
+
+    // Kiosk mode: several front panels sell from this machine's inventory at once
+    // Usage: program --kiosks <kiosks> [sessions per kiosk]
+    if (argc >= 3 && strcmp(argv[1], "--kiosks") == 0)
+    {
+        int sessionsPerKiosk = (argc >= 4) ? atoi(argv[3]) : 100000;
+        int exitCode = runKioskSimulation(&machine, atoi(argv[2]), sessionsPerKiosk);
+        freeVendingMachine(&machine);
+        freeCatalog(&catalog);
+        return exitCode;
+    }
+
+    // Rebuild the changes made since the snapshot, including an unfinished order
+    uint64_t nextSequence;
+    int recoveredChanges = replayJournal(JOURNAL_FILE, &machine, &console.selection,
+                                         &console.userMoney, snapshotSequence, &nextSequence);
+    if (recoveredChanges > 0)
+    {
+        printf("Recovered %d changes from %s.\n", recoveredChanges, JOURNAL_FILE);
+    }
+    int isServing = (argc >= 3 && strcmp(argv[1], "--serve") == 0);
+    if (console.userMoney > 0 && !isServing)
+    {
+        char amountText[MONEY_TEXT_SIZE];
+        printf("Resuming an unfinished order with %s PHP inserted.\n",
+               formatCents(console.userMoney, amountText));
+    }
+
+    // Keep the most recent transactions in memory for the maintenance menu
+    machine.transactions = createTransactionLog();
+
+    // Server mode sells only through socket sessions, and the server snapshots the journal only
+    // when no order is open, so an unfinished console order is refunded rather than kept
+    if (isServing && (console.userMoney > 0 || console.selection.count > 0))
+    {
+        char amountText[MONEY_TEXT_SIZE];
+        ChangeResult refund = payOutChange(&machine, console.userMoney);
+
+        printf("Refunded %s PHP of the unfinished order before serving.\n",
+               formatCents(console.userMoney - refund.remaining, amountText));
+        resetOrderAfterCancel(&console.selection, &console.userMoney, &machine);
+    }
+    resumePurchaseSession(&console);  // An unfinished order picks up where it was left
+
+    // Journal every change from here on, starting from a snapshot of the recovered state
+    machine.journal = openJournal(JOURNAL_FILE, SNAPSHOT_FILE, nextSequence);
+    if (machine.journal != NULL)
+    {
+        compactJournal(machine.journal, &machine, &console.selection, console.userMoney);
+    }
+    else
+    {
+        printf("Unable to open %s; changes will not survive a crash.\n", JOURNAL_FILE);
+    }
+
+    // Server mode: kiosk controllers connect over a Unix domain socket and each runs its own order
+    // Usage: program --serve <socket file> [order timeout seconds]
+    if (isServing)
+    {
+        long long orderTimeoutMs = (argc >= 4) ? atoll(argv[3]) * 1000 : SESSION_TIMEOUT_MS;
+        int exitCode = runSocketServer(&machine, argv[2], maintenancePassword, orderTimeoutMs);
+
+        // Every served order has ended by now; snapshot the state they leave behind
+        if (machine.journal != NULL)
+        {
+            compactJournal(machine.journal, &machine, NULL, 0);
+        }
+        if (machine.journal == NULL || !closeJournal(machine.journal))
+        {
+            printf("Unable to snapshot the machine to %s.\n", SNAPSHOT_FILE);
+        }
+        destroyTransactionLog(machine.transactions);
+        freeVendingMachine(&machine);
+        freeCatalog(&catalog);
+        return exitCode;
+    }
+
+    // Kiosk display: keep the tables in a fixed panel and redraw only the rows that change
+    // Usage: program --kiosk-display
+    int isDeltaRequested = (argc >= 2 && strcmp(argv[1], "--kiosk-display") == 0);
+    if (!openDisplay(isDeltaRequested, machine.menuSize) && isDeltaRequested)
+    {
+        printf("The kiosk display needs an ANSI terminal tall enough for the menu; tables will "
+               "be redrawn in full.\n");
+    }
+
+    // Main loop: Show the main menu until the user shuts down the machine or input ends
+    while (isRunning && !isInputClosed())
     {
         // Display the main menu and get the user's selection
         int displayMenu;
@@ -71,17 +258,16 @@ int main()
         switch (displayMenu)
         {
             case 1:  // Purchase items
-                processPurchase(items, menuSize, &userMoney, cash, registerSize, &selection,
-                                &confirmation);
+                processPurchase(&machine, &console);
                 break;
 
             case 2:  // Maintenance options
                 // Validate the password before granting access to maintenance features
                 if (maintenanceValidation(&maintenancePassword))
                 {
-                    handleMaintenanceOptions(items, menuSize, cash, registerSize);
+                    handleMaintenanceOptions(&machine);
                 }
-                else
+                else if (!isInputClosed())
                 {
                     printf("Wrong password\n");
                 }
@@ -92,20 +278,46 @@ int main()
                 if (maintenanceValidation(&maintenancePassword))
                 {
                     printf("Machine going offline...\n");
-                    saveItemsToCSV(items, menuSize);  // Save the inventory state to a CSV file
-                    isRunning = 0;                    // Stop the main loop
+                    // Save the inventory state to a CSV file
+                    if (saveItemsToCSV(machine.items, machine.menuSize))
+                    {
+                        printf("Data saved to %s successfully.\n", CSV_FILE);
+                    }
+                    // Snapshot the full state so the next startup has no journal to replay
+                    if (machine.journal != NULL)
+                    {
+                        compactJournal(machine.journal, &machine, &console.selection,
+                                       console.userMoney);
+                    }
+                    isRunning = 0;  // Stop the main loop
                 }
-                else
+                else if (!isInputClosed())
                 {
                     printf("Wrong password\n");
                 }
                 break;
 
             default:  // Invalid menu selection
-                printf("Invalid selection. Please try again.\n");
+                if (!isInputClosed())
+                {
+                    printf("Invalid selection. Please try again.\n");
+                }
                 break;
         }
     }
+    if (isInputClosed())
+    {
+        // No prompt can be answered any more; an open order stays in the journal for next time
+        printf("\nInput closed, shutting down.\n");
+    }
 
-    return 0;  // Exit the program successfully
+    if (!closeJournal(machine.journal))  // Write out the last journaled changes
+    {
+        printf("Some changes could not be written to %s.\n", JOURNAL_FILE);
+    }
+    closeDisplay();                               // Give the whole screen back to the shell
+    destroyTransactionLog(machine.transactions);  // Release the recent transactions
+    freeVendingMachine(&machine);                 // Release the change-making tables and indexes
+    freeCatalog(&catalog);                        // Release the inventory
+    return 0;                                     // Exit the program successfully
 }
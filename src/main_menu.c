@@ -2,9 +2,12 @@
 
 #include <stdio.h>
 
+#include "console_input.h"
 #include "constants.h"
 #include "data_structures.h"
+#include "engine.h"
 #include "maintenance.h"
+#include "purchase_session.h"
 #include "vending_machine.h"
 
 /**
@@ -25,12 +28,16 @@ int handleMenuSelection(int userMenuSelection)
 
     // Prompt the user for input
     printf("Please enter your choice: ");
-    int scanResult = scanf("%d", &userMenuSelection);
+    int scanResult = readInt(&userMenuSelection);
 
-    // Validate user input
-    if (scanResult != 1)
+    // Validate user input; once input has ended there is nothing to complain about
+    if (scanResult != 1 && !isInputClosed())
     {
         printf("Invalid input. Please enter a number corresponding to the menu options.\n");
+        discardLine();           // Skip the rest of the invalid line
+    }
+    if (scanResult != 1)
+    {
         userMenuSelection = -1;  // Assign a default invalid value
     }
 
@@ -39,63 +46,63 @@ int handleMenuSelection(int userMenuSelection)
 
 /**
  * @brief Handles the complete purchase process in the vending machine.
-
- * @param availableItems Array of VendingItem structures representing the items.
- * @param itemCount The number of items in the availableItems array.
- * @param insertedMoney Pointer to a float representing the user's total money available.
- * @param cashRegister Array of CashRegister structures representing the available denominations.
- * @param cashRegisterSize The number of denominations in the cashRegister array.
- * @param userSelection Pointer to a UserSelection structure to store the user's selection.
- * @param orderConfirmation Pointer to an integer indicates if transaction is confirmed.
+ *
+ * Each prompt answer is turned into an event of the customer's purchase session, so the console
+ * follows the same order flow and silog rules as a socket controller.
+ *
+ * @param machine The vending machine the user is buying from.
+ * @param session The customer's purchase session, which may hold an order resumed after a crash.
  * @pre The arrays availableItems and cashRegister must be initialized and contain valid data.
  */
-void processPurchase(VendingItem availableItems[], int itemCount, float *insertedMoney,
-                     CashRegister cashRegister[], int cashRegisterSize,
-                     UserSelection *userSelection, int *orderConfirmation)
+void processPurchase(VendingMachine *machine, PurchaseSession *session)
 {
     int continueVending = 1;  // Control flag for repeating the vending process
 
     do
     {
         // Display available items in the vending machine
-        displayItems(availableItems, itemCount);
+        displayItems(machine);
 
         // Prompt the user to input money
-        userMoneyInput(insertedMoney, cashRegister, cashRegisterSize);
-
-        // Allow the user to select items and adjust total money and stock accordingly
-        selectItems(availableItems, itemCount, userSelection, insertedMoney, cashRegister,
-                    cashRegisterSize);
+        userMoneyInput(session, machine);
 
-        // Calculate change and confirm the transaction
-        getChange(cashRegister, insertedMoney, cashRegisterSize, &userSelection->totalItemCost,
-                  orderConfirmation);
+        // Allow the user to select items until the order is checked out
+        selectItems(machine, session);
 
-        if (*orderConfirmation)
+        // Confirm or cancel the order; the session pays out the change or refund and logs it
+        int isSold = !isInputClosed() && getChange(machine, session);
+        if (isSold)
         {
-            // Complete the transaction by finalizing the order
-            resetOrderAfterConfirm(userSelection, insertedMoney);
+            printf("Get Natsilog from Traybin\n");
             printf("\nTransaction completed successfully.\n" SEPARATOR);
         }
-        else
+        else if (!isInputClosed())
         {
-            // Cancel the transaction, returning stock and refunding money
-            resetOrderAfterCancel(userSelection, insertedMoney, availableItems, itemCount);
             printf("\nOrder has been canceled.\n");
         }
 
         // Prompt the user to restart or exit the vending process
-        int scanResult;
-        printf("\nStart Vending Again?\n1. Yes\n0. Return to Main Menu: ");
-        scanResult = scanf("%d", &continueVending);
+        int scanResult = 0;
+        if (!isInputClosed())
+        {
+            printf("\nStart Vending Again?\n1. Yes\n0. Return to Main Menu: ");
+            scanResult = readInt(&continueVending);
+        }
 
         // Validate user input for restarting or exiting
-        while (scanResult != 1 || (continueVending != 1 && continueVending != 0))
+        while (!isInputClosed() &&
+               (scanResult != 1 || (continueVending != 1 && continueVending != 0)))
         {
-            while (getchar() != '\n');  // Clear invalid input from the buffer
+            discardLine();  // Clear invalid input from the buffer
             printf(
                 "Invalid input! Please enter 1 to start again or 0 to return to the main menu: ");
-            scanResult = scanf("%d", &continueVending);
+            scanResult = readInt(&continueVending);
+        }
+
+        // Input ended mid-order: the order stays open in the journal for the next start
+        if (scanResult != 1)
+        {
+            continueVending = -1;
         }
 
     } while (continueVending == 1);  // Loop if the user chooses to continue vending
@@ -108,14 +115,10 @@ void processPurchase(VendingItem availableItems[], int itemCount, float *inserte
 
 /**
  * @brief Displays the maintenance menu, allowing the user to manage inventory and cash register.
- * @param items Array of VendingItem structures representing the inventory.
- * @param menuSize The number of items in the inventory array.
- * @param cashRegister Array of CashRegister structures representing the available denominations.
- * @param cashRegisterSize The number of denominations in the cashRegister array.
+ * @param machine The vending machine whose inventory and cash register are managed.
  * @pre The arrays items and cashRegister must be initialized and contain valid data.
  */
-void handleMaintenanceOptions(VendingItem items[], int menuSize, CashRegister cashRegister[],
-                              int cashRegisterSize)
+void handleMaintenanceOptions(VendingMachine *machine)
 {
     int maintenanceSelection;
     int exitMaintenance = 0;  // Control flag for exiting the maintenance menu
@@ -127,23 +130,29 @@ void handleMaintenanceOptions(VendingItem items[], int menuSize, CashRegister ca
                "\nMaintenance Features\n"
                "1 - Inventory Features\n"
                "2 - Cash Register Features\n"
+               "3 - Performance Statistics\n"
+               "4 - Transaction History\n"
                "0 - Exit Maintenance Menu\n"
                "\nEnter your choice: ");
 
         int scanResult;
-        scanResult = scanf("%d", &maintenanceSelection);
+        scanResult = readInt(&maintenanceSelection);
 
         // Validate menu selection input
-        while (scanResult != 1)
+        while (scanResult != 1 && !isInputClosed())
+        {
+            printf("Invalid input. Please enter a number between 0 and 4.\n");
+            discardLine();  // Clear invalid input
+            scanResult = readInt(&maintenanceSelection);
+        }
+        if (scanResult != 1)
         {
-            printf("Invalid input. Please enter a number between 0 and 2.\n");
-            while (getchar() != '\n');  // Clear invalid input
-            scanResult = scanf("%d", &maintenanceSelection);
+            maintenanceSelection = 0;  // Input ended; leave the menu
         }
 
-        if (maintenanceSelection < 0 || maintenanceSelection > 2)
+        if (maintenanceSelection < 0 || maintenanceSelection > 4)
         {
-            printf("Invalid choice. Please enter a number between 0 and 2.\n");
+            printf("Invalid choice. Please enter a number between 0 and 4.\n");
         }
         else
         {
@@ -162,35 +171,43 @@ void handleMaintenanceOptions(VendingItem items[], int menuSize, CashRegister ca
                                "1 - View Inventory\n"
                                "2 - Set Item Price\n"
                                "3 - Restock Item\n"
+                               "4 - Sales Report\n"
                                "0 - Back to Maintenance Menu\n"
                                "\nEnter your choice: ");
 
-                        scanResult = scanf("%d", &inventorySelection);
+                        scanResult = readInt(&inventorySelection);
 
                         // Validate inventory menu selection input
-                        while (scanResult != 1)
+                        while (scanResult != 1 && !isInputClosed())
                         {
-                            printf("Invalid input. Please enter a number between 0 and 3.\n");
-                            while (getchar() != '\n');  // Clear invalid input
-                            scanResult = scanf("%d", &inventorySelection);
+                            printf("Invalid input. Please enter a number between 0 and 4.\n");
+                            discardLine();  // Clear invalid input
+                            scanResult = readInt(&inventorySelection);
+                        }
+                        if (scanResult != 1)
+                        {
+                            inventorySelection = 0;  // Input ended; leave the menu
                         }
 
-                        if (inventorySelection < 0 || inventorySelection > 3)
+                        if (inventorySelection < 0 || inventorySelection > 4)
                         {
-                            printf("Invalid choice. Please enter a number between 0 and 3.\n");
+                            printf("Invalid choice. Please enter a number between 0 and 4.\n");
                         }
                         else
                         {
                             switch (inventorySelection)
                             {
                                 case 1:
-                                    viewInventory(items, menuSize);  // Display inventory
+                                    viewInventory(machine);  // Display inventory
                                     break;
                                 case 2:
-                                    modifyPrice(items, menuSize);  // Modify item prices
+                                    modifyPrice(machine);  // Modify item prices
                                     break;
                                 case 3:
-                                    restockInventory(items, menuSize);  // Restock inventory
+                                    restockInventory(machine);  // Restock inventory
+                                    break;
+                                case 4:
+                                    viewSalesReport(machine);  // Display top sellers
                                     break;
                                 case 0:
                                     exitInventory = 1;  // Exit inventory submenu
@@ -216,14 +233,18 @@ void handleMaintenanceOptions(VendingItem items[], int menuSize, CashRegister ca
                                "0 - Back to Maintenance Menu\n"
                                "\nEnter your choice: ");
 
-                        scanResult = scanf("%d", &cashRegisterSelection);
+                        scanResult = readInt(&cashRegisterSelection);
 
                         // Validate cash register menu selection input
-                        while (scanResult != 1)
+                        while (scanResult != 1 && !isInputClosed())
                         {
                             printf("Invalid input. Please enter a number between 0 and 3.\n");
-                            while (getchar() != '\n');  // Clear invalid input
-                            scanResult = scanf("%d", &cashRegisterSelection);
+                            discardLine();  // Clear invalid input
+                            scanResult = readInt(&cashRegisterSelection);
+                        }
+                        if (scanResult != 1)
+                        {
+                            cashRegisterSelection = 0;  // Input ended; leave the menu
                         }
 
                         if (cashRegisterSelection < 0 || cashRegisterSelection > 3)
@@ -235,15 +256,13 @@ void handleMaintenanceOptions(VendingItem items[], int menuSize, CashRegister ca
                             switch (cashRegisterSelection)
                             {
                                 case 1:
-                                    viewCashRegister(cashRegister,
-                                                     cashRegisterSize);  // View denominations
+                                    viewCashRegister(machine);  // View denominations
                                     break;
                                 case 2:
-                                    reStockRegister(cashRegister,
-                                                    cashRegisterSize);  // Restock cash register
+                                    reStockRegister(machine);  // Restock cash register
                                     break;
                                 case 3:
-                                    cashOut(cashRegister, cashRegisterSize);  // Perform cash out
+                                    cashOut(machine);  // Perform cash out
                                     break;
                                 case 0:
                                     exitCashRegister = 1;  // Exit cash register submenu
@@ -253,6 +272,12 @@ void handleMaintenanceOptions(VendingItem items[], int menuSize, CashRegister ca
                     }
                     break;
                 }
+                case 3:  // Performance Statistics
+                    viewPerformanceStatistics();
+                    break;
+                case 4:  // Transaction History
+                    viewTransactionHistory(machine);
+                    break;
                 case 0:  // Exit Maintenance Menu
                     exitMaintenance = 1;
                     printf("Exiting Maintenance Menu...\n");
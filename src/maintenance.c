@@ -1,9 +1,20 @@
 #include "maintenance.h"
 
-#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
 
+#include "console_input.h"
 #include "constants.h"
 #include "data_structures.h"
+#include "engine.h"
+#include "latency_histogram.h"
+#include "money.h"
+#include "perf_counters.h"
+#include "transaction_log.h"
+#include "vending_machine.h"
+
+#define HISTORY_PAGE_SIZE 5  // Transactions shown per page of the transaction history
 
 /**
  * @brief Validates the maintenance password input from the user.
@@ -16,18 +27,21 @@ int maintenanceValidation(int *maintenancePassword)
     // Declare variables
     int passwordInput;  // To store the user input for password
     int isValid = 0;    // Default value: invalid password (0)
-    int scanfResult;
+    int readResult;
 
     // Prompt the user to input the maintenance password
     printf("\nInput maintenance password: ");
 
     // Check if the input is a valid integer
-    scanfResult = scanf("%d", &passwordInput);
-    if (scanfResult != 1)
+    readResult = readInt(&passwordInput);
+    if (readResult != 1)
     {
-        // If the input is not a valid
-        printf("Invalid input. Please enter a numerical password.\n");
-        while (getchar() != '\n');  // Clear the input buffer to ensure clean input
+        // If the input is not a valid; once input has ended there is nothing to complain about
+        if (!isInputClosed())
+        {
+            printf("Invalid input. Please enter a numerical password.\n");
+        }
+        discardLine();  // Clear the input buffer to ensure clean input
     }
     else
     {
@@ -51,57 +65,32 @@ int maintenanceValidation(int *maintenancePassword)
 
 /**
  * @brief Displays the list of vending items with their details.
- * @param items An array of VendingItem structures containing item details.
- * @param menuSize The total number of items in the items array.
+ * @param machine The vending machine whose inventory is displayed.
  * @pre The items array should be populated with valid `VendingItem` structures.
  */
-void viewInventory(VendingItem items[], int menuSize)
+void viewInventory(VendingMachine *machine)
 {
-    int i;
-    // Print header for the item details table
-    printf("\n\n%-12s | %-15s | %-10s | %-10s\n", "Item Number", "Item Name", "Price (PHP)",
-           "Stock Left");
-    printf(SEPARATOR "\n");
-
-    // Loop through the items array to display each item's details
-    for (i = 0; i < menuSize; i++)
-    {
-        // Declare and initialize variables for item details
-        int itemNumber = items[i].itemNumber;  // Item number
-        char *itemName = items[i].name;        // Item name
-        float itemPrice = items[i].price;      // Item price
-        int itemStock = items[i].stock;        // Item stock
-
-        // Display item details in a formatted table
-        printf("%-12d | %-15s | %-11.2f | %-3d", itemNumber, itemName, itemPrice, itemStock);
-
-        // Check if the item is out of stock and print an out-of-stock message if applicable
-        if (itemStock <= 0)
-        {
-            printf(" %-12s", OUT_OF_STOCK_MSG);  // Display "Out of Stock" message
-        }
-
-        // Move to the next line after displaying an item's details
-        printf("\n");
-    }
-
-    // Print footer for the item details table
-    printf(SEPARATOR "\n");
+    // Staff see the same table as customers, so a kiosk display only redraws what changed
+    displayItems(machine);
 }
 
 /**
  * @brief Modifies the price of a specific item in the vending machine menu.
- * @param items Array of VendingItem structures representing the vending machine menu items.
- * @param menuSize The total number of items in the vending machine menu.
+ * @param machine The vending machine whose menu prices are modified.
  * @pre The items array must be populated with valid VendingItem structures.
  */
-void modifyPrice(VendingItem items[], int menuSize)
+void modifyPrice(VendingMachine *machine)
 {
+    VendingItem *items = machine->items;  // Items of the machine
+    int menuSize = machine->menuSize;     // Number of items in the machine
+
     int modifyItemNumber;  // Variable to store the user input for item number
-    int itemFound;         // Flag indicating if the item is found in the menu
-    int result;            // Result of input validation (scanf return value)
+    int itemIndex;         // Index of the item in the menu, or -1 if it is not found
+    int result;            // Result of input validation (1 if a value was read)
     int retry;             // Flag to control the retry process
 
+    char priceText[MONEY_TEXT_SIZE];  // Current price formatted for display
+
     // Display the list of menu items with item numbers, names, and current prices
     printf("\n%-12s | %-15s | %-10s\n", "Item Number", "Item Name", "Price (PHP)");
     printf(SEPARATOR "\n");
@@ -109,7 +98,8 @@ void modifyPrice(VendingItem items[], int menuSize)
     // Display all items in the vending machine
     for (int i = 0; i < menuSize; i++)
     {
-        printf("%-12d | %-15s | %-10.2f\n", items[i].itemNumber, items[i].name, items[i].price);
+        printf("%-12d | %-15s | %-10s\n", items[i].itemNumber, items[i].name,
+               formatCents(items[i].price, priceText));
     }
     printf(SEPARATOR "\n");
 
@@ -119,51 +109,51 @@ void modifyPrice(VendingItem items[], int menuSize)
     {
         // Prompt the user to enter the item number they wish to modify
         printf("Enter the item number to modify: ");
-        result = scanf("%d", &modifyItemNumber);
+        result = readInt(&modifyItemNumber);
 
         // Validate the input for item number
-        if (result != 1)
+        if (result != 1 && isInputClosed())
+        {
+            retry = 0;  // Input ended; leave the prices as they are
+        }
+        else if (result != 1)
         {
             printf("Invalid input. Please enter a valid item number.\n");
-            while (getchar() != '\n');  // Clear the input buffer to ensure clean input
+            discardLine();  // Clear the input buffer to ensure clean input
             retry = 1;                  // Keep retrying until valid input
         }
         else
         {
-            itemFound = 0;  // Reset item found flag before searching
-
             // Search for the item in the menu based on item number
-            for (int j = 0; j < menuSize; j++)
-            {
-                if (items[j].itemNumber == modifyItemNumber)
-                {
-                    itemFound = 1;  // Mark the item as found
+            itemIndex = findItemByNumber(machine, modifyItemNumber);
 
-                    // Prompt the user to enter a new price
-                    float newPrice;
-                    printf("Enter the new price: ");
-                    result = scanf("%f", &newPrice);
+            if (itemIndex != -1)
+            {
+                // Prompt the user to enter a new price
+                Cents newPrice;
+                printf("Enter the new price: ");
+                result = readCents(&newPrice);
 
-                    // Validate the new price input
-                    if (result != 1 || newPrice <= 0)
-                    {
-                        printf("\nError: Please enter a valid positive number for the price.\n");
-                        while (getchar() != '\n');  // Clear input buffer on invalid price
-                        retry = 1;                  // Retry on invalid price input
-                    }
-                    else
-                    {
-                        // Update the item's price with the new value
-                        items[j].price = newPrice;
-                        printf("Price updated successfully!\n");
-                        retry = 0;  // Exit the loop after successful price update
-                    }
+                // Validate the new price input and update the item's price with the new value
+                if (result != 1 && isInputClosed())
+                {
+                    retry = 0;  // Input ended; leave the price as it is
+                }
+                else if (result != 1 || setItemPrice(machine, itemIndex, newPrice) != ENGINE_OK)
+                {
+                    printf("\nError: Please enter a valid positive number for the price.\n");
+                    discardLine();  // Clear input buffer on invalid price
+                    retry = 1;                  // Retry on invalid price input
+                }
+                else
+                {
+                    printf("Price updated successfully!\n");
+                    retry = 0;  // Exit the loop after successful price update
                 }
             }
-
-            // If no item was found with the entered item number, prompt the user to retry
-            if (itemFound == 0)
+            else
             {
+                // If no item was found with the entered item number, prompt the user to retry
                 printf("Invalid Item Number! No item found with the entered number.\n");
                 retry = 1;  // Retry if the item number is invalid
             }
@@ -173,18 +163,19 @@ void modifyPrice(VendingItem items[], int menuSize)
 
 /**
  * @brief Allows staff to restock items in the vending machine inventory.
- * @param items Array of `VendingItem` structures representing the inventory.
- * @param menuSize The total number of items in the vending machine inventory.
+ * @param machine The vending machine whose inventory is restocked.
  * @pre The item` array should contain valid VendingItem structures.
  */
-void restockInventory(VendingItem items[], int menuSize)
+void restockInventory(VendingMachine *machine)
 {
-    int modifyItemNumber;  // Declare the item number to modify
-    int reStock;           // Declare the quantity of stock to add
-    int isValid;           // Flag to indicate if the item number is valid
-    int result;            // For storing the result of input validation
-    int retry;             // Flag to control the retry mechanism
-    int i, j;              // Loop variables for displaying items and searching for item number
+    VendingItem *items = machine->items;  // Items of the machine
+    int menuSize = machine->menuSize;     // Number of items in the machine
+    int modifyItemNumber;                 // Declare the item number to modify
+    int reStock;                          // Declare the quantity of stock to add
+    int itemIndex;                        // Index of the item to restock, or -1 if not found
+    int result;                           // For storing the result of input validation
+    int retry;                            // Flag to control the retry mechanism
+    int i;                                // Loop variable for displaying items
 
     // Display the inventory with item numbers, names, and current stock levels
     printf("\n%-12s | %-15s | %-10s\n", "Item Number", "Item Name", "Stock Left");
@@ -209,50 +200,50 @@ void restockInventory(VendingItem items[], int menuSize)
     {
         // Prompt for the item number to modify
         printf("Input item number to modify: ");
-        result = scanf("%d", &modifyItemNumber);
+        result = readInt(&modifyItemNumber);
 
         // Validate the input for the item number
-        if (result != 1)
+        if (result != 1 && isInputClosed())
+        {
+            retry = 0;  // Input ended; leave the stock as it is
+        }
+        else if (result != 1)
         {
             printf("Invalid input. Please enter a valid item number.\n");
-            while (getchar() != '\n');  // Clear the input buffer to ensure clean input
+            discardLine();  // Clear the input buffer to ensure clean input
             retry = 1;                  // Keep retrying until valid input is provided
         }
         else
         {
-            isValid = 0;  // Reset validity flag before searching for the item
-
             // Search for the item based on the entered item number
-            for (j = 0; j < menuSize; j++)
-            {
-                if (items[j].itemNumber == modifyItemNumber)
-                {
-                    isValid = 1;  // Mark the item as valid if it is found
+            itemIndex = findItemByNumber(machine, modifyItemNumber);
 
-                    // Prompt for the quantity of stock to add
-                    printf("Input stock to add: ");
-                    result = scanf("%d", &reStock);
+            if (itemIndex != -1)
+            {
+                // Prompt for the quantity of stock to add
+                printf("Input stock to add: ");
+                result = readInt(&reStock);
 
-                    // Validate the stock quantity input
-                    if (result != 1 || reStock <= 0)
-                    {
-                        printf("\nYou must input a positive number for stock addition.\n");
-                        while (getchar() != '\n');  // Clear the input buffer
-                        retry = 1;                  // Retry if quantity input is invalid
-                    }
-                    else
-                    {
-                        // Update the item's stock with the added quantity
-                        items[j].stock += reStock;
-                        printf("Stock updated successfully.\n");
-                        retry = 0;  // Exit loop after successful stock update
-                    }
+                // Validate the stock quantity input and add it to the item's stock
+                if (result != 1 && isInputClosed())
+                {
+                    retry = 0;  // Input ended; leave the stock as it is
+                }
+                else if (result != 1 || restockItem(machine, itemIndex, reStock) != ENGINE_OK)
+                {
+                    printf("\nYou must input a positive number for stock addition.\n");
+                    discardLine();  // Clear the input buffer
+                    retry = 1;                  // Retry if quantity input is invalid
+                }
+                else
+                {
+                    printf("Stock updated successfully.\n");
+                    retry = 0;  // Exit loop after successful stock update
                 }
             }
-
-            // If the item number was invalid (not found), prompt the user to retry
-            if (isValid == 0)
+            else
             {
+                // If the item number was invalid (not found), prompt the user to retry
                 printf("Invalid Item Number! Please try again.\n");
                 retry = 1;  // Retry on invalid item number
             }
@@ -262,15 +253,18 @@ void restockInventory(VendingItem items[], int menuSize)
 
 /**
  * @brief Displays the contents of the cash register in a tabular format.
- * @param cashRegister Array of CashRegister structures.
- * @param cashRegisterSize Number of entries in the cashRegister array, corresponding to
- *                         the total number of different denominations stored.
+ * @param machine The vending machine whose cash register is displayed.
  * @pre cashRegister must be a valid array of CashRegister structures.
  */
-void viewCashRegister(CashRegister cashRegister[], int cashRegisterSize)
+void viewCashRegister(VendingMachine *machine)
 {
-    float totalAmount = 0.0f;  // Initialize total cash amount to 0
-    int i;                     // Loop variable for iterating through cash denominations
+    CashRegister *cashRegister = machine->cash;    // Denominations held by the register
+    int cashRegisterSize = machine->registerSize;  // Number of denominations in the register
+    Cents totalAmount = 0;                         // Initialize total cash amount to 0
+    int i;  // Loop variable for iterating through cash denominations
+
+    char denominationText[MONEY_TEXT_SIZE];  // Denomination formatted for display
+    char totalText[MONEY_TEXT_SIZE];         // Total value formatted for display
 
     // Print the header for the cash register table
     printf("\n%-20s | %-15s | %-15s |\n", "Denomination (PHP)", "Amount Left", "Total Value (PHP)");
@@ -279,7 +273,7 @@ void viewCashRegister(CashRegister cashRegister[], int cashRegisterSize)
     // Iterate through each denomination in the cash register
     for (i = 0; i < cashRegisterSize; i++)
     {
-        float denominationTotal;  // Calculate total value for the current denomination
+        Cents denominationTotal;  // Calculate total value for the current denomination
 
         // Calculate the total value for this denomination
         denominationTotal = cashRegister[i].cashDenomination * cashRegister[i].amountLeft;
@@ -287,97 +281,102 @@ void viewCashRegister(CashRegister cashRegister[], int cashRegisterSize)
         // Accumulate the total cash amount
         totalAmount += denominationTotal;
 
+        // Format the denomination and its total value for display
+        formatCents(cashRegister[i].cashDenomination, denominationText);
+        formatCents(denominationTotal, totalText);
+
         // Print details for this denomination
-        printf("| %-18.2f | %-13d | %-15.2f |\n",
-               cashRegister[i].cashDenomination,  // Cash denomination value
-               cashRegister[i].amountLeft,        // Amount of this denomination left
-               denominationTotal);                // Total value for this denomination
+        printf("| %-18s | %-13d | %-15s |\n",
+               denominationText,            // Cash denomination value
+               cashRegister[i].amountLeft,  // Amount of this denomination left
+               totalText);                  // Total value for this denomination
     }
 
     printf(SEPARATOR "\n");
 
     // Display the total cash available in the register
-    printf("| %-38s PHP %-14.2f |\n", "Total Cash in Register:", totalAmount);
+    printf("| %-38s PHP %-14s |\n", "Total Cash in Register:", formatCents(totalAmount, totalText));
 }
 
 /**
  * @brief Handles the process of restocking a cash register with a specific denomination and
  * quantity.
- * @param cashRegister An array of CashRegister structures, each representing a denomination
- *                     and the available quantity in the cash register.
- * @param cashRegisterSize The size of the cashRegister array, representing the number of
- *                         different denominations available in the register.
+ * @param machine The vending machine whose cash register is restocked.
  * @pre The cashRegister array should be populated with valid denominations and quantities.
  */
-void reStockRegister(CashRegister cashRegister[], int cashRegisterSize)
+void reStockRegister(VendingMachine *machine)
 {
-    float denomination;         // Denomination to restock
+    Cents denomination;         // Denomination to restock
     int quantity;               // Quantity to add to the denomination
     int validDenomination = 0;  // Flag to check if the entered denomination is valid
     int validQuantity = 0;      // Flag to check if the entered quantity is valid
-    int scanResult;             // Result of scanf for denomination
-    int i;                      // Loop variable for searching through cash register
-    int quantityScanResult;     // Result of scanf for quantity input
+    int scanResult;             // Result of reading the denomination
+    int slot;                   // Register slot holding the entered denomination
+    int quantityScanResult;     // Result of reading the quantity
+
+    char denominationText[MONEY_TEXT_SIZE];  // Denomination formatted for display
 
     // Display the current cash register contents to the user
-    viewCashRegister(cashRegister, cashRegisterSize);
+    viewCashRegister(machine);
 
     // Loop until a valid denomination and valid quantity are provided
     validDenomination = 0;  // Reset the flag at the beginning
-    while (validDenomination == 0)
+    while (validDenomination == 0 && !isInputClosed())
     {
         // Prompt the user to enter the denomination to restock
         printf("\nEnter the denomination to restock: ");
-        scanResult = scanf("%f", &denomination);
+        scanResult = readCents(&denomination);
 
-        // Check if the input is a valid float for the denomination
+        // Check if the input is a valid amount for the denomination
         if (scanResult != 1)
         {
-            printf("Invalid input. Please enter a valid denomination.\n");
-            while (getchar() != '\n');  // Clear the input buffer
+            if (!isInputClosed())  // Input that has ended stops the loop without complaint
+            {
+                printf("Invalid input. Please enter a valid denomination.\n");
+            }
+            discardLine();  // Clear the input buffer
         }
         else
         {
-            validDenomination = 0;  // Reset the flag before searching for the denomination
-
             // Search for the entered denomination in the cash register
-            for (i = 0; i < cashRegisterSize; i++)
+            slot = findDenominationSlot(machine, denomination);
+
+            if (slot != -1)
             {
-                if (cashRegister[i].cashDenomination == denomination)
+                validDenomination = 1;  // Denomination found
+
+                // Reset validQuantity flag and loop to get valid quantity input
+                validQuantity = 0;
+                while (validQuantity == 0 && !isInputClosed())
                 {
-                    validDenomination = 1;  // Denomination found
+                    // Prompt the user to enter the quantity to add
+                    printf("Enter the quantity to add (positive number only): ");
+                    quantityScanResult = readInt(&quantity);
 
-                    // Reset validQuantity flag and loop to get valid quantity input
-                    validQuantity = 0;
-                    while (validQuantity == 0)
+                    // Validate the quantity input and update the cash register with it
+                    if (quantityScanResult != 1 ||
+                        restockRegister(machine, denomination, quantity) != ENGINE_OK)
                     {
-                        // Prompt the user to enter the quantity to add
-                        printf("Enter the quantity to add (positive number only): ");
-                        quantityScanResult = scanf("%d", &quantity);
-
-                        // Validate the quantity input
-                        if (quantityScanResult != 1 || quantity <= 0)
+                        if (!isInputClosed())  // Input that has ended stops the loop quietly
                         {
                             printf(
                                 "Invalid quantity. Please enter a positive number greater than "
                                 "zero.\n");
-                            while (getchar() != '\n');  // Clear the input buffer
-                        }
-                        else
-                        {
-                            // Update the cash register with the new quantity
-                            cashRegister[i].amountLeft += quantity;
-                            printf("Successfully added %d to %.2f PHP denomination.\n", quantity,
-                                   cashRegister[i].cashDenomination);
-                            validQuantity = 1;  // Mark quantity as valid
                         }
+                        discardLine();  // Clear the input buffer
+                    }
+                    else
+                    {
+                        printf("Successfully added %d to %s PHP denomination.\n", quantity,
+                               formatCents(machine->cash[slot].cashDenomination,
+                                           denominationText));
+                        validQuantity = 1;  // Mark quantity as valid
                     }
                 }
             }
-
-            // If the denomination was not found in the register, prompt the user again
-            if (validDenomination == 0)
+            else
             {
+                // If the denomination was not found in the register, prompt the user again
                 printf(
                     "Invalid denomination. Please select a valid denomination from the "
                     "register.\n");
@@ -388,12 +387,11 @@ void reStockRegister(CashRegister cashRegister[], int cashRegisterSize)
 
 /**
  * @brief Handles the cash-out operation from the vending machine's cash register.
- * @param cashRegister Array of CashRegister structures representing the current cash register.
- * @param cashRegisterSize Number of entries in the cashRegister array.
+ * @param machine The vending machine whose cash register is cashed out.
  * @pre cashRegister must be a valid array of CashRegister, the register must contain valid
  * denominations and quantities.
  */
-void cashOut(CashRegister cashRegister[], int cashRegisterSize)
+void cashOut(VendingMachine *machine)
 {
     int userOption;    // Stores the user's selected cash-out option
     int isValidInput;  // Flag to track input validity
@@ -413,13 +411,18 @@ void cashOut(CashRegister cashRegister[], int cashRegisterSize)
     while (!isValidInput)
     {
         int scanResult;  // Variable to store the result of input scanning
-        scanResult = scanf("%d", &userOption);
+        scanResult = readInt(&userOption);
 
-        if (scanResult != 1)
+        if (scanResult != 1 && isInputClosed())
+        {
+            userOption = 0;    // Input ended; cancel the cash-out
+            isValidInput = 1;
+        }
+        else if (scanResult != 1)
         {
             // Handle invalid input (non-integer)
             printf("Invalid input. Please enter a valid option (0, 1, or 2): ");
-            while (getchar() != '\n');  // Clear invalid input from the buffer
+            discardLine();  // Clear invalid input from the buffer
         }
         else if (userOption < 0 || userOption > 2)
         {
@@ -436,12 +439,12 @@ void cashOut(CashRegister cashRegister[], int cashRegisterSize)
     if (userOption == 1)
     {
         // Call the function to handle amount-based cash-out
-        handleAmountBasedCashOut(cashRegister, cashRegisterSize);
+        handleAmountBasedCashOut(machine);
     }
     else if (userOption == 2)
     {
         // Call the function to handle cash-out by denomination and quantity
-        handleQuantityBasedCashOut(cashRegister, cashRegisterSize);
+        handleQuantityBasedCashOut(machine);
     }
     else if (userOption == 0)
     {
@@ -452,31 +455,30 @@ void cashOut(CashRegister cashRegister[], int cashRegisterSize)
 
 /**
  * @brief Handles amount-based cash-out from the cash register.
- * @param cashRegister Array of CashRegister structures representing the current cash register.
- * @param cashRegisterSize Number of entries in the cashRegister array, representing the total
- *                         number of denominations in the register.
+ * @param machine The vending machine whose cash register is cashed out.
  * @pre cashRegister must contain valid cash denominations with non-negative quantities.
  */
-void handleAmountBasedCashOut(CashRegister cashRegister[], int cashRegisterSize)
+void handleAmountBasedCashOut(VendingMachine *machine)
 {
-    float amountToClaim;       // Amount requested by the user
-    int scanResult;            // Result of input validation
-    int remainingAmountCents;  // RemainingAmount val to avoid floating point precision errors
-    int amountToClaimCents;    // amountToClaimCents val to avoid floating point precision errors
-    int dispensed[cashRegisterSize];  // Track the number of notes/coins dispensed
+    Cents amountToClaim;               // Amount requested by the user
+    int scanResult;                    // Result of input validation
+    char amountText[MONEY_TEXT_SIZE];  // Amounts formatted for display
 
     int validInput = 0;  // Variable to control the loop for valid input
 
-    while (!validInput)  // Loop until the user enters a valid numeric value
+    while (!validInput && !isInputClosed())  // Loop until the user enters a valid numeric value
     {
         printf("\nEnter the amount you wish to claim (in PHP): ");
-        scanResult = scanf("%f", &amountToClaim);
+        scanResult = readCents(&amountToClaim);
 
         // Validate the input: amount must be a positive number
         if (scanResult != 1 || amountToClaim <= 0)
         {
-            printf("Invalid input or amount. Please enter a valid numeric option.\n");
-            while (getchar() != '\n');  // Clear invalid input from the buffer
+            if (!isInputClosed())  // Input that has ended stops the loop without complaint
+            {
+                printf("Invalid input or amount. Please enter a valid numeric option.\n");
+            }
+            discardLine();  // Clear invalid input from the buffer
         }
         else
         {
@@ -484,155 +486,123 @@ void handleAmountBasedCashOut(CashRegister cashRegister[], int cashRegisterSize)
         }
     }
 
-    // Convert the amount to cents for precise calculations
-    amountToClaimCents = (int) (round(amountToClaim * 100));  // Convert to nearest cent
-
-    remainingAmountCents = amountToClaimCents;  // Remaining amount to fulfill in cents
-    int i, j;                                   // Loop variables
-
-    // Initialize dispensed array to zero for all denominations
-    for (i = 0; i < cashRegisterSize; i++)
+    // Take the exact amount out of the register, starting from the highest denomination
+    ChangeResult dispensed = {0};
+    if (validInput)
     {
-        dispensed[i] = 0;
+        dispensed = cashOutAmount(machine, amountToClaim);
     }
 
-    // Attempt to dispense denominations starting from the highest denomination
-    int dispensingPossible = 1;  // Flag to check if dispensing is possible
-
-    for (j = 0; j < cashRegisterSize; j++)
+    // Check if the exact amount was dispensed
+    if (!validInput)
     {
-        int cashDenominationCents =
-            (int) (round(cashRegister[j].cashDenomination * 100));  // Convert denomination to cents
-
-        // While the denomination can still contribute to the remaining amount
-        // and there are notes/coins left in the register
-        while (remainingAmountCents >= cashDenominationCents && cashRegister[j].amountLeft > 0)
-        {
-            remainingAmountCents -= cashDenominationCents;  // Deduct denomination value
-            cashRegister[j].amountLeft--;                   // Decrease available quantity
-            dispensed[j]++;                                 // Track the number dispensed
-        }
+        printf("\nCash-out operation canceled.\n");  // Input ended before an amount was entered
     }
-
-    // Check if the exact amount was dispensed
-    if (remainingAmountCents > 0)
+    else if (dispensed.status != ENGINE_OK)
     {
-        // If not, revert the changes to the cash register
+        // The register is left untouched when the amount cannot be made exactly
         printf("\nUnable to dispense the exact stated amount. Operation canceled.\n");
-
-        // Restore the original quantities in the cash register
-        for (int z = 0; z < cashRegisterSize; z++)
-        {
-            cashRegister[z].amountLeft += dispensed[z];
-        }
-
-        dispensingPossible = 0;  // Set flag to indicate dispensing was not successful
     }
-
-    if (dispensingPossible)  // Only proceed if dispensing was successful
+    else
     {
         // If the amount was successfully dispensed, display the breakdown
         printf("\nDispensed Denominations:\n");
         printf(SEPARATOR "\n");
-        for (int x = 0; x < cashRegisterSize; x++)
+        for (int x = 0; x < machine->registerSize; x++)
         {
-            if (dispensed[x] > 0)
+            if (dispensed.counts[x] > 0)
             {
                 // Display the count and value of each denomination dispensed
-                printf("  %d x PhP%.2f\n", dispensed[x], cashRegister[x].cashDenomination);
+                printf("  %d x PhP%s\n", dispensed.counts[x],
+                       formatCents(machine->cash[x].cashDenomination, amountText));
             }
         }
 
         // Display the total amount dispensed
         printf(SEPARATOR "\n");
-        printf("Transaction Completed. Amount Dispensed: PhP %.2f\n", amountToClaim);
+        printf("Transaction Completed. Amount Dispensed: PhP %s\n",
+               formatCents(amountToClaim, amountText));
     }
 }
 
 /**
  * @brief Handles the process of cash-out based on the selected denomination and quantity.
- * @param cashRegister An array of CashRegister structure representing the cash register.
- *                     Each structure contains a specific denomination and the available quantity.
- * @param cashRegisterSize The size of the cashRegister array, representing the number of
- *                         different denominations available in the register.
+ * @param machine The vending machine whose cash register is cashed out.
  * @pre The cashRegister array should be populated with valid denominations and quantities.
  */
-void handleQuantityBasedCashOut(CashRegister cashRegister[], int cashRegisterSize)
+void handleQuantityBasedCashOut(VendingMachine *machine)
 {
-    float denomination;          // Denomination to be claimed
+    Cents denomination;          // Denomination to be claimed
     int quantity;                // Quantity to be claimed
     int scanResult;              // Result of input validation
     int validDenomination = 0;   // Flag to check if denomination exists in the register
     int sufficientQuantity = 0;  // Flag to check if sufficient quantity is available
-    int i;                       // Loop variable
+    int slot;                    // Register slot holding the entered denomination
+
+    char denominationText[MONEY_TEXT_SIZE];  // Denomination formatted for display
 
     // Loop to ensure the user enters a valid denomination
-    while (!validDenomination)
+    while (!validDenomination && !isInputClosed())
     {
         // Prompt the user for the denomination
         printf("\nEnter the denomination you wish to claim: ");
-        scanResult = scanf("%f", &denomination);
+        scanResult = readCents(&denomination);
 
         // Check for invalid input
         if (scanResult != 1)
         {
-            printf("Invalid input. Please enter a valid denomination.\n");
-            while (getchar() != '\n');  // Clear the input buffer
+            if (!isInputClosed())  // Input that has ended stops the loop without complaint
+            {
+                printf("Invalid input. Please enter a valid denomination.\n");
+            }
+            discardLine();  // Clear the input buffer
         }
         else
         {
             // Search for the entered denomination in the cash register
-            i = 0;
-            while (i < cashRegisterSize && validDenomination == 0)
+            slot = findDenominationSlot(machine, denomination);
+            formatCents(denomination, denominationText);
+
+            // If the denomination exists in the register
+            if (slot != -1)
             {
-                // If the denomination exists in the register
-                if (cashRegister[i].cashDenomination == denomination)
+                validDenomination = 1;  // Denomination found
+
+                // Loop for valid quantity input
+                while (!sufficientQuantity && !isInputClosed())
                 {
-                    validDenomination = 1;  // Denomination found
+                    // Prompt the user for the quantity to claim
+                    printf("Enter the quantity you wish to claim: ");
+                    scanResult = readInt(&quantity);
 
-                    // Loop for valid quantity input
-                    while (!sufficientQuantity)
+                    // Validate the quantity input
+                    if (scanResult != 1 || quantity <= 0)
                     {
-                        // Prompt the user for the quantity to claim
-                        printf("Enter the quantity you wish to claim: ");
-                        scanResult = scanf("%d", &quantity);
-
-                        // Validate the quantity input
-                        if (scanResult != 1 || quantity <= 0)
+                        if (!isInputClosed())  // Input that has ended stops the loop quietly
                         {
                             printf("Invalid quantity. Please enter a positive number.\n");
-                            while (getchar() != '\n');  // Clear the input buffer
-                        }
-                        else
-                        {
-                            // Check if sufficient quantity is available
-                            if (quantity <= cashRegister[i].amountLeft)
-                            {
-                                sufficientQuantity = 1;  // Sufficient quantity available
-
-                                // Perform the cash-out operation
-                                cashRegister[i].amountLeft -=
-                                    quantity;  // Deduct quantity from the register
-                                printf("Successfully dispensed %d - PhP%.2f\n", quantity,
-                                       denomination);
-                                printf("Remaining quantity of PhP%.2f: %d\n", denomination,
-                                       cashRegister[i].amountLeft);
-                            }
-                            else
-                            {
-                                // Insufficient quantity
-                                printf("Insufficient quantity for PhP%.2f. Only %d remaining.\n",
-                                       denomination, cashRegister[i].amountLeft);
-                            }
                         }
+                        discardLine();  // Clear the input buffer
+                    }
+                    else if (cashOutDenomination(machine, denomination, quantity) == ENGINE_OK)
+                    {
+                        sufficientQuantity = 1;  // Sufficient quantity available and dispensed
+
+                        printf("Successfully dispensed %d - PhP%s\n", quantity, denominationText);
+                        printf("Remaining quantity of PhP%s: %d\n", denominationText,
+                               machine->cash[slot].amountLeft);
+                    }
+                    else
+                    {
+                        // Insufficient quantity
+                        printf("Insufficient quantity for PhP%s. Only %d remaining.\n",
+                               denominationText, machine->cash[slot].amountLeft);
                     }
                 }
-                i++;  // Move to the next denomination in the register
             }
-
-            // If no valid denomination was found
-            if (validDenomination == 0)
+            else
             {
+                // If no valid denomination was found
                 printf(
                     "Invalid denomination. Please choose a valid denomination from the cash "
                     "register.\n");
@@ -640,3 +610,298 @@ void handleQuantityBasedCashOut(CashRegister cashRegister[], int cashRegisterSiz
         }
     }
 }
+
+/**
+ * @brief Displays the best-selling items, with the sales totals of the whole machine.
+ *
+ * The report is built from the running totals kept for each item, so it costs the same however
+ * many orders the machine has served.
+ *
+ * @param machine The vending machine whose sales are reported.
+ */
+void viewSalesReport(VendingMachine *machine)
+{
+    int limit;  // Number of top sellers to show
+    int scanResult;
+
+    printf("\nHow many top sellers to show (1-%d, 0 to go back): ", machine->menuSize);
+    scanResult = readInt(&limit);
+    while (!isInputClosed() && (scanResult != 1 || limit < 0 || limit > machine->menuSize))
+    {
+        printf("Invalid input. Please enter a number between 0 and %d.\n", machine->menuSize);
+        if (scanResult != 1)
+        {
+            discardLine();  // Clear invalid input
+        }
+        scanResult = readInt(&limit);
+    }
+    if (scanResult != 1)
+    {
+        limit = 0;  // Input ended; go back
+    }
+
+    int *topSellers = (limit > 0) ? malloc((size_t) limit * sizeof(int)) : NULL;
+    if (limit > 0 && topSellers == NULL)
+    {
+        printf("Not enough memory to rank %d items.\n", limit);
+    }
+    else if (limit > 0)
+    {
+        int count = findTopSellers(machine, topSellers, limit);
+        char revenueText[MONEY_TEXT_SIZE];
+
+        printf("\n\n%-4s | %-15s | %-10s | %-13s | %-8s | %-16s\n", "Rank", "Item Name",
+               "Units Sold", "Revenue (PHP)", "Canceled", "Last Sold");
+        printf(SEPARATOR "--------------------------\n");
+        for (int rank = 0; rank < count; rank++)
+        {
+            const ItemSales *sales = &machine->sales[topSellers[rank]];
+            time_t soldTime = (time_t) sales->lastSoldTime;
+            char soldText[20] = "Unknown";  // Sales replayed from old journals have no time
+
+            if (soldTime > 0)
+            {
+                strftime(soldText, sizeof(soldText), "%Y-%m-%d %H:%M", localtime(&soldTime));
+            }
+            printf("%-4d | %-15s | %-10lld | %-13s | %-8lld | %-16s\n", rank + 1,
+                   machine->items[topSellers[rank]].name, sales->unitsSold,
+                   formatCents(sales->revenue, revenueText), sales->unitsCancelled, soldText);
+        }
+        if (count == 0)
+        {
+            printf("No items have been sold yet.\n");
+        }
+
+        // Totals of the whole machine, from the same running totals
+        long long unitsSold = 0;
+        long long unitsCancelled = 0;
+        Cents revenue = 0;
+        for (int i = 0; i < machine->menuSize; i++)
+        {
+            unitsSold += machine->sales[i].unitsSold;
+            unitsCancelled += machine->sales[i].unitsCancelled;
+            revenue += machine->sales[i].revenue;
+        }
+        printf(SEPARATOR "--------------------------\n");
+        printf("%-4s | %-15s | %-10lld | %-13s | %-8lld |\n", "", "All Items", unitsSold,
+               formatCents(revenue, revenueText), unitsCancelled);
+    }
+    free(topSellers);
+}
+
+/**
+ * @brief Prints one transaction of the history: its items, the money and the change paid out.
+ * @param machine The vending machine that served the transaction.
+ * @param record The transaction.
+ */
+static void printTransaction(const VendingMachine *machine, const TransactionRecord *record)
+{
+    time_t endTime = (time_t) record->time;
+    char timeText[20];
+    char amountText[MONEY_TEXT_SIZE];
+    int storedLines = (record->lineCount < TRANSACTION_MAX_LINES) ? record->lineCount
+                                                                  : TRANSACTION_MAX_LINES;
+
+    strftime(timeText, sizeof(timeText), "%Y-%m-%d %H:%M:%S", localtime(&endTime));
+    printf("\n#%llu  %s  %s\n", (unsigned long long) record->sequence, timeText,
+           (record->outcome == TRANSACTION_CONFIRMED) ? "Confirmed" : "Canceled");
+
+    printf("  %-10s:", "Items");
+    for (int i = 0; i < storedLines; i++)
+    {
+        int index = findItemByNumber(machine, record->itemNumbers[i]);
+
+        if (index != -1)
+        {
+            printf(" %s x%d", machine->items[index].name, record->quantities[i]);
+        }
+        else
+        {
+            printf(" Item %d x%d", record->itemNumbers[i], record->quantities[i]);
+        }
+    }
+    if (record->otherUnits > 0)
+    {
+        printf(" (+%d units on %d more lines)", record->otherUnits,
+               record->lineCount - storedLines);
+    }
+    if (record->lineCount == 0)
+    {
+        printf(" None");
+    }
+    printf("\n");
+
+    printf("  %-10s: %s PHP in", "Money", formatCents(record->moneyIn, amountText));
+    printf(", %s PHP cost", formatCents(record->totalCost, amountText));
+    printf(", %s PHP %s\n", formatCents(record->changeGiven, amountText),
+           (record->outcome == TRANSACTION_CONFIRMED) ? "change" : "refunded");
+
+    printf("  %-10s:", "Dispensed");
+    for (int slot = 0; slot < machine->registerSize; slot++)
+    {
+        if (record->dispensed[slot] > 0)
+        {
+            printf(" %s x%d", formatCents(machine->cash[slot].cashDenomination, amountText),
+                   record->dispensed[slot]);
+        }
+    }
+    printf((record->changeGiven == 0) ? " Nothing\n" : "\n");
+    if (record->changeShort > 0)
+    {
+        printf("  %-10s: %s PHP\n", "Not Paid", formatCents(record->changeShort, amountText));
+    }
+}
+
+/**
+ * @brief Pages through the most recent transactions, newest first.
+ *
+ * The transactions come from the machine's in-memory ring, which holds the last
+ * TRANSACTION_LOG_SIZE of them; older ones are gone and cannot be shown.
+ *
+ * @param machine The vending machine whose transactions are shown.
+ */
+void viewTransactionHistory(VendingMachine *machine)
+{
+    int choice = -1;  // Menu choice; 0 returns to the maintenance menu
+    uint64_t newest = 0;
+    uint64_t oldest = 1;
+
+    if (machine->transactions == NULL)
+    {
+        printf("\nRecent transactions are not kept on this machine.\n");
+        choice = 0;
+    }
+    else
+    {
+        newest = transactionCount(machine->transactions);
+        oldest = (newest > TRANSACTION_LOG_SIZE) ? newest - TRANSACTION_LOG_SIZE + 1 : 1;
+    }
+
+    uint64_t pageTop = newest;  // Newest transaction on the page shown
+    while (choice != 0)
+    {
+        uint64_t pageBottom = (pageTop >= oldest + HISTORY_PAGE_SIZE)
+                                  ? pageTop - HISTORY_PAGE_SIZE + 1
+                                  : oldest;
+
+        printf(SEPARATOR);
+        if (newest == 0)
+        {
+            printf("\nNo transactions yet.\n");
+        }
+        else
+        {
+            printf("\nTransactions %llu to %llu (%llu kept, newest first)\n",
+                   (unsigned long long) pageTop, (unsigned long long) pageBottom,
+                   (unsigned long long) (newest - oldest + 1));
+        }
+        for (uint64_t sequence = pageTop; sequence >= pageBottom && sequence > 0; sequence--)
+        {
+            TransactionRecord record;
+
+            if (readTransaction(machine->transactions, sequence, &record))
+            {
+                printTransaction(machine, &record);
+            }
+        }
+
+        printf(SEPARATOR
+               "\n1 - Older\n"
+               "2 - Newer\n"
+               "0 - Back to Maintenance Menu\n"
+               "\nEnter your choice: ");
+
+        int scanResult = readInt(&choice);
+        while (!isInputClosed() && (scanResult != 1 || choice < 0 || choice > 2))
+        {
+            printf("Invalid input. Please enter a number between 0 and 2.\n");
+            if (scanResult != 1)
+            {
+                discardLine();  // Clear invalid input
+            }
+            scanResult = readInt(&choice);
+        }
+        if (scanResult != 1)
+        {
+            choice = 0;  // Input ended; go back
+        }
+
+        if (choice == 1 && pageBottom > oldest)
+        {
+            pageTop = pageBottom - 1;
+        }
+        else if (choice == 1)
+        {
+            printf("This is the oldest page.\n");
+        }
+        else if (choice == 2 && pageTop < newest)
+        {
+            pageTop = (pageTop + HISTORY_PAGE_SIZE < newest) ? pageTop + HISTORY_PAGE_SIZE : newest;
+        }
+        else if (choice == 2)
+        {
+            printf("This is the newest page.\n");
+        }
+    }
+}
+
+/**
+ * @brief Displays the latency counters of each purchase stage and lets the staff reset them.
+ *
+ * Times exclude waiting for the customer's input, so they show where the machine itself spends
+ * time in a transaction.
+ */
+void viewPerformanceStatistics(void)
+{
+    int choice = -1;  // Menu choice; 0 returns to the maintenance menu
+
+    if (!isPerfEnabled())
+    {
+        printf("\nPerformance counters are compiled out of this build (rebuild with PERF=1).\n");
+        choice = 0;
+    }
+
+    while (choice != 0)
+    {
+        // Print one row per stage, with latencies in nanoseconds
+        printf("\n%-20s | %9s | %9s | %9s | %9s | %9s | %9s |\n", "Stage (ns)", "Calls", "Mean",
+               "p50", "p99", "p999", "Max");
+        printf(SEPARATOR "--------------------------------\n");
+        for (int stage = 0; stage < PERF_STAGE_COUNT; stage++)
+        {
+            LatencyHistogram histogram;
+
+            readPerfStage((PerfStage) stage, &histogram);
+            printf("%-20s | %9lld | %9.0f | %9lld | %9lld | %9lld | %9lld |\n",
+                   perfStageName((PerfStage) stage), histogram.count, histogramMean(&histogram),
+                   histogramPercentile(&histogram, 0.50), histogramPercentile(&histogram, 0.99),
+                   histogramPercentile(&histogram, 0.999), histogram.max);
+        }
+
+        printf(SEPARATOR
+               "\n1 - Reset Counters\n"
+               "0 - Back to Maintenance Menu\n"
+               "\nEnter your choice: ");
+
+        int scanResult = readInt(&choice);
+        while (!isInputClosed() && (scanResult != 1 || choice < 0 || choice > 1))
+        {
+            printf("Invalid input. Please enter 0 or 1.\n");
+            if (scanResult != 1)
+            {
+                discardLine();  // Clear invalid input
+            }
+            scanResult = readInt(&choice);
+        }
+        if (scanResult != 1)
+        {
+            choice = 0;  // Input ended; go back
+        }
+
+        if (choice == 1)
+        {
+            resetPerfCounters();
+            printf("Performance counters reset.\n");
+        }
+    }
+}
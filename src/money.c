@@ -0,0 +1,104 @@
+#include "money.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "data_structures.h"
+
+/**
+ * @brief Formats an amount of money as pesos with two decimal places, e.g. 2075 as "20.75".
+ *
+ * This is the only place amounts are turned into text, so every screen and file shows money the
+ * same way.
+ *
+ * @param amount The amount in centavos.
+ * @param text Buffer of at least MONEY_TEXT_SIZE characters that receives the text.
+ * @return The text buffer, so the call can be used directly as a printf argument.
+ */
+const char *formatCents(Cents amount, char text[MONEY_TEXT_SIZE])
+{
+    const char *sign = "";
+    unsigned long long magnitude = (unsigned long long) amount;
+
+    if (amount < 0)
+    {
+        sign = "-";
+        magnitude = 0ULL - magnitude;  // Negate without overflowing on the smallest value
+    }
+
+    snprintf(text, MONEY_TEXT_SIZE, "%s%llu.%02llu", sign, magnitude / 100, magnitude % 100);
+    return text;
+}
+
+/**
+ * @brief Parses a peso amount such as "20", "0.25" or "17.5" into centavos.
+ * @param text The text to parse; it must contain nothing but the amount.
+ * @param amount Receives the amount in centavos when the text is valid.
+ * @return 1 if the text is a valid amount, 0 otherwise.
+ */
+int parseCents(const char *text, Cents *amount)
+{
+    return parseCentsSpan(text, strlen(text), amount);
+}
+
+/**
+ * @brief Parses a peso amount that is not null-terminated, such as a field inside a larger buffer.
+ *
+ * The text is read digit by digit, so no floating-point rounding is involved. At most two
+ * decimal places are accepted.
+ *
+ * @param text The start of the amount.
+ * @param length The number of characters in the amount; all of them must be part of it.
+ * @param amount Receives the amount in centavos when the text is valid.
+ * @return 1 if the text is a valid amount, 0 otherwise.
+ */
+int parseCentsSpan(const char *text, size_t length, Cents *amount)
+{
+    const char *end = text + length;
+    Cents pesos = 0;
+    Cents centavos = 0;
+    int isNegative = 0;
+    int digits = 0;         // Digits seen before the decimal point
+    int decimalPlaces = 0;  // Digits seen after the decimal point
+    int isValid = 1;
+
+    if (text < end && (*text == '-' || *text == '+'))
+    {
+        isNegative = (*text == '-');
+        text++;
+    }
+
+    while (text < end && *text >= '0' && *text <= '9' && isValid)
+    {
+        pesos = pesos * 10 + (*text - '0');
+        isValid = (pesos <= 100000000000LL);  // Reject amounts too large to be meaningful
+        digits++;
+        text++;
+    }
+
+    if (text < end && *text == '.')
+    {
+        text++;
+        while (text < end && *text >= '0' && *text <= '9' && decimalPlaces < 3)
+        {
+            centavos = centavos * 10 + (*text - '0');
+            decimalPlaces++;
+            text++;
+        }
+    }
+
+    // Require at least one digit, no more than two decimals and nothing after the number
+    if (isValid && (digits + decimalPlaces) > 0 && decimalPlaces <= 2 && text == end)
+    {
+        if (decimalPlaces == 1)
+        {
+            centavos *= 10;  // "17.5" means 17 pesos and 50 centavos
+        }
+        *amount = (pesos * 100 + centavos) * (isNegative ? -1 : 1);
+    }
+    else
+    {
+        isValid = 0;
+    }
+    return isValid;
+}
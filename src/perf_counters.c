@@ -0,0 +1,126 @@
+#define _POSIX_C_SOURCE 200809L  // Expose clock_gettime
+
+#include "perf_counters.h"
+
+#include <string.h>
+#include <time.h>
+
+#include "latency_histogram.h"
+
+#define PERF_CACHE_LINE 64  // Bytes per cache line; each stage's counters start on their own
+
+/**
+ * @brief The counters of one stage, on cache lines of their own so stages recorded from
+ *        different threads never share a line.
+ */
+typedef struct
+{
+    LatencyHistogram histogram;  // Latencies recorded for the stage, updated atomically; min
+                                 // holds the smallest latency plus 1, or 0 before the first
+} __attribute__((aligned(PERF_CACHE_LINE))) PerfCounter;
+
+static PerfCounter perfCounters[PERF_STAGE_COUNT];
+
+static const char *const perfStageNames[PERF_STAGE_COUNT] = {
+    "userMoneyInput", "processSelection", "updateSelectedItems",
+    "getChange",      "dispenseChange",   "saveItemsToCSV"};
+
+/**
+ * @brief Tells whether the counters were compiled in.
+ * @return 1 if the build defines VENDING_PERF, 0 if the counters are compiled out.
+ */
+int isPerfEnabled(void)
+{
+#ifdef VENDING_PERF
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Returns the display name of a stage, which is the function it times.
+ * @param stage The stage.
+ * @return The name of the stage.
+ */
+const char *perfStageName(PerfStage stage)
+{
+    return perfStageNames[stage];
+}
+
+/**
+ * @brief Returns the clock stages are timed with.
+ * @return The current monotonic time in nanoseconds.
+ */
+long long perfClockNs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long) now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * @brief Records one latency for a stage.
+ *
+ * Every field is updated with a relaxed atomic operation, so the engine may be timed from any
+ * number of threads without a lock, and a reader never sees a torn count.
+ *
+ * @param stage The stage that ran.
+ * @param latency How long it took, in nanoseconds.
+ */
+void recordPerfStage(PerfStage stage, long long latency)
+{
+    LatencyHistogram *histogram = &perfCounters[stage].histogram;
+    long long seen;
+
+    if (latency < 0)
+    {
+        latency = 0;
+    }
+    __atomic_fetch_add(&histogram->counts[histogramBucket(latency)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&histogram->total, latency, __ATOMIC_RELAXED);
+
+    seen = __atomic_load_n(&histogram->max, __ATOMIC_RELAXED);
+    while (latency > seen && !__atomic_compare_exchange_n(&histogram->max, &seen, latency, 1,
+                                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+        // A failed swap reloads seen with the current maximum
+    }
+    seen = __atomic_load_n(&histogram->min, __ATOMIC_RELAXED);
+    while ((seen == 0 || latency + 1 < seen) &&
+           !__atomic_compare_exchange_n(&histogram->min, &seen, latency + 1, 1, __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED))
+    {
+        // A failed swap reloads seen with the current minimum
+    }
+    __atomic_fetch_add(&histogram->count, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Copies the latencies recorded for a stage.
+ * @param stage The stage.
+ * @param histogram Receives a copy of the stage's histogram.
+ */
+void readPerfStage(PerfStage stage, LatencyHistogram *histogram)
+{
+    const LatencyHistogram *counters = &perfCounters[stage].histogram;
+
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        histogram->counts[i] = __atomic_load_n(&counters->counts[i], __ATOMIC_RELAXED);
+    }
+    histogram->count = __atomic_load_n(&counters->count, __ATOMIC_RELAXED);
+    histogram->total = __atomic_load_n(&counters->total, __ATOMIC_RELAXED);
+    histogram->min = __atomic_load_n(&counters->min, __ATOMIC_RELAXED);
+    histogram->min -= (histogram->min > 0);  // Stored one above the latency
+    histogram->max = __atomic_load_n(&counters->max, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Clears the counters of every stage.
+ */
+void resetPerfCounters(void)
+{
+    memset(perfCounters, 0, sizeof(perfCounters));
+}
@@ -0,0 +1,460 @@
+#include "purchase_session.h"
+
+#include <string.h>
+
+#include "cart.h"
+#include "constants.h"
+#include "transaction_log.h"
+
+// Names of the session states, in SessionState order
+static const char *const stateNames[] = {"IDLE",
+                                         "ACCEPTING_MONEY",
+                                         "SELECTING",
+                                         "AWAITING_CONFIRMATION",
+                                         "DISPENSING",
+                                         "CANCELLED"};
+
+// Items every silog comes with, one unit each, added to an order along with its first add-on
+static const char *const baseItemNames[] = {"Egg", "Rice"};
+#define BASE_ITEM_COUNT ((int) (sizeof(baseItemNames) / sizeof(baseItemNames[0])))
+
+/**
+ * @brief Checks whether a session has an order the customer can still change or cancel.
+ * @param state The state of the session.
+ * @return 1 while money or items are held for an unconfirmed order, 0 otherwise.
+ */
+static int isOrderOpen(SessionState state)
+{
+    return (state == SESSION_ACCEPTING_MONEY || state == SESSION_SELECTING ||
+            state == SESSION_AWAITING_CONFIRMATION);
+}
+
+/**
+ * @brief Takes a session out of the timeouts list, if it is in it.
+ * @param timeouts The list.
+ * @param session The session.
+ */
+static void unlinkSession(SessionTimeouts *timeouts, PurchaseSession *session)
+{
+    if (session->deadline != 0)
+    {
+        if (session->older != NULL)
+        {
+            session->older->newer = session->newer;
+        }
+        else
+        {
+            timeouts->oldest = session->newer;
+        }
+        if (session->newer != NULL)
+        {
+            session->newer->older = session->older;
+        }
+        else
+        {
+            timeouts->newest = session->older;
+        }
+        session->older = NULL;
+        session->newer = NULL;
+        session->deadline = 0;
+    }
+}
+
+/**
+ * @brief Gives a session a fresh deadline, moving it to the newest end of the timeouts list.
+ * @param timeouts The list.
+ * @param session The session.
+ * @param now The current time, in ms.
+ */
+static void touchSession(SessionTimeouts *timeouts, PurchaseSession *session, long long now)
+{
+    unlinkSession(timeouts, session);
+    session->deadline = now + timeouts->timeoutMs;
+    if (session->deadline == 0)
+    {
+        session->deadline = 1;  // 0 marks a session outside the list
+    }
+    session->older = timeouts->newest;
+    if (timeouts->newest != NULL)
+    {
+        timeouts->newest->newer = session;
+    }
+    else
+    {
+        timeouts->oldest = session;
+    }
+    timeouts->newest = session;
+}
+
+/**
+ * @brief Cancels a session's open order: its stock goes back and its money is refunded.
+ * @param machine The vending machine the order was placed on.
+ * @param session The session.
+ * @return The refund paid out of the register.
+ */
+static ChangeResult refundOrder(VendingMachine *machine, PurchaseSession *session)
+{
+    ChangeResult refund;
+
+    memset(&refund, 0, sizeof(refund));
+    if (session->userMoney > 0)
+    {
+        refund = payOutChange(machine, session->userMoney);
+    }
+    logTransaction(machine, &session->selection, session->userMoney, &refund,
+                   TRANSACTION_CANCELLED);
+    resetOrderAfterCancel(&session->selection, &session->userMoney, machine);
+    session->state = SESSION_CANCELLED;
+    return refund;
+}
+
+/**
+ * @brief Reserves the change for a session's order, planning again if other kiosks take planned
+ *        pieces first.
+ * @param machine The vending machine paying the change.
+ * @param session The session; receives the reserved change.
+ * @return ENGINE_OK if the change is reserved, ENGINE_INEXACT_CHANGE if the register cannot make
+ *         it, or ENGINE_INSUFFICIENT_CASH if other kiosks kept taking it.
+ */
+static EngineStatus reserveOrderChange(VendingMachine *machine, PurchaseSession *session)
+{
+    Cents changeDue = session->userMoney - session->selection.totalItemCost;
+    EngineStatus status = ENGINE_INSUFFICIENT_CASH;
+
+    for (int attempt = 0; status == ENGINE_INSUFFICIENT_CASH && attempt < CHANGE_CLAIM_ATTEMPTS;
+         attempt++)
+    {
+        session->change = computeChange(machine, changeDue);
+        status = (session->change.status == ENGINE_OK) ? reserveChange(machine, &session->change)
+                                                       : session->change.status;
+    }
+    if (status != ENGINE_OK)
+    {
+        memset(&session->change, 0, sizeof(session->change));
+    }
+    return status;
+}
+
+/**
+ * @brief Completes a session's confirmed order once its change has been dispensed.
+ * @param machine The vending machine that sold the order.
+ * @param session The session, dispensing.
+ */
+static void finishSale(VendingMachine *machine, PurchaseSession *session)
+{
+    commitChange(machine, &session->change);
+    logTransaction(machine, &session->selection, session->userMoney, &session->change,
+                   TRANSACTION_CONFIRMED);
+    resetOrderAfterConfirm(&session->selection, &session->userMoney, machine);
+    memset(&session->change, 0, sizeof(session->change));
+    session->state = SESSION_IDLE;
+}
+
+/**
+ * @brief Adds the units of an add-on to a session's order. The first add-on of an order comes
+ *        with the base meal, one Egg and one Rice, and is only added if the money and stock cover
+ *        both; a base item that is sold out or missing from the inventory is left out of the meal.
+ *
+ * An add-on that is itself a base item, such as extra eggs, is reserved together with the base
+ * meal's unit in one step, so the add-on can never take the unit the meal was counting on.
+ *
+ * @param machine The vending machine the session buys from.
+ * @param session The session.
+ * @param itemIndex The inventory index of the add-on.
+ * @param quantity The units of the add-on.
+ * @return The outcome of the request for the add-on, with the cart total including the base meal
+ *         and the units of the add-on still available after the base meal's.
+ */
+static CartResult addToOrder(VendingMachine *machine, PurchaseSession *session, int itemIndex,
+                             int quantity)
+{
+    int baseItems[BASE_ITEM_COUNT];  // Inventory indexes of the base items to add
+    int baseItemCount = 0;
+    int sharedUnits = 0;  // Base meal units of the add-on itself, reserved with the add-on
+    Cents basePrice = 0;  // Money held back for the rest of the base meal
+
+    for (int i = 0; i < BASE_ITEM_COUNT && session->selection.count == 0; i++)
+    {
+        int index = findItemByName(machine, baseItemNames[i]);
+
+        if (index != -1 && index == itemIndex)
+        {
+            sharedUnits++;
+        }
+        else if (index != -1 && machine->items[index].stock > 0)
+        {
+            baseItems[baseItemCount++] = index;
+            basePrice += machine->items[index].price;
+        }
+    }
+
+    // The add-on goes first, with the base meal's price held back from the money, so neither is
+    // added unless both are affordable
+    CartResult result = addQuantityToCart(machine, itemIndex, &session->selection,
+                                          session->userMoney - basePrice, quantity + sharedUnits);
+    result.available = (result.available > sharedUnits) ? result.available - sharedUnits : 0;
+
+    // The meal's price is held back and the empty cart has inline lines for all of it, so a base
+    // item can only fail if another kiosk sold its last unit since the check above; the meal then
+    // goes without it, as with one sold out before, and its price is not charged
+    for (int i = 0; i < baseItemCount && result.status == ENGINE_OK; i++)
+    {
+        addItemToCart(machine, baseItems[i], &session->selection, session->userMoney);
+    }
+    result.totalCost = session->selection.totalItemCost;
+    return result;
+}
+
+/**
+ * @brief Sets up an empty list of sessions with open orders.
+ * @param timeouts The list to set up.
+ * @param timeoutMs Inactivity after which an open order is abandoned, in ms.
+ */
+void initSessionTimeouts(SessionTimeouts *timeouts, long long timeoutMs)
+{
+    timeouts->oldest = NULL;
+    timeouts->newest = NULL;
+    timeouts->timeoutMs = timeoutMs;
+}
+
+/**
+ * @brief Sets up an idle purchase session.
+ * @param session The session to set up.
+ * @param owner The front end object the session belongs to, or NULL.
+ * @param journalOrder The id its changes are journaled under: 0 for the console's order, or an id
+ *        from 1 to JOURNAL_MAX_ORDER that no other open session has.
+ */
+void startPurchaseSession(PurchaseSession *session, void *owner, int journalOrder)
+{
+    memset(session, 0, sizeof(*session));
+    session->state = SESSION_IDLE;
+    session->owner = owner;
+    session->journalOrder = journalOrder;
+}
+
+/**
+ * @brief Puts a session whose cart and money were rebuilt after a crash into the state they
+ *        imply, so the order can be finished or canceled.
+ * @param session The session, holding the rebuilt order.
+ */
+void resumePurchaseSession(PurchaseSession *session)
+{
+    if (session->selection.count > 0)
+    {
+        session->state = SESSION_SELECTING;
+    }
+    else if (session->userMoney > 0)
+    {
+        session->state = SESSION_ACCEPTING_MONEY;
+    }
+}
+
+/**
+ * @brief Advances a purchase session by one event.
+ *
+ * A new order starts with money or an item from the idle or canceled state, and money and items may
+ * be added in either order until checkout. Every item selected is an add-on to the silog: the first
+ * brings the base meal of one Egg and one Rice with it, and an order without an add-on cannot be
+ * checked out. A checked-out order waits for confirmation; more money or items reopen it.
+ * Confirming reserves the change, and the dispensed event completes the sale. A cancellation or
+ * timeout of an open order returns its stock and refunds its money through the usual cancel logic,
+ * and a timeout while dispensing completes the sale, which is already paid for. A cancellation with
+ * no order open is refused; a timeout then does nothing. Every event pushes back the deadline of an
+ * open order, and the changes it makes are journaled under the session's order id.
+ *
+ * @param machine The vending machine the session buys from.
+ * @param timeouts The sessions with open orders.
+ * @param session The session to advance.
+ * @param event The event.
+ * @param now The current time, in ms on the clock the deadlines are kept on.
+ * @return The outcome of the event. ENGINE_INVALID_STATE means the event does not apply in the
+ *         session's state, and the session is unchanged.
+ */
+SessionResult advanceSession(VendingMachine *machine, SessionTimeouts *timeouts,
+                             PurchaseSession *session, const SessionEvent *event, long long now)
+{
+    SessionResult result;
+
+    memset(&result, 0, sizeof(result));
+    result.status = ENGINE_OK;
+    machine->journalOrder = session->journalOrder;  // Journal the changes as this session's
+
+    switch (event->type)
+    {
+        case SESSION_EVENT_INSERT_MONEY:
+            if (session->state == SESSION_DISPENSING)
+            {
+                result.status = ENGINE_INVALID_STATE;
+            }
+            else
+            {
+                result.status = insertMoney(machine, event->amount, &session->userMoney);
+                if (result.status == ENGINE_OK)
+                {
+                    session->state = SESSION_ACCEPTING_MONEY;
+                }
+            }
+            break;
+
+        case SESSION_EVENT_SELECT_ITEM:
+            if (session->state == SESSION_DISPENSING)
+            {
+                result.status = ENGINE_INVALID_STATE;
+            }
+            else
+            {
+                result.cart = addToOrder(machine, session, event->itemIndex, event->quantity);
+                result.status = result.cart.status;
+                if (result.status == ENGINE_OK)
+                {
+                    session->state = SESSION_SELECTING;
+                }
+            }
+            break;
+
+        case SESSION_EVENT_CHECKOUT:
+            if (!isOrderOpen(session->state))
+            {
+                result.status = ENGINE_INVALID_STATE;
+            }
+            else if (session->selection.count == 0)
+            {
+                // The base meal only comes with an add-on, so this is the only order without one
+                result.status = ENGINE_EMPTY_ORDER;
+            }
+            else
+            {
+                session->state = SESSION_AWAITING_CONFIRMATION;
+            }
+            break;
+
+        case SESSION_EVENT_CONFIRM:
+            if (session->state != SESSION_AWAITING_CONFIRMATION)
+            {
+                result.status = ENGINE_INVALID_STATE;
+            }
+            else
+            {
+                result.status = reserveOrderChange(machine, session);
+                if (result.status == ENGINE_OK)
+                {
+                    result.payout = session->change;
+                    session->state = SESSION_DISPENSING;
+                }
+            }
+            break;
+
+        case SESSION_EVENT_DISPENSED:
+            if (session->state != SESSION_DISPENSING)
+            {
+                result.status = ENGINE_INVALID_STATE;
+            }
+            else
+            {
+                result.payout = session->change;
+                finishSale(machine, session);
+            }
+            break;
+
+        case SESSION_EVENT_CANCEL:
+        case SESSION_EVENT_TIMEOUT:
+            if (session->state == SESSION_DISPENSING && event->type == SESSION_EVENT_TIMEOUT)
+            {
+                result.payout = session->change;
+                finishSale(machine, session);  // Paid for; the change already left the register
+            }
+            else if (session->state == SESSION_DISPENSING)
+            {
+                result.status = ENGINE_INVALID_STATE;  // Too late to cancel
+            }
+            else if (isOrderOpen(session->state))
+            {
+                result.payout = refundOrder(machine, session);
+            }
+            else if (event->type == SESSION_EVENT_CANCEL)
+            {
+                result.status = ENGINE_INVALID_STATE;  // No order to cancel
+            }
+            break;
+
+        default:
+            result.status = ENGINE_INVALID_STATE;
+            break;
+    }
+
+    // Only sessions holding money, stock or change can be abandoned
+    if (isOrderOpen(session->state) || session->state == SESSION_DISPENSING)
+    {
+        touchSession(timeouts, session, now);
+    }
+    else
+    {
+        unlinkSession(timeouts, session);
+    }
+    result.state = session->state;
+    machine->journalOrder = 0;
+    return result;
+}
+
+/**
+ * @brief Ends a purchase session whose customer is gone: an open order is canceled and refunded,
+ *        and an order being dispensed is completed.
+ * @param machine The vending machine the session buys from.
+ * @param timeouts The sessions with open orders.
+ * @param session The session to end; it may be released afterwards.
+ * @param now The current time, in ms.
+ */
+void endPurchaseSession(VendingMachine *machine, SessionTimeouts *timeouts,
+                        PurchaseSession *session, long long now)
+{
+    SessionEvent event;
+
+    memset(&event, 0, sizeof(event));
+    event.type = SESSION_EVENT_TIMEOUT;
+    advanceSession(machine, timeouts, session, &event, now);
+    clearCart(&session->selection);
+}
+
+/**
+ * @brief Takes the session with the earliest deadline out of the timeouts list, if it has passed.
+ *
+ * Call it until it returns NULL and advance each session it returns with SESSION_EVENT_TIMEOUT.
+ *
+ * @param timeouts The sessions with open orders.
+ * @param now The current time, in ms.
+ * @return The abandoned session, or NULL if no deadline has passed.
+ */
+PurchaseSession *nextExpiredSession(SessionTimeouts *timeouts, long long now)
+{
+    PurchaseSession *expired = timeouts->oldest;
+
+    if (expired != NULL && expired->deadline <= now)
+    {
+        unlinkSession(timeouts, expired);
+    }
+    else
+    {
+        expired = NULL;
+    }
+    return expired;
+}
+
+/**
+ * @brief Finds the earliest deadline of the open orders, for a front end to wait until.
+ * @param timeouts The sessions with open orders.
+ * @return The deadline in ms, or 0 if no order is open.
+ */
+long long nextSessionDeadline(const SessionTimeouts *timeouts)
+{
+    return (timeouts->oldest != NULL) ? timeouts->oldest->deadline : 0;
+}
+
+/**
+ * @brief Names a session state, for display.
+ * @param state The state.
+ * @return The name, such as "SELECTING".
+ */
+const char *sessionStateName(SessionState state)
+{
+    return stateNames[state];
+}
@@ -0,0 +1,261 @@
+#define _POSIX_C_SOURCE 200809L  // Expose mmap, fstat and fdatasync
+
+#include "snapshot.h"
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cart.h"
+#include "catalog.h"
+#include "crc32.h"
+#include "data_management.h"
+#include "data_structures.h"
+#include "engine.h"
+
+// Offset of the first header byte covered by the checksum
+#define SNAPSHOT_CHECKED_OFFSET offsetof(SnapshotHeader, sequence)
+
+/**
+ * @brief Computes the size of the file holding a state, or 0 if the counts are invalid.
+ * @param header The header describing the state.
+ * @return The number of bytes the header and the arrays after it take up.
+ */
+static size_t snapshotSize(const SnapshotHeader *header)
+{
+    size_t size = 0;
+
+    if (header->itemCount >= 0 && header->registerSize >= 0 && header->lineCount >= 0)
+    {
+        size = sizeof(SnapshotHeader) +
+               (size_t) header->itemCount * (sizeof(VendingItem) + sizeof(ItemSales)) +
+               (size_t) header->registerSize * sizeof(CashRegister) +
+               (size_t) header->lineCount * sizeof(SnapshotLine);
+    }
+    return size;
+}
+
+/**
+ * @brief Writes the full state of a machine to a snapshot file.
+ *
+ * The state is written and synced under a temporary name and then renamed over the snapshot, so
+ * a crash at any point leaves either the old snapshot or the new one complete.
+ *
+ * @param path The snapshot file.
+ * @param snapshot The state to write.
+ * @return 1 if the snapshot was replaced, 0 if the old one was kept.
+ */
+int writeSnapshot(const char *path, const MachineSnapshot *snapshot)
+{
+    char tempPath[FILE_PATH_SIZE];
+    SnapshotHeader header;
+    size_t itemBytes = (size_t) snapshot->itemCount * sizeof(VendingItem);
+    size_t salesBytes = (size_t) snapshot->itemCount * sizeof(ItemSales);
+    size_t cashBytes = (size_t) snapshot->registerSize * sizeof(CashRegister);
+    size_t lineBytes = (size_t) snapshot->lineCount * sizeof(SnapshotLine);
+    int isWritten = (strlen(path) + 4 < FILE_PATH_SIZE);
+
+    memset(&header, 0, sizeof(header));
+    header.magic = SNAPSHOT_MAGIC;
+    header.version = SNAPSHOT_VERSION;
+    header.sequence = snapshot->sequence;
+    header.userMoney = snapshot->userMoney;
+    header.itemCount = snapshot->itemCount;
+    header.registerSize = snapshot->registerSize;
+    header.lineCount = snapshot->lineCount;
+    header.itemSize = (int32_t) sizeof(VendingItem);
+    header.cashSize = (int32_t) sizeof(CashRegister);
+    header.salesSize = (int32_t) sizeof(ItemSales);
+
+    // The checksum runs from the sequence field to the end of the file
+    uint32_t checksum = computeCrc32((const char *) &header + SNAPSHOT_CHECKED_OFFSET,
+                                     sizeof(header) - SNAPSHOT_CHECKED_OFFSET);
+    checksum = updateCrc32(checksum, snapshot->items, itemBytes);
+    checksum = updateCrc32(checksum, snapshot->sales, salesBytes);
+    checksum = updateCrc32(checksum, snapshot->cash, cashBytes);
+    header.checksum = updateCrc32(checksum, snapshot->lines, lineBytes);
+
+    if (isWritten)
+    {
+        int fd;
+
+        strcpy(tempPath, path);
+        strcat(tempPath, ".tmp");
+        fd = open(tempPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        isWritten = (fd != -1);
+        if (isWritten)
+        {
+            isWritten = writeFully(fd, &header, sizeof(header)) &&
+                        writeFully(fd, snapshot->items, itemBytes) &&
+                        writeFully(fd, snapshot->sales, salesBytes) &&
+                        writeFully(fd, snapshot->cash, cashBytes) &&
+                        writeFully(fd, snapshot->lines, lineBytes) && fdatasync(fd) == 0;
+            close(fd);
+            isWritten = isWritten && rename(tempPath, path) == 0;
+            if (isWritten)
+            {
+                syncParentDirectory(path);
+            }
+            else
+            {
+                unlink(tempPath);
+            }
+        }
+    }
+    return isWritten;
+}
+
+/**
+ * @brief Maps a snapshot file and checks that it is complete and was written by this build.
+ *
+ * Nothing is parsed: once the header, size and checksum are checked, the arrays are used in
+ * place from the mapped file.
+ *
+ * @param path The snapshot file.
+ * @param snapshot Receives the state, pointing into the mapped file.
+ * @return 1 if a valid snapshot was loaded, 0 if there is none or it is damaged. Release a loaded
+ *         snapshot with releaseSnapshot.
+ */
+int loadSnapshot(const char *path, MachineSnapshot *snapshot)
+{
+    int isLoaded = 0;
+    int fd = open(path, O_RDONLY);
+
+    memset(snapshot, 0, sizeof(*snapshot));
+    if (fd != -1)
+    {
+        struct stat status;
+
+        if (fstat(fd, &status) == 0 && (size_t) status.st_size >= sizeof(SnapshotHeader))
+        {
+            void *mapping = mmap(NULL, (size_t) status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (mapping != MAP_FAILED)
+            {
+                const SnapshotHeader *header = mapping;
+                const char *body = (const char *) mapping + sizeof(SnapshotHeader);
+                size_t size = (size_t) status.st_size;
+
+                isLoaded = (header->magic == SNAPSHOT_MAGIC &&
+                            header->version == SNAPSHOT_VERSION &&
+                            header->itemSize == (int32_t) sizeof(VendingItem) &&
+                            header->cashSize == (int32_t) sizeof(CashRegister) &&
+                            header->salesSize == (int32_t) sizeof(ItemSales) &&
+                            snapshotSize(header) == size &&
+                            header->checksum ==
+                                computeCrc32((const char *) mapping + SNAPSHOT_CHECKED_OFFSET,
+                                             size - SNAPSHOT_CHECKED_OFFSET));
+                if (isLoaded)
+                {
+                    snapshot->sequence = header->sequence;
+                    snapshot->userMoney = header->userMoney;
+                    snapshot->items = (const VendingItem *) body;
+                    snapshot->itemCount = header->itemCount;
+                    snapshot->sales = (const ItemSales *) (body + (size_t) header->itemCount *
+                                                                      sizeof(VendingItem));
+                    snapshot->cash = (const CashRegister *) (snapshot->sales + header->itemCount);
+                    snapshot->registerSize = header->registerSize;
+                    snapshot->lines = (const SnapshotLine *) (snapshot->cash +
+                                                              header->registerSize);
+                    snapshot->lineCount = header->lineCount;
+                    snapshot->mapping = mapping;
+                    snapshot->mappingSize = size;
+                }
+                else
+                {
+                    munmap(mapping, size);
+                }
+            }
+        }
+        close(fd);
+    }
+    return isLoaded;
+}
+
+/**
+ * @brief Copies the items of a snapshot into a catalog with a single copy.
+ * @param snapshot The loaded snapshot.
+ * @param catalog The catalog to add the items to.
+ * @return 1 if the items were added, 0 if memory ran out.
+ */
+int copySnapshotItems(const MachineSnapshot *snapshot, Catalog *catalog)
+{
+    int isCopied = reserveCatalog(catalog, catalog->count + snapshot->itemCount);
+
+    if (isCopied && snapshot->itemCount > 0)
+    {
+        memcpy(&catalog->items[catalog->count], snapshot->items,
+               (size_t) snapshot->itemCount * sizeof(VendingItem));
+        catalog->count += snapshot->itemCount;
+    }
+    return isCopied;
+}
+
+/**
+ * @brief Restores the sales totals, cash register and order in progress of a snapshot.
+ *
+ * Register slots are matched by denomination, and sales totals and order lines by item number;
+ * any the machine does not have are skipped.
+ *
+ * @param snapshot The loaded snapshot.
+ * @param machine The vending machine set up over the snapshot's items.
+ * @param selection Receives the order in progress; must be empty.
+ * @param userMoney Receives the money inserted for the order in progress.
+ */
+void restoreSnapshot(const MachineSnapshot *snapshot, VendingMachine *machine,
+                     UserSelection *selection, Cents *userMoney)
+{
+    for (int i = 0; i < snapshot->registerSize; i++)
+    {
+        int slot = findDenominationSlot(machine, snapshot->cash[i].cashDenomination);
+
+        if (slot != -1)
+        {
+            machine->cash[slot].amountLeft = snapshot->cash[i].amountLeft;
+        }
+    }
+    noteRegisterChanged(machine);
+
+    for (int i = 0; i < snapshot->itemCount; i++)
+    {
+        int index = findItemByNumber(machine, snapshot->items[i].itemNumber);
+
+        if (index != -1)
+        {
+            machine->sales[index] = snapshot->sales[i];
+        }
+    }
+
+    // The stored stock already excludes the reserved units, so only the cart is rebuilt, at the
+    // prices the lines were started at
+    for (int i = 0; i < snapshot->lineCount; i++)
+    {
+        const SnapshotLine *line = &snapshot->lines[i];
+        int index = findItemByNumber(machine, line->itemNumber);
+
+        if (index != -1 && line->quantity > 0 &&
+            addCartUnits(selection, index, line->quantity, line->unitPrice))
+        {
+            selection->totalItemCost += line->unitPrice * line->quantity;
+        }
+    }
+    *userMoney = snapshot->userMoney;
+}
+
+/**
+ * @brief Unmaps a snapshot loaded with loadSnapshot.
+ * @param snapshot The snapshot to release.
+ */
+void releaseSnapshot(MachineSnapshot *snapshot)
+{
+    if (snapshot->mapping != NULL)
+    {
+        munmap(snapshot->mapping, snapshot->mappingSize);
+    }
+    memset(snapshot, 0, sizeof(*snapshot));
+}
@@ -0,0 +1,1054 @@
+#define _GNU_SOURCE  // Expose accept4, epoll, signalfd and MSG_NOSIGNAL
+
+#include "socket_server.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cart.h"
+#include "constants.h"
+#include "data_structures.h"
+#include "engine.h"
+#include "journal.h"
+#include "money.h"
+#include "purchase_session.h"
+#include "transaction_log.h"
+
+/**
+ * @brief One connected kiosk controller and the order it has in progress.
+ */
+typedef struct
+{
+    int fd;                           // Connected socket, non-blocking
+    int slot;                         // Position of the session in the server's sessions array
+    PurchaseSession purchase;         // The controller's order, advanced by its commands
+    int isStaff;                      // 1 once the controller has logged in for maintenance
+    int isClosing;                    // 1 once the session ends after its replies are sent
+    int isWaitingToWrite;             // 1 while epoll also watches the socket for room to write
+    int isDiscarding;                 // 1 while skipping the rest of an overlong line
+    char line[SESSION_LINE_SIZE];     // Command line received so far
+    size_t lineLength;                // Number of bytes in line
+    char *output;                     // Replies not yet sent
+    size_t outputLength;              // Number of bytes in output
+    size_t outputSent;                // Bytes of output already sent
+    size_t outputCapacity;            // Number of bytes output can hold before it must grow
+} Session;
+
+/**
+ * @brief The server: the machine every session sells from and the sockets it watches.
+ */
+typedef struct
+{
+    VendingMachine *machine;   // The vending machine shared by every session
+    int password;              // Maintenance password, as on the console
+    int epollFd;               // Event loop watching every socket below
+    int listenFd;              // Socket accepting new controllers
+    int signalFd;              // Delivers SIGINT and SIGTERM as events to stop the server
+    Session **sessions;        // Every connected session, in no particular order
+    int sessionCount;          // Number of sessions in the sessions array
+    int sessionCapacity;       // Number of sessions the array can hold before it must grow
+    int isRunning;             // 0 once a signal or SHUTDOWN command stops the server
+    SessionTimeouts timeouts;  // Sessions with an order open, soonest deadline first
+    long long now;             // When the current events arrived, in ms on the monotonic clock
+    int lastJournalOrder;      // Journal order id given to the newest session
+} Server;
+
+typedef void (*CommandHandler)(Server *, Session *, char *);
+
+/**
+ * @brief A protocol command and the function that carries it out.
+ */
+typedef struct
+{
+    const char *name;        // Command word, matched exactly
+    int isStaffOnly;         // 1 if the session must log in first
+    CommandHandler handler;  // Carries out the command given the rest of the line
+} Command;
+
+// Tags told apart from sessions in epoll events
+static int listenTag;
+static int signalTag;
+
+// Reply codes of the engine statuses, in EngineStatus order
+static const char *const statusNames[] = {"OK",
+                                          "INVALID_ITEM",
+                                          "OUT_OF_STOCK",
+                                          "INSUFFICIENT_FUNDS",
+                                          "INVALID_DENOMINATION",
+                                          "INVALID_AMOUNT",
+                                          "INSUFFICIENT_CASH",
+                                          "INEXACT_CHANGE",
+                                          "CART_FULL",
+                                          "EMPTY_ORDER",
+                                          "INVALID_STATE"};
+
+/**
+ * @brief Queues a reply line for a session. A session whose replies pile up past
+ *        SESSION_OUTPUT_LIMIT is not reading them, so it is ended instead.
+ * @param session The session to reply to.
+ * @param format A printf format for the line, without the line break.
+ */
+static void reply(Session *session, const char *format, ...) __attribute__((format(printf, 2, 3)));
+static void reply(Session *session, const char *format, ...)
+{
+    char text[SESSION_LINE_SIZE * 2];
+    va_list arguments;
+    int length;
+
+    va_start(arguments, format);
+    length = vsnprintf(text, sizeof(text) - 1, format, arguments);
+    va_end(arguments);
+    if (length > (int) sizeof(text) - 2)
+    {
+        length = (int) sizeof(text) - 2;  // Cut lines too long to keep
+    }
+    text[length++] = '\n';
+
+    if (session->outputLength + (size_t) length > session->outputCapacity &&
+        session->outputLength + (size_t) length <= SESSION_OUTPUT_LIMIT)
+    {
+        size_t capacity = (session->outputCapacity == 0) ? 4096 : session->outputCapacity * 2;
+        char *grown = realloc(session->output, capacity);
+
+        if (grown != NULL)
+        {
+            session->output = grown;
+            session->outputCapacity = capacity;
+        }
+    }
+    if (session->outputLength + (size_t) length <= session->outputCapacity)
+    {
+        memcpy(&session->output[session->outputLength], text, (size_t) length);
+        session->outputLength += (size_t) length;
+    }
+    else
+    {
+        session->isClosing = 1;  // Out of room; replies already queued are still sent
+    }
+}
+
+/**
+ * @brief Queues an error reply naming an engine status.
+ * @param session The session to reply to.
+ * @param status The status of the failed operation.
+ */
+static void replyStatus(Session *session, EngineStatus status)
+{
+    reply(session, "ERR %s", statusNames[status]);
+}
+
+/**
+ * @brief Queues a reply with an amount and the bills and coins it was paid out in.
+ * @param server The server whose machine paid out the amount.
+ * @param session The session to reply to.
+ * @param label The word naming the amount, such as CHANGE or REFUND.
+ * @param change The bills and coins paid out.
+ */
+static void replyPayout(Server *server, Session *session, const char *label,
+                        const ChangeResult *change)
+{
+    const VendingMachine *machine = server->machine;
+    char text[SESSION_LINE_SIZE];
+    char amountText[MONEY_TEXT_SIZE];
+    Cents amount = 0;
+    int length = 0;
+
+    for (int slot = 0; slot < machine->registerSize; slot++)
+    {
+        if (change->counts[slot] > 0 && length < (int) sizeof(text))
+        {
+            amount += change->counts[slot] * machine->cash[slot].cashDenomination;
+            length += snprintf(&text[length], sizeof(text) - (size_t) length, " %sx%d",
+                               formatCents(machine->cash[slot].cashDenomination, amountText),
+                               change->counts[slot]);
+        }
+    }
+    text[(length < (int) sizeof(text)) ? length : (int) sizeof(text) - 1] = '\0';
+    reply(session, "OK %s %s%s", label, formatCents(amount, amountText), text);
+    if (change->status != ENGINE_OK)
+    {
+        reply(session, "ERR INEXACT_CHANGE %s", formatCents(change->remaining, amountText));
+    }
+}
+
+/**
+ * @brief Takes the next space-separated word from a command line.
+ * @param cursor The rest of the line; moved past the word.
+ * @return The word, or NULL if the line has no more words.
+ */
+static char *nextWord(char **cursor)
+{
+    char *word = NULL;
+
+    while (**cursor == ' ' || **cursor == '\t')
+    {
+        (*cursor)++;
+    }
+    if (**cursor != '\0')
+    {
+        word = *cursor;
+        while (**cursor != '\0' && **cursor != ' ' && **cursor != '\t')
+        {
+            (*cursor)++;
+        }
+        if (**cursor != '\0')
+        {
+            *(*cursor)++ = '\0';
+        }
+    }
+    return word;
+}
+
+/**
+ * @brief Parses a whole number that must make up the entire word.
+ * @param word The word to parse, or NULL.
+ * @param value Receives the number.
+ * @return 1 if the word is a number that fits in an int, 0 otherwise.
+ */
+static int parseWholeNumber(const char *word, int *value)
+{
+    char *end;
+    long number = (word != NULL) ? strtol(word, &end, 10) : 0;
+    int isValid = (word != NULL && *word != '\0' && *end == '\0' && number >= -2147483647L &&
+                   number <= 2147483647L);
+
+    if (isValid)
+    {
+        *value = (int) number;
+    }
+    return isValid;
+}
+
+/**
+ * @brief Finds the inventory index named by an item number word.
+ * @param server The server whose machine is searched.
+ * @param word The item number, or NULL.
+ * @return The inventory index, or -1 if the word is not the number of an item.
+ */
+static int parseItem(Server *server, const char *word)
+{
+    int itemNumber;
+
+    return parseWholeNumber(word, &itemNumber) ? findItemByNumber(server->machine, itemNumber)
+                                               : -1;
+}
+
+/**
+ * @brief Reads the monotonic clock the order deadlines are kept on.
+ * @return The time in ms.
+ */
+static long long monotonicMs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Advances a session's order by one event.
+ * @param server The server whose machine the order is placed on.
+ * @param session The session.
+ * @param type The kind of event.
+ * @param amount The denomination inserted, for SESSION_EVENT_INSERT_MONEY.
+ * @param itemIndex The inventory index of the item, for SESSION_EVENT_SELECT_ITEM.
+ * @param quantity The units of the item, for SESSION_EVENT_SELECT_ITEM.
+ * @return The outcome of the event.
+ */
+static SessionResult sendEvent(Server *server, Session *session, SessionEventType type,
+                               Cents amount, int itemIndex, int quantity)
+{
+    SessionEvent event;
+
+    event.type = type;
+    event.amount = amount;
+    event.itemIndex = itemIndex;
+    event.quantity = quantity;
+    return advanceSession(server->machine, &server->timeouts, &session->purchase, &event,
+                          server->now);
+}
+
+/**
+ * @brief INSERT <amount>: inserts a bill or coin.
+ */
+static void insertCommand(Server *server, Session *session, char *arguments)
+{
+    char *word = nextWord(&arguments);
+    char amountText[MONEY_TEXT_SIZE];
+    Cents denomination;
+
+    if (word == NULL || !parseCents(word, &denomination))
+    {
+        reply(session, "ERR USAGE INSERT <amount>");
+    }
+    else
+    {
+        SessionResult result =
+            sendEvent(server, session, SESSION_EVENT_INSERT_MONEY, denomination, 0, 0);
+
+        if (result.status != ENGINE_OK)
+        {
+            replyStatus(session, result.status);
+        }
+        else
+        {
+            reply(session, "OK CREDIT %s", formatCents(session->purchase.userMoney, amountText));
+        }
+    }
+}
+
+/**
+ * @brief SELECT <item number> [units]: adds units of an item to the cart, one unless given.
+ */
+static void selectCommand(Server *server, Session *session, char *arguments)
+{
+    int index = parseItem(server, nextWord(&arguments));
+    char *word = nextWord(&arguments);
+    int quantity = 1;
+    char amountText[MONEY_TEXT_SIZE];
+    SessionResult result;
+
+    if (word != NULL && !parseWholeNumber(word, &quantity))
+    {
+        quantity = 0;  // Rejected by the engine as an invalid amount
+    }
+    result = sendEvent(server, session, SESSION_EVENT_SELECT_ITEM, 0, index, quantity);
+
+    if (result.status == ENGINE_INSUFFICIENT_FUNDS)
+    {
+        reply(session, "ERR INSUFFICIENT_FUNDS %s",
+              formatCents(result.cart.shortfall, amountText));
+    }
+    else if (result.status == ENGINE_OUT_OF_STOCK)
+    {
+        reply(session, "ERR OUT_OF_STOCK %d", result.cart.available);
+    }
+    else if (result.status != ENGINE_OK)
+    {
+        replyStatus(session, result.status);
+    }
+    else
+    {
+        reply(session, "OK TOTAL %s", formatCents(result.cart.totalCost, amountText));
+    }
+}
+
+/**
+ * @brief CART: lists the lines of the cart, then the total and the money inserted.
+ */
+static void cartCommand(Server *server, Session *session, char *arguments)
+{
+    const UserSelection *selection = &session->purchase.selection;
+    const CartLine *lines = cartLines(selection);
+    char amountText[MONEY_TEXT_SIZE];
+    char creditText[MONEY_TEXT_SIZE];
+
+    (void) arguments;
+    for (int i = 0; i < selection->count; i++)
+    {
+        const VendingItem *item = &server->machine->items[lines[i].itemIndex];
+
+        reply(session, "LINE %d %d %s %s", item->itemNumber, lines[i].quantity,
+              formatCents(cartLineSubtotal(selection, i), amountText), item->name);
+    }
+    reply(session, "OK TOTAL %s CREDIT %s", formatCents(selection->totalItemCost, amountText),
+          formatCents(session->purchase.userMoney, creditText));
+}
+
+/**
+ * @brief CONFIRM: checks the order out, pays for it and dispenses the change. The order stays
+ *        open if the register cannot make the change, so the controller can add exact money or
+ *        cancel it.
+ */
+static void confirmCommand(Server *server, Session *session, char *arguments)
+{
+    SessionResult result;
+
+    (void) arguments;
+    result.status = ENGINE_OK;
+    if (session->purchase.state != SESSION_AWAITING_CONFIRMATION)
+    {
+        result = sendEvent(server, session, SESSION_EVENT_CHECKOUT, 0, 0, 0);
+    }
+    if (result.status == ENGINE_OK)
+    {
+        result = sendEvent(server, session, SESSION_EVENT_CONFIRM, 0, 0, 0);
+    }
+    if (result.status == ENGINE_OK)
+    {
+        // The server is its own dispenser: the change is out as soon as it is reserved
+        result = sendEvent(server, session, SESSION_EVENT_DISPENSED, 0, 0, 0);
+    }
+
+    if (result.status != ENGINE_OK)
+    {
+        replyStatus(session, result.status);
+    }
+    else
+    {
+        replyPayout(server, session, "CHANGE", &result.payout);
+    }
+}
+
+/**
+ * @brief CANCEL: cancels the order, returning its stock and refunding the money inserted.
+ */
+static void cancelCommand(Server *server, Session *session, char *arguments)
+{
+    SessionResult result = sendEvent(server, session, SESSION_EVENT_CANCEL, 0, 0, 0);
+
+    (void) arguments;
+    if (result.status != ENGINE_OK)
+    {
+        replyStatus(session, result.status);
+    }
+    else
+    {
+        replyPayout(server, session, "REFUND", &result.payout);
+    }
+}
+
+/**
+ * @brief STATE: names the state of the session's order.
+ */
+static void stateCommand(Server *server, Session *session, char *arguments)
+{
+    (void) server;
+    (void) arguments;
+    reply(session, "OK STATE %s", sessionStateName(session->purchase.state));
+}
+
+/**
+ * @brief STOCK [item number]: lists one item or every item with its price and stock.
+ */
+static void stockCommand(Server *server, Session *session, char *arguments)
+{
+    const VendingMachine *machine = server->machine;
+    char *word = nextWord(&arguments);
+    int first = 0;
+    int last = machine->menuSize;
+    char amountText[MONEY_TEXT_SIZE];
+
+    if (word != NULL)
+    {
+        first = parseItem(server, word);
+        last = first + 1;
+    }
+    if (first == -1)
+    {
+        replyStatus(session, ENGINE_INVALID_ITEM);
+    }
+    else
+    {
+        for (int i = first; i < last; i++)
+        {
+            reply(session, "ITEM %d %s %d %s", machine->items[i].itemNumber,
+                  formatCents(machine->items[i].price, amountText), machine->items[i].stock,
+                  machine->items[i].name);
+        }
+        reply(session, "OK ITEMS %d", last - first);
+    }
+}
+
+/**
+ * @brief LOGIN <password>: unlocks the maintenance commands for the session.
+ */
+static void loginCommand(Server *server, Session *session, char *arguments)
+{
+    int password;
+
+    session->isStaff =
+        (parseWholeNumber(nextWord(&arguments), &password) && password == server->password);
+    reply(session, session->isStaff ? "OK STAFF" : "ERR BAD_PASSWORD");
+}
+
+/**
+ * @brief PRICE <item number> <amount>: sets the price of an item.
+ */
+static void priceCommand(Server *server, Session *session, char *arguments)
+{
+    int index = parseItem(server, nextWord(&arguments));
+    char *word = nextWord(&arguments);
+    Cents price;
+    EngineStatus status = (word != NULL && parseCents(word, &price))
+                              ? setItemPrice(server->machine, index, price)
+                              : ENGINE_INVALID_AMOUNT;
+
+    if (status != ENGINE_OK)
+    {
+        replyStatus(session, status);
+    }
+    else
+    {
+        reply(session, "OK");
+    }
+}
+
+/**
+ * @brief RESTOCK <item number> <units>: adds stock to an item.
+ */
+static void restockCommand(Server *server, Session *session, char *arguments)
+{
+    int index = parseItem(server, nextWord(&arguments));
+    int units;
+    EngineStatus status = parseWholeNumber(nextWord(&arguments), &units)
+                              ? restockItem(server->machine, index, units)
+                              : ENGINE_INVALID_AMOUNT;
+
+    if (status != ENGINE_OK)
+    {
+        replyStatus(session, status);
+    }
+    else
+    {
+        reply(session, "OK STOCK %d", server->machine->items[index].stock);
+    }
+}
+
+/**
+ * @brief REGISTER: lists the bills and coins held by the cash register, then its total.
+ */
+static void registerCommand(Server *server, Session *session, char *arguments)
+{
+    const VendingMachine *machine = server->machine;
+    char amountText[MONEY_TEXT_SIZE];
+
+    (void) arguments;
+    for (int slot = 0; slot < machine->registerSize; slot++)
+    {
+        reply(session, "CASH %s %d", formatCents(machine->cash[slot].cashDenomination, amountText),
+              machine->cash[slot].amountLeft);
+    }
+    reply(session, "OK TOTAL %s", formatCents(registerTotal(machine), amountText));
+}
+
+/**
+ * @brief REFILL <denomination> <pieces>: adds bills or coins to the cash register.
+ */
+static void refillCommand(Server *server, Session *session, char *arguments)
+{
+    char *word = nextWord(&arguments);
+    Cents denomination;
+    int pieces;
+    EngineStatus status = ENGINE_INVALID_DENOMINATION;
+
+    if (word != NULL && parseCents(word, &denomination))
+    {
+        status = parseWholeNumber(nextWord(&arguments), &pieces)
+                     ? restockRegister(server->machine, denomination, pieces)
+                     : ENGINE_INVALID_AMOUNT;
+    }
+    if (status != ENGINE_OK)
+    {
+        replyStatus(session, status);
+    }
+    else
+    {
+        reply(session, "OK");
+    }
+}
+
+/**
+ * @brief CASHOUT <amount>: takes an exact amount out of the cash register.
+ */
+static void cashOutCommand(Server *server, Session *session, char *arguments)
+{
+    char *word = nextWord(&arguments);
+    Cents amount;
+
+    if (word == NULL || !parseCents(word, &amount))
+    {
+        replyStatus(session, ENGINE_INVALID_AMOUNT);
+    }
+    else
+    {
+        ChangeResult result = cashOutAmount(server->machine, amount);
+
+        if (result.status != ENGINE_OK)
+        {
+            replyStatus(session, result.status);
+        }
+        else
+        {
+            replyPayout(server, session, "CASHOUT", &result);
+        }
+    }
+}
+
+/**
+ * @brief SHUTDOWN: stops the server once the current events are handled.
+ */
+static void shutdownCommand(Server *server, Session *session, char *arguments)
+{
+    (void) arguments;
+    server->isRunning = 0;
+    reply(session, "OK BYE");
+}
+
+/**
+ * @brief QUIT: ends the session, canceling any order in progress.
+ */
+static void quitCommand(Server *server, Session *session, char *arguments)
+{
+    (void) server;
+    (void) arguments;
+    session->isClosing = 1;
+    reply(session, "OK BYE");
+}
+
+static const Command commands[] = {
+    {"INSERT", 0, insertCommand},     {"SELECT", 0, selectCommand},
+    {"CART", 0, cartCommand},         {"CONFIRM", 0, confirmCommand},
+    {"CANCEL", 0, cancelCommand},     {"STATE", 0, stateCommand},
+    {"STOCK", 0, stockCommand},
+    {"LOGIN", 0, loginCommand},       {"QUIT", 0, quitCommand},
+    {"PRICE", 1, priceCommand},       {"RESTOCK", 1, restockCommand},
+    {"REGISTER", 1, registerCommand}, {"REFILL", 1, refillCommand},
+    {"CASHOUT", 1, cashOutCommand},   {"SHUTDOWN", 1, shutdownCommand}};
+
+/**
+ * @brief Carries out one command line from a session.
+ * @param server The server.
+ * @param session The session that sent the line.
+ * @param line The line, without its line break.
+ */
+static void handleLine(Server *server, Session *session, char *line)
+{
+    char *word = nextWord(&line);
+    const Command *command = NULL;
+    size_t commandCount = sizeof(commands) / sizeof(commands[0]);
+
+    for (size_t i = 0; word != NULL && command == NULL && i < commandCount; i++)
+    {
+        if (strcmp(word, commands[i].name) == 0)
+        {
+            command = &commands[i];
+        }
+    }
+
+    if (word == NULL)
+    {
+        // Blank lines are ignored
+    }
+    else if (command == NULL)
+    {
+        reply(session, "ERR UNKNOWN_COMMAND");
+    }
+    else if (command->isStaffOnly && !session->isStaff)
+    {
+        reply(session, "ERR NOT_AUTHORIZED");
+    }
+    else
+    {
+        command->handler(server, session, line);
+    }
+}
+
+/**
+ * @brief Sends as much of a session's queued replies as the socket takes, and has epoll watch
+ *        for room to write only while some are left.
+ * @param server The server.
+ * @param session The session to send for.
+ * @return 1 if the session is still usable, 0 if its socket failed.
+ */
+static int sendReplies(Server *server, Session *session)
+{
+    int isUsable = 1;
+    int isBlocked = 0;
+
+    while (isUsable && !isBlocked && session->outputSent < session->outputLength)
+    {
+        ssize_t sent = send(session->fd, &session->output[session->outputSent],
+                            session->outputLength - session->outputSent, MSG_NOSIGNAL);
+
+        if (sent > 0)
+        {
+            session->outputSent += (size_t) sent;
+        }
+        else
+        {
+            isBlocked = (sent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK));
+            isUsable = isBlocked || (sent == -1 && errno == EINTR);
+        }
+    }
+    if (session->outputSent == session->outputLength)
+    {
+        session->outputSent = 0;
+        session->outputLength = 0;
+    }
+
+    if (isUsable && isBlocked != session->isWaitingToWrite)
+    {
+        struct epoll_event event;
+
+        event.events = EPOLLIN | (isBlocked ? EPOLLOUT : 0);
+        event.data.ptr = session;
+        isUsable = (epoll_ctl(server->epollFd, EPOLL_CTL_MOD, session->fd, &event) == 0);
+        session->isWaitingToWrite = isBlocked;
+    }
+    return isUsable;
+}
+
+/**
+ * @brief Ends a session: cancels its order in progress and closes its socket.
+ * @param server The server.
+ * @param session The session to end.
+ */
+static void closeSession(Server *server, Session *session)
+{
+    // The controller is gone: its stock goes back and its money to the coin return
+    endPurchaseSession(server->machine, &server->timeouts, &session->purchase, server->now);
+    epoll_ctl(server->epollFd, EPOLL_CTL_DEL, session->fd, NULL);
+    close(session->fd);
+
+    // Fill the session's place in the array with the last session
+    server->sessions[session->slot] = server->sessions[--server->sessionCount];
+    server->sessions[session->slot]->slot = session->slot;
+    free(session->output);
+    free(session);
+}
+
+/**
+ * @brief Picks the journal order id of a new session: the next one after the last given out that
+ *        no connected session has, so the orders of sessions served at the same time replay
+ *        apart after a crash.
+ * @param server The server, with fewer than JOURNAL_MAX_ORDER sessions.
+ * @return The id, from 1 to JOURNAL_MAX_ORDER.
+ */
+static int nextJournalOrder(Server *server)
+{
+    int order = server->lastJournalOrder;
+    int isTaken = 1;
+
+    while (isTaken)
+    {
+        order = order % JOURNAL_MAX_ORDER + 1;
+        isTaken = 0;
+        for (int i = 0; !isTaken && i < server->sessionCount; i++)
+        {
+            isTaken = (server->sessions[i]->purchase.journalOrder == order);
+        }
+    }
+    server->lastJournalOrder = order;
+    return order;
+}
+
+/**
+ * @brief Accepts every controller waiting to connect.
+ * @param server The server.
+ */
+static void acceptSessions(Server *server)
+{
+    int fd;
+
+    while ((fd = accept4(server->listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1)
+    {
+        Session *session = calloc(1, sizeof(Session));
+        struct epoll_event event;
+
+        if (session != NULL && server->sessionCount == server->sessionCapacity)
+        {
+            int capacity = (server->sessionCapacity == 0) ? 64 : server->sessionCapacity * 2;
+            Session **grown = realloc(server->sessions, (size_t) capacity * sizeof(Session *));
+
+            if (grown != NULL)
+            {
+                server->sessions = grown;
+                server->sessionCapacity = capacity;
+            }
+        }
+
+        event.events = EPOLLIN;
+        event.data.ptr = session;
+        if (session != NULL && server->sessionCount < server->sessionCapacity &&
+            server->sessionCount < JOURNAL_MAX_ORDER &&
+            epoll_ctl(server->epollFd, EPOLL_CTL_ADD, fd, &event) == 0)
+        {
+            session->fd = fd;
+            startPurchaseSession(&session->purchase, session, nextJournalOrder(server));
+            session->slot = server->sessionCount;
+            server->sessions[server->sessionCount++] = session;
+        }
+        else
+        {
+            free(session);  // Out of memory or order ids: turn the controller away
+            close(fd);
+        }
+    }
+}
+
+/**
+ * @brief Reads what a session has sent and carries out every complete line.
+ * @param server The server.
+ * @param session The session that has input.
+ * @return 1 if the session stays open, 0 if it hung up or its socket failed.
+ */
+static int readCommands(Server *server, Session *session)
+{
+    char buffer[4096];
+    int isOpen = 1;
+    int isDrained = 0;
+
+    while (isOpen && !isDrained)
+    {
+        ssize_t received = recv(session->fd, buffer, sizeof(buffer), 0);
+
+        isDrained = (received == -1 && (errno == EAGAIN || errno == EWOULDBLOCK));
+        isOpen = (received > 0 || isDrained || (received == -1 && errno == EINTR));
+        for (ssize_t i = 0; i < received && !session->isClosing; i++)
+        {
+            if (buffer[i] == '\n')
+            {
+                if (!session->isDiscarding)
+                {
+                    // Drop a carriage return sent by controllers that end lines with CRLF
+                    if (session->lineLength > 0 && session->line[session->lineLength - 1] == '\r')
+                    {
+                        session->lineLength--;
+                    }
+                    session->line[session->lineLength] = '\0';
+                    handleLine(server, session, session->line);
+                }
+                session->lineLength = 0;
+                session->isDiscarding = 0;
+            }
+            else if (session->isDiscarding)
+            {
+                // Still inside an overlong line
+            }
+            else if (session->lineLength + 1 < sizeof(session->line))
+            {
+                session->line[session->lineLength++] = buffer[i];
+            }
+            else
+            {
+                reply(session, "ERR LINE_TOO_LONG");
+                session->isDiscarding = 1;
+            }
+        }
+    }
+    return isOpen;
+}
+
+/**
+ * @brief Works out how long the event loop may wait before the next order times out.
+ * @param server The server.
+ * @return The wait in ms, or -1 to wait until the next event.
+ */
+static int waitTimeout(const Server *server)
+{
+    long long deadline = nextSessionDeadline(&server->timeouts);
+    long long wait = -1;
+
+    if (deadline != 0)
+    {
+        wait = deadline - monotonicMs();
+        wait = (wait < 0) ? 0 : (wait > INT_MAX) ? INT_MAX : wait;
+    }
+    return (int) wait;
+}
+
+/**
+ * @brief Cancels every order left open past its deadline and tells its controller.
+ * @param server The server.
+ */
+static void expireSessions(Server *server)
+{
+    PurchaseSession *purchase;
+
+    while ((purchase = nextExpiredSession(&server->timeouts, server->now)) != NULL)
+    {
+        Session *session = purchase->owner;
+        SessionResult result = sendEvent(server, session, SESSION_EVENT_TIMEOUT, 0, 0, 0);
+
+        reply(session, "TIMEOUT");
+        replyPayout(server, session, (result.state == SESSION_IDLE) ? "CHANGE" : "REFUND",
+                    &result.payout);
+        if (!sendReplies(server, session))
+        {
+            closeSession(server, session);
+        }
+    }
+}
+
+/**
+ * @brief Opens the listening socket, replacing a stale socket file left by an earlier server.
+ * @param path The socket file.
+ * @return The listening socket, or -1 if it could not be opened.
+ */
+static int openListener(const char *path)
+{
+    struct sockaddr_un address;
+    int fd = -1;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) < sizeof(address.sun_path))
+    {
+        strcpy(address.sun_path, path);
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    }
+    if (fd != -1)
+    {
+        unlink(path);
+        if (bind(fd, (struct sockaddr *) &address, sizeof(address)) != 0 ||
+            listen(fd, SOMAXCONN) != 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    return fd;
+}
+
+/**
+ * @brief Serves kiosk controllers over a Unix domain socket until stopped.
+ *
+ * Controllers send one command per line and get one or more reply lines, the last starting with
+ * OK or ERR. A single thread waits on every socket with epoll, so hundreds of controllers are
+ * served without a thread each; every connection has its own cart and money, and all of them
+ * sell from the same machine. Each order moves through the purchase session states, so a command
+ * that does not fit the order's state is answered with ERR INVALID_STATE. A controller that hangs
+ * up, or leaves an order open past the timeout, has its order canceled. Every change is
+ * journaled under the order id of its session, so the machine's journal survives a crash however
+ * the orders interleave. The server stops on SIGINT, SIGTERM or a SHUTDOWN command from a
+ * logged-in controller.
+ *
+ * @param machine The vending machine to sell from.
+ * @param path The socket file to listen on.
+ * @param password The maintenance password that LOGIN checks.
+ * @param timeoutMs How long an order may sit without a command before it is canceled, in ms.
+ * @return 0 on a clean stop, 1 if the server could not start.
+ */
+int runSocketServer(VendingMachine *machine, const char *path, int password, long long timeoutMs)
+{
+    Server server;
+    sigset_t stopSignals;
+    struct epoll_event event;
+
+    memset(&server, 0, sizeof(server));
+    server.machine = machine;
+    server.password = password;
+    initSessionTimeouts(&server.timeouts, timeoutMs);
+    server.now = monotonicMs();
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    sigprocmask(SIG_BLOCK, &stopSignals, NULL);  // Delivered through signalFd instead
+
+    server.listenFd = openListener(path);
+    server.signalFd = signalfd(-1, &stopSignals, SFD_NONBLOCK | SFD_CLOEXEC);
+    server.epollFd = epoll_create1(EPOLL_CLOEXEC);
+    server.isRunning = (server.listenFd != -1 && server.signalFd != -1 && server.epollFd != -1);
+    if (server.isRunning)
+    {
+        event.events = EPOLLIN;
+        event.data.ptr = &listenTag;
+        server.isRunning = (epoll_ctl(server.epollFd, EPOLL_CTL_ADD, server.listenFd, &event) == 0);
+        event.data.ptr = &signalTag;
+        server.isRunning = server.isRunning &&
+                           epoll_ctl(server.epollFd, EPOLL_CTL_ADD, server.signalFd, &event) == 0;
+    }
+
+    int exitCode = server.isRunning ? 0 : 1;
+    if (server.isRunning)
+    {
+        printf("Serving kiosk controllers on %s (Ctrl+C to stop).\n", path);
+        fflush(stdout);
+    }
+    else
+    {
+        printf("Unable to listen on %s.\n", path);
+    }
+
+    while (server.isRunning)
+    {
+        struct epoll_event events[SERVER_MAX_EVENTS];
+        int ready = epoll_wait(server.epollFd, events, SERVER_MAX_EVENTS, waitTimeout(&server));
+
+        server.now = monotonicMs();
+
+        for (int i = 0; i < ready; i++)
+        {
+            if (events[i].data.ptr == &listenTag)
+            {
+                acceptSessions(&server);
+            }
+            else if (events[i].data.ptr == &signalTag)
+            {
+                struct signalfd_siginfo signalInfo;
+
+                // Take the signal so it is not delivered again once it is unblocked
+                if (read(server.signalFd, &signalInfo, sizeof(signalInfo)) > 0)
+                {
+                    server.isRunning = 0;
+                }
+            }
+            else
+            {
+                Session *session = events[i].data.ptr;
+                int isOpen = 1;
+
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                {
+                    isOpen = readCommands(&server, session);
+                }
+                isOpen = isOpen && sendReplies(&server, session);
+                if (!isOpen || (session->isClosing && session->outputLength == 0))
+                {
+                    closeSession(&server, session);  // epoll reports each socket once per wait
+                }
+            }
+        }
+        expireSessions(&server);
+
+        // Compact a long journal at a moment no order is open, so the snapshot has none to describe
+        if (machine->journal != NULL && nextSessionDeadline(&server.timeouts) == 0 &&
+            isJournalCompactionDue(machine->journal))
+        {
+            compactJournal(machine->journal, machine, NULL, 0);
+        }
+        if (ready == -1 && errno != EINTR)
+        {
+            server.isRunning = 0;
+            exitCode = 1;
+        }
+    }
+
+    // Stop: cancel every order in progress and close every connection
+    while (server.sessionCount > 0)
+    {
+        Session *session = server.sessions[server.sessionCount - 1];
+
+        sendReplies(&server, session);  // Best effort, such as the reply to SHUTDOWN
+        closeSession(&server, session);
+    }
+    free(server.sessions);
+    if (server.listenFd != -1)
+    {
+        close(server.listenFd);
+        unlink(path);
+    }
+    if (server.signalFd != -1)
+    {
+        close(server.signalFd);
+    }
+    if (server.epollFd != -1)
+    {
+        close(server.epollFd);
+    }
+    sigprocmask(SIG_UNBLOCK, &stopSignals, NULL);
+    printf("Server stopped.\n");
+    return exitCode;
+}
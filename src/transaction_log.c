@@ -0,0 +1,74 @@
+#include "transaction_log.h"
+
+#include <stdlib.h>
+
+/**
+ * @brief A ring of the most recent transactions. The ring is allocated once, so appending only
+ * overwrites the oldest record and memory use stays the same however long the machine runs.
+ */
+struct TransactionLog
+{
+    TransactionRecord records[TRANSACTION_LOG_SIZE];  // Records, keyed by sequence modulo size
+    uint64_t count;                                   // Transactions appended since creation
+};
+
+/**
+ * @brief Creates an empty transaction log.
+ * @return The log, or NULL if memory ran out. Release it with destroyTransactionLog.
+ */
+TransactionLog *createTransactionLog(void)
+{
+    return calloc(1, sizeof(TransactionLog));
+}
+
+/**
+ * @brief Releases a transaction log created with createTransactionLog.
+ * @param log The log to release, or NULL.
+ */
+void destroyTransactionLog(TransactionLog *log)
+{
+    free(log);
+}
+
+/**
+ * @brief Appends a transaction, overwriting the oldest one once the log is full.
+ * @param log The log to append to.
+ * @param record The transaction; its sequence field is filled in by the log.
+ * @pre Only one thread appends to a log.
+ */
+void appendTransaction(TransactionLog *log, const TransactionRecord *record)
+{
+    TransactionRecord *slot = &log->records[log->count % TRANSACTION_LOG_SIZE];
+
+    *slot = *record;
+    slot->sequence = ++log->count;
+}
+
+/**
+ * @brief Counts the transactions appended to a log, including those it no longer holds.
+ * @param log The log to count.
+ * @return The sequence number of the newest transaction, 0 if there is none.
+ */
+uint64_t transactionCount(const TransactionLog *log)
+{
+    return log->count;
+}
+
+/**
+ * @brief Reads one transaction from a log.
+ * @param log The log to read.
+ * @param sequence The sequence number of the transaction.
+ * @param record Receives the transaction.
+ * @return 1 if the transaction was read, 0 if it was never appended or has been overwritten.
+ */
+int readTransaction(const TransactionLog *log, uint64_t sequence, TransactionRecord *record)
+{
+    int isHeld = (sequence >= 1 && sequence <= log->count &&
+                  log->count - sequence < TRANSACTION_LOG_SIZE);
+
+    if (isHeld)
+    {
+        *record = log->records[(sequence - 1) % TRANSACTION_LOG_SIZE];
+    }
+    return isHeld;
+}
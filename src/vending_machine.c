@@ -1,119 +1,98 @@
 #include "vending_machine.h"
 
-#include <math.h>
+#include <stdio.h>
+#include <string.h>
 
+#include "cart.h"
+#include "console_input.h"
 #include "constants.h"
 #include "data_structures.h"
+#include "engine.h"
+#include "kiosk_display.h"
+#include "money.h"
+#include "perf_counters.h"
+#include "purchase_session.h"
 
 /**
  * @brief Displays the list of vending items with their details.
- * @param items An array of VendingItem structures containing item details.
- * @param menuSize The total number of items in the array.
+ *
+ * The table is drawn as one frame, so on a kiosk display only the rows whose price or stock
+ * changed are sent to the screen.
+ *
+ * @param machine The vending machine whose items are displayed.
  */
-void displayItems(VendingItem items[], int menuSize)
+void displayItems(VendingMachine *machine)
 {
-    // Print header for the item details table
-    printf("\n%-12s | %-15s | %-10s | %-10s\n", "Item Number", "Item Name", "Price (PHP)",
+    VendingItem *items = machine->items;  // Items of the machine
+    int menuSize = machine->menuSize;     // Number of items in the machine
+
+    // Header for the item details table
+    beginFrame(DISPLAY_MENU);
+    addRow("%s", "");
+    addRow("%-12s | %-15s | %-10s | %-10s", "Item Number", "Item Name", "Price (PHP)",
            "Stock Left");
-    printf(SEPARATOR "\n");
+    addRow(SEPARATOR);
 
     int i;
-    // Loop through the items array to display each item's details
+    // Loop through the items array to add each item's details
     for (i = 0; i < menuSize; i++)
     {
-        // Declare and initialize the item details variables
-        int itemNumber = items[i].itemNumber;
-        char *itemName = items[i].name;
-        float price = items[i].price;
+        char price[MONEY_TEXT_SIZE];
         int stock = items[i].stock;
 
-        // Display item details
-        printf("%-12d | %-15s | %-11.2f | %-3d",
-               itemNumber,  // Item number
-               itemName,    // Item name
-               price,       // Item price
-               stock        // Remaining stock
-        );
-
-        // Check if the item is out of stock and display a message if true
-        if (stock == 0)
-        {
-            printf(" %-12s", OUT_OF_STOCK_MSG);  // Display out of stock message
-        }
+        formatCents(items[i].price, price);
 
-        // Move to the next line after each item
-        printf("\n");
+        // Item number, name, price and remaining stock, marked when out of stock
+        addRow("%-12d | %-15s | %-11s | %-3d%s", items[i].itemNumber, items[i].name, price, stock,
+               (stock == 0) ? " " OUT_OF_STOCK_MSG : "");
     }
 
-    // Print footer for the item details table
-    printf(SEPARATOR "\n");
+    // Footer for the item details table
+    addRow(SEPARATOR);
+    endFrame();
 }
 
 /**
- * @brief Checks if the inserted money is a valid denomination.
- * @param moneyInserted The amount of money to be checked for validity.
- * @return 1 if the denomination is valid, 0 otherwise.
- * @pre The list of valid denominations should be properly defined before calling this function.
+ * @brief Purchase sessions the console has open. The console waits on its one customer instead
+ * of timing them out, so the list is only kept because advanceSession maintains one.
  */
-int isValidDenomination(float moneyInserted)
-{
-    int isValid = 0;  // Flag to track validity, initialized to 0 (invalid by default)
-
-    // Iterate through all valid denominations to find a match
-    for (int i = 0; i < NUM_VALID_DENOMINATIONS; i++)
-    {
-        float currentDenomination = VALID_DENOMINATIONS[i];  // Get the current valid denomination
-
-        // If a match is found, mark as valid
-        if (moneyInserted == currentDenomination)
-        {
-            isValid = 1;  // Set the validity flag to 1
-        }
-    }
-    return isValid;  // Return the validity status (1 or 0)
-}
+static SessionTimeouts consoleTimeouts = {NULL, NULL, SESSION_TIMEOUT_MS};
 
 /**
- * @brief Updates the cash register by incrementing the count of a specific denomination.
- * @param cashRegister The array of CashRegister structures,
- * @param registerSize The number of denominations in the cashRegister array.
- * @param denomination The specific denomination whose count will be incremented.
- * @pre The cashRegister array must be properly initialized before calling this function.
+ * @brief Advances the console customer's purchase session by one event.
+ * @param machine The vending machine the customer buys from.
+ * @param session The customer's purchase session.
+ * @param type The kind of event.
+ * @param amount The denomination inserted, for SESSION_EVENT_INSERT_MONEY.
+ * @param itemIndex The inventory index of the item, for SESSION_EVENT_SELECT_ITEM.
+ * @param quantity The units of the item, for SESSION_EVENT_SELECT_ITEM.
+ * @return The outcome of the event.
  */
-void updateCashRegister(CashRegister cashRegister[], int registerSize, float denomination)
+static SessionResult sendEvent(VendingMachine *machine, PurchaseSession *session,
+                               SessionEventType type, Cents amount, int itemIndex, int quantity)
 {
-    int i;  // Declare loop counter to iterate over cash denominations
-
-    // Iterate through each denomination in the cash register
-    for (i = 0; i < registerSize; i++)
-    {
-        float currentDenomination =
-            cashRegister[i].cashDenomination;  // Get the current denomination value
-
-        // Check if the current denomination matches the one to be updated
-        if (currentDenomination == denomination)
-        {
-            int amountLeft =
-                cashRegister[i].amountLeft;  // Retrieve the current count of the denomination
-
-            amountLeft++;  // Increment the count of this specific denomination
-
-            cashRegister[i].amountLeft = amountLeft;  // Update the register with the new count
-        }
-    }
+    SessionEvent event;
+
+    memset(&event, 0, sizeof(event));
+    event.type = type;
+    event.amount = amount;
+    event.itemIndex = itemIndex;
+    event.quantity = quantity;
+    return advanceSession(machine, &consoleTimeouts, session, &event, 0);
 }
 
 /**
  * @brief Handles the process of inserting money into the vending machine.
- * @param userMoney A pointer to a float that stores the total amount of money the user input
- * @param cashRegister An array of CashRegister structures representing the available cash
- * @param registerSize The number of available denominations in the cash register.
+ * @param session The customer's purchase session, which receives the money.
+ * @param machine The vending machine whose cash register receives the money.
  * @pre The cashRegister should be initialized with valid denominations before calling this
  * function.
  */
-void userMoneyInput(float *userMoney, CashRegister cashRegister[], int registerSize)
+void userMoneyInput(PurchaseSession *session, VendingMachine *machine)
 {
-    float moneyInserted;  // Variable to store the user's inserted amount
+    Cents moneyInserted;                 // Variable to store the user's inserted amount
+    char insertedText[MONEY_TEXT_SIZE];  // Inserted amount formatted for display
+    char totalText[MONEY_TEXT_SIZE];     // Running total formatted for display
 
     // Display available denominations to the user
     printf(
@@ -122,93 +101,80 @@ void userMoneyInput(float *userMoney, CashRegister cashRegister[], int registerS
         "Bills: 20, 50, 100, 200, 500 (PHP)\n"
         "Coins: 1, 5, 10 (PHP), 0.25, 0.10, 0.05 (Cents)\n" SEPARATOR);
 
-    moneyInserted = -1;         // Initialize moneyInserted with a default value of -1
-    while (moneyInserted != 0)  // Loop until the user inputs 0 to stop
+    // Warn up front when the register is too low on cash to break every bill
+    if (isExactChangeOnly(machine))
+    {
+        printf("\nEXACT CHANGE ONLY: the machine may not be able to give change.\n");
+    }
+
+    moneyInserted = -1;  // Initialize moneyInserted with a default value of -1
+    while (moneyInserted != 0 && !isInputClosed())  // Loop until the user inputs 0 to stop
     {
         // Prompt user for cash denomination input
         printf("\nEnter the cash denomination (0 when done): ");
 
-        int scanfResult;                            // Variable to store the result of scanf
-        scanfResult = scanf("%f", &moneyInserted);  // Validate input for numeric value
+        int readResult;                          // Result of reading the amount
+        readResult = readCents(&moneyInserted);  // Validate input for numeric value
 
-        if (scanfResult != 1)
+        if (readResult != 1)
         {
             // Clear invalid input from buffer
-            while (getchar() != '\n');
-            printf("Invalid input! Please enter a numeric value.\n");
+            discardLine();
+            if (!isInputClosed())  // Input that has ended stops the loop without complaint
+            {
+                printf("Invalid input! Please enter a numeric value.\n");
+            }
 
             moneyInserted = -1;  // Reset input to continue the loop
         }
         else if (moneyInserted == 0)
         {
             // User indicates they are done inserting money
-            printf("Total money inserted: %.2f PHP\n" SEPARATOR "\n", *userMoney);
+            printf("Total money inserted: %s PHP\n" SEPARATOR "\n",
+                   formatCents(session->userMoney, totalText));
         }
         else
         {
-            int validDenomination;  // Variable to store the result of the validity check
-            validDenomination =
-                isValidDenomination(moneyInserted);  // Check if the denomination is valid
+            // Add the money to the order and the cash register if it is valid
+            PERF_START(start);  // Timed from here so the wait for input is not counted
+            SessionResult result =
+                sendEvent(machine, session, SESSION_EVENT_INSERT_MONEY, moneyInserted, 0, 0);
 
-            if (validDenomination)
+            if (result.status == ENGINE_OK)
             {
-                *userMoney += moneyInserted;  // Add the valid denomination to the user's total
-                printf("You inserted: %.2f PHP\nTotal so far: %.2f PHP\n", moneyInserted,
-                       *userMoney);
-
-                // Update the cash register with the inserted denomination
-                updateCashRegister(cashRegister, registerSize, moneyInserted);
+                printf("You inserted: %s PHP\nTotal so far: %s PHP\n",
+                       formatCents(moneyInserted, insertedText),
+                       formatCents(session->userMoney, totalText));
             }
             else
             {
                 // Handle invalid denominations
                 printf(INVALID_DENOM_MSG "\n");
             }
+            PERF_STOP(PERF_USER_MONEY_INPUT, start);
         }
     }
 }
 
 /**
- * @brief Allows the user to select items from the vending machine menu.
- * @param items Array of VendingItem structures, where each item represents a product available.
- * @param menuSize The total number of items in the menu.
- * @param selection Pointer to a UserSelection structure.
- * @param userMoney Pointer to a float representing the total amount of money the user has.
- * @param cashRegister The array of CashRegister structures.
- * @param cashRegisterSize The total number of cash denominations in the cashRegister array.
- * @pre The items array must be initialized with the available items, and the `selection`
- * structure should be properly initialized to track selected items.
+ * @brief Allows the user to select items from the vending machine menu until they check out.
+ *
+ * The purchase session applies the silog rules: the first add-on brings the default Egg and Rice
+ * with it, and the order cannot be checked out without an add-on.
+ *
+ * @param machine The vending machine the user is buying from.
+ * @param session The customer's purchase session.
+ * @pre The items array must be initialized with the available items.
  */
-void selectItems(VendingItem items[], int menuSize, UserSelection *selection, float *userMoney,
-                 CashRegister cashRegister[], int cashRegisterSize)
+void selectItems(VendingMachine *machine, PurchaseSession *session)
 {
-    // Add default items (rice and egg) if not already selected
-    if (selection->count == 0)  // If no items have been selected yet
+    // Tell the user about the default items (rice and egg) if none have been selected yet
+    if (session->selection.count == 0)
     {
-        int eggIndex, riceIndex, i;  // Declare variables for item indexes and loop counter
-        eggIndex = -1;               // Initialize to indicate "not found"
-        riceIndex = -1;              // Initialize to indicate "not found"
-
-        // Find the indexes of egg and rice in the menu
-        for (i = 0; i < menuSize; i++)  // Iterate through the items array to find default items
+        if (findItemByName(machine, "Egg") != -1 && findItemByName(machine, "Rice") != -1)
         {
-            if (strcmp(items[i].name, "Egg") == 0)
-            {
-                eggIndex = i;  // Store the index of the "Egg" item
-            }
-            else if (strcmp(items[i].name, "Rice") == 0)
-            {
-                riceIndex = i;  // Store the index of the "Rice" item
-            }
-        }
-
-        // Automatically add 1 egg and 1 rice to the selection
-        if (eggIndex != -1 && riceIndex != -1)  // Ensure both are available
-        {
-            printf("\nYour meal includes 1 Egg and 1 Rice by default.\n");
-            processSelection(items, eggIndex, selection, userMoney, cashRegister, cashRegisterSize);
-            processSelection(items, riceIndex, selection, userMoney, cashRegister,
-                             cashRegisterSize);
+            printf("\nYour meal includes 1 Egg and 1 Rice by default, added with your first "
+                   "item.\n");
         }
         else
         {
@@ -216,42 +182,43 @@ void selectItems(VendingItem items[], int menuSize, UserSelection *selection, fl
         }
     }
 
-    int done;                    // Declare control variable for the loop
-    int additionalItemSelected;  // Declare flag for additional item selection
-    done = 0;                    // Initialize loop control variable
-    additionalItemSelected = 0;  // Initialize flag to track if an additional item was selected
+    int isCheckedOut = 0;  // 1 once the session accepts the order for confirmation
 
-    while (!done)  // Loop until the user finalizes their selection
+    while (!isCheckedOut && !isInputClosed())  // Loop until the user finalizes their selection
     {
-        int selectionIndex, scanfResult;  // Declare variables for user input and validation result
+        int selectionIndex, quantity, readResult;  // User input and validation result
 
-        printf("\nEnter item number to order (1-%d).\nEnter 0 when done: ", menuSize);
-        scanfResult = scanf("%d", &selectionIndex);  // Read user input and store validation result
+        printf("\nEnter item number to order, with x and a quantity for several (e.g. 4 x 20).\n"
+               "Enter 0 when done: ");
+        readResult = readItemOrder(&selectionIndex, &quantity);  // Read the item and quantity
 
-        if (scanfResult != 1)  // Check if the input is not a valid integer
+        if (readResult != 1)  // Check if the input is not a valid order
         {
-            printf("Invalid input! Please enter a number between 0 and %d.\n", menuSize);
-            while (getchar() != '\n');  // Clear invalid input from buffer
+            if (!isInputClosed())  // Input that has ended leaves the order open as it is
+            {
+                printf("Invalid input! Please enter an item number, or 0 when done.\n");
+            }
+            discardLine();  // Clear invalid input from buffer
         }
         else  // If input is a valid integer, proceed
         {
+            // Item numbers need not be contiguous, so look the item up through the index
+            int itemIndex = findItemByNumber(machine, selectionIndex);
+
             if (selectionIndex == 0)
             {
-                if (additionalItemSelected)
-                {
-                    done = 1;  // Exit loop if at least one additional item was selected
-                }
-                else
+                SessionResult result = sendEvent(machine, session, SESSION_EVENT_CHECKOUT, 0, 0, 0);
+
+                isCheckedOut = (result.status == ENGINE_OK);
+                if (!isCheckedOut)
                 {
                     printf(
                         "You must select at least one add-on item before finalizing your order.\n");
                 }
             }
-            else if (selectionIndex >= 1 && selectionIndex <= menuSize)
+            else if (itemIndex != -1)
             {
-                processSelection(items, selectionIndex - 1, selection, userMoney, cashRegister,
-                                 cashRegisterSize);
-                additionalItemSelected = 1;  // Mark that an additional item has been selected
+                processSelection(machine, session, itemIndex, quantity);
             }
             else
             {
@@ -260,198 +227,229 @@ void selectItems(VendingItem items[], int menuSize, UserSelection *selection, fl
         }
     }
 
-    printSelectedItems(selection);  // Print the user's selected items after finalization
+    // Print the user's selected items after finalization
+    if (isCheckedOut)
+    {
+        printSelectedItems(machine, &session->selection);
+    }
+}
+
+/**
+ * @brief Asks the user to choose between two options until they enter 1 or 2.
+ * @param retryPrompt The prompt shown again after an invalid answer.
+ * @return The user's choice, 1 or 2; 2 if input ends first.
+ */
+static int readOneOrTwo(const char *retryPrompt)
+{
+    int userChoice = 0;                     // Variable to store user's choice
+    int readResult = readInt(&userChoice);  // Validate user input
+
+    // Loop until valid input is provided
+    while (!isInputClosed() && (readResult != 1 || (userChoice != 1 && userChoice != 2)))
+    {
+        discardLine();  // Clear invalid input from buffer
+        printf("%s", retryPrompt);
+        readResult = readInt(&userChoice);  // Re-check user input
+    }
+    return (readResult == 1) ? userChoice : 2;
 }
 
 /**
  * @brief Processes the user's selection of a vending item.
- * @param items Array of VendingItem structures representing the available items.
+ *
+ * All the units are reserved in one step. If the money falls short the user may insert more and
+ * the units are tried again, and if too few are in stock the user may take the ones that are.
+ *
+ * @param machine The vending machine the user is buying from.
+ * @param session The customer's purchase session.
  * @param index The index of the selected item in the items array.
- * @param selection Pointer to a UserSelection structure.
- * @param userMoney Pointer to a float representing the total amount of money the user has.
- * @param cashRegister The array of CashRegister structures representing the available cash.
- * @param registerSize The total number of cash denominations in the cashRegister array.
- * @pre The items array must be initialized with the available items, and the selection
- * structure should be properly initialized to track the user's selections and total cost.
+ * @param quantity The number of units the user asked for.
+ * @pre The items array must be initialized with the available items.
  */
-void processSelection(VendingItem items[], int index, UserSelection *selection, float *userMoney,
-                      CashRegister cashRegister[], int registerSize)
+void processSelection(VendingMachine *machine, PurchaseSession *session, int index, int quantity)
 {
-    int hasStock;  // Variable to check if the selected item is in stock
-
-    VendingItem *selectedItem = &items[index];  // Pointer to the selected item
-    hasStock = (selectedItem->stock > 0);       // Check if the item is in stock
+    VendingItem *selectedItem = &machine->items[index];  // Pointer to the selected item
+    char priceText[MONEY_TEXT_SIZE];                     // Amounts formatted for display
+    char totalText[MONEY_TEXT_SIZE];
+    int isDeciding = 1;                                  // 1 until the units are added or dropped
 
-    if (hasStock)  // If the item is in stock
+    while (isDeciding)
     {
-        float totalCost;     // Variable to store the total cost of the current selection
-        int hasEnoughMoney;  // Variable to check if the user has enough money
+        // Reserve the units if they are in stock and the user has enough money for them
+        PERF_START(start);
+        CartResult result =
+            sendEvent(machine, session, SESSION_EVENT_SELECT_ITEM, 0, index, quantity).cart;
 
-        totalCost = selection->totalItemCost +
-                    selectedItem->price;  // Calculate total cost including selected item
-        hasEnoughMoney =
-            (*userMoney >=
-             totalCost);  // Check if the user has enough money to complete the purchase
+        PERF_STOP(PERF_PROCESS_SELECTION, start);  // Stopped before waiting for the user
+        isDeciding = 0;
 
-        if (hasEnoughMoney)  // If the user has enough money
+        if (result.status == ENGINE_OK)  // If the units were added to the selection
         {
-            updateSelectedItems(selection, selectedItem);  // Update the selection with the item
-            selectedItem->stock--;  // Decrease the stock of the selected item
-
             // Display the selection and the current total cost
-            printf("You have selected: %s, which costs %.2f PHP\n", selectedItem->name,
-                   selectedItem->price);
-            printf("Current total cost is %.2f PHP\n", selection->totalItemCost);
+            if (quantity == 1)
+            {
+                printf("You have selected: %s, which costs %s PHP\n", selectedItem->name,
+                       formatCents(result.itemPrice, priceText));
+            }
+            else
+            {
+                printf("You have selected: %d x %s, which costs %s PHP\n", quantity,
+                       selectedItem->name, formatCents(result.itemPrice * quantity, priceText));
+            }
+            printf("Current total cost is %s PHP\n", formatCents(result.totalCost, totalText));
+
+            // Warn as soon as the change for the order can no longer be made
+            if (!canMakeChange(machine, session->userMoney - result.totalCost))
+            {
+                printf("Warning: the machine cannot return %s PHP in change right now.\n",
+                       formatCents(session->userMoney - result.totalCost, totalText));
+            }
         }
-        else  // If the user does not have enough money
+        else if (result.status == ENGINE_INSUFFICIENT_FUNDS)  // If the user lacks the money
         {
-            float moneyRequired;  // Variable to store how much more money is needed
-            int userChoice;       // Variable to store user's choice (insert more money or cancel)
-            int scanfResult;      // Variable to store the result of scanf
-
-            moneyRequired = totalCost - *userMoney;  // Calculate the additional amount needed
-
             // Notify the user about insufficient funds and provide options
-            printf("\nInsufficient funds! You need %.2f PHP more to add '%s'.\n", moneyRequired,
-                   selectedItem->name);
+            printf("\nInsufficient funds! You need %s PHP more to add ",
+                   formatCents(result.shortfall, totalText));
+            if (quantity > 1)
+            {
+                printf("%d x ", quantity);
+            }
+            printf("'%s'.\n", selectedItem->name);
             printf("Would you like to: \n1. Insert more money\n2. Cancel the selection\n");
 
-            userChoice = 0;                          // Initialize user choice
-            scanfResult = scanf("%d", &userChoice);  // Validate user input
+            int userChoice = readOneOrTwo(
+                "Invalid input! Please enter 1 to insert more money or 2 to cancel: ");
 
-            // Loop until valid input is provided
-            while (scanfResult != 1 || (userChoice != 1 && userChoice != 2))
+            if (userChoice == 1)  // If the user chooses to insert more money
             {
-                while (getchar() != '\n');  // Clear invalid input from buffer
-                printf("Invalid input! Please enter 1 to insert more money or 2 to cancel: ");
-                scanfResult = scanf("%d", &userChoice);  // Re-check user input
+                userMoneyInput(session, machine);  // Call function to input more money
+                isDeciding = 1;                    // Try the same units again
             }
-
-            if (userChoice == 1)  // If the user chooses to insert more money
+            else
             {
-                userMoneyInput(userMoney, cashRegister,
-                               registerSize);  // Call function to input more money
+                printf("'%s' was not added to your selection.\n", selectedItem->name);
+            }
+        }
+        else if (result.status == ENGINE_OUT_OF_STOCK && result.available > 0)
+        {
+            // Only some of the units are left: offer those instead
+            printf("\nOnly %d %s left in stock.\n", result.available, selectedItem->name);
+            printf("Would you like to: \n1. Order %d instead\n2. Cancel the selection\n",
+                   result.available);
 
-                // Re-process the selection after money is inserted
-                processSelection(items, index, selection, userMoney, cashRegister, registerSize);
+            if (readOneOrTwo("Invalid input! Please enter 1 to order them or 2 to cancel: ") == 1)
+            {
+                quantity = result.available;
+                isDeciding = 1;
             }
-            else if (userChoice == 2)  // If the user chooses to cancel the selection
+            else
             {
                 printf("'%s' was not added to your selection.\n", selectedItem->name);
             }
         }
-    }
-    else  // If the selected item is out of stock
-    {
-        // Inform the user that the item is out of stock
-        printf("Sorry, %s is currently out of stock!\n", selectedItem->name);
+        else if (result.status == ENGINE_CART_FULL)  // If the cart could not take another line
+        {
+            printf("Sorry, your order cannot hold any more items.\n");
+        }
+        else  // If the selected item is out of stock
+        {
+            // Inform the user that the item is out of stock
+            printf("Sorry, %s is currently out of stock!\n", selectedItem->name);
+        }
     }
 }
 
 /**
- * @brief Updates the user's selection with the selected vending item.
- * @param selection Pointer to a UserSelection structure
- * @param selectedItem Pointer to the VendingItem that the user has selected.
- * @pre The selection structure should be initialized.
+ * @brief Prints the user's selected items along with their quantities and total costs.
+ * @param machine The vending machine whose inventory names and prices the items.
+ * @param selection Pointer to a UserSelection structure that contains the user's selection.
+ * @pre The selection structure should be properly populated.
  */
-void updateSelectedItems(UserSelection *selection, VendingItem *selectedItem)
+void printSelectedItems(const VendingMachine *machine, UserSelection *selection)
 {
-    int existingIndex;   // Declare variable to track if the item is already selected
-    int i;               // Declare index variable for the loop
-    int isItemExisting;  // Declare variable to check if the item exists in the selection
+    int count = selection->count;                  // Number of selected items
+    const CartLine *lines = cartLines(selection);  // Item and quantity of each line
 
-    existingIndex = -1;  // Initialize the index for tracking existing items
+    beginFrame(DISPLAY_CART);
+    addRow("%s", "");
+    addRow("You have selected:");
+    addRow("%-15s | %-10s | %-10s", "Item Name", "Quantity", "Total Cost");
+    addRow(SEPARATOR);
 
-    // Check if the selected item is already in the user's selection
-    for (i = 0; i < selection->count; i++)
+    // Check if there are any selected items
+    if (count > 0)
     {
-        int comparisonResult;  // Variable to store the result of the string comparison
-        comparisonResult =
-            strcmp(selection->selectedItems[i], selectedItem->name);  // Compare item names
-
-        if (comparisonResult == 0)  // If the item is found in the selection
+        // Add the details of each selected item
+        for (int i = 0; i < count; i++)
         {
-            existingIndex = i;  // Store the index of the existing item
-        }
-    }
-
-    isItemExisting = (existingIndex != -1);  // Determine if the item is already in the selection
+            char subtotal[MONEY_TEXT_SIZE];  // Item subtotal
 
-    if (isItemExisting)  // If the item is already selected
-    {
-        // Increment quantity and update the subtotal for the existing item
-        selection->quantities[existingIndex]++;  // Increase quantity
-        selection->subTotals[existingIndex] +=
-            selectedItem->price;  // Update subtotal with item price
+            formatCents(cartLineSubtotal(selection, i), subtotal);
+            addRow("%-15s | %-10d | %-10s", machine->items[lines[i].itemIndex].name,
+                   lines[i].quantity, subtotal);
+        }
     }
-    else  // If the item is not already selected
+    else
     {
-        // Add the new item to the selection at the next available index
-        strcpy(selection->selectedItems[selection->count], selectedItem->name);  // Copy item name
-        selection->quantities[selection->count] = 1;                   // Initialize quantity to 1
-        selection->subTotals[selection->count] = selectedItem->price;  // Set subtotal for the item
-        selection->count++;  // Increment the count of selected items
+        // Inform the user that no items have been selected
+        addRow("No items selected.");
     }
 
-    // Update the total cost of all selected items
-    selection->totalItemCost +=
-        selectedItem->price;  // Add the price of the selected item to the total cost
+    addRow(SEPARATOR);  // Separator for better visual distinction
+    endFrame();
 }
 
 /**
- * @brief Prints the user's selected items along with their quantities and total costs.
- * @param selection Pointer to a UserSelection structure that contains the user's selection.
- * @pre The selection structure should be properly populated.
+ * @brief Shows the bills and coins paid out of the register as change or a refund.
+ * @param machine The vending machine whose cash register paid them out.
+ * @param payout The change or refund paid out.
+ * @return 1 if the exact amount was paid out, 0 if an amount remained undispensed.
  */
-void printSelectedItems(UserSelection *selection)
+static int showPayout(const VendingMachine *machine, const ChangeResult *payout)
 {
-    int count;  // Declare variable to track the count of selected items
-
-    printf("\nYou have selected:\n");
-    printf("%-15s | %-10s | %-10s\n", "Item Name", "Quantity", "Total Cost");
-    printf(SEPARATOR "\n");
+    int isExact;                       // Flag to track whether the exact change was dispensed
+    char amountText[MONEY_TEXT_SIZE];  // Amounts formatted for display
 
-    count = selection->count;  // Initialize the count variable with the number of selected items
+    printf("\nDispensing Change:\n");
 
-    // Check if there are any selected items
-    if (count > 0)
+    // Display each denomination dispensed, if any
+    for (int i = 0; i < machine->registerSize; i++)
     {
-        int i;  // Declare variable for the loop index
-        // Loop through and print details of each selected item
-        for (i = 0; i < count; i++)
+        if (payout->counts[i] > 0)
         {
-            char *itemName;                          // Declare variable to store item name
-            itemName = selection->selectedItems[i];  // Get the item name
-
-            int quantity;                         // Declare variable for item quantity
-            quantity = selection->quantities[i];  // Get the item quantity
-
-            float subtotal;                      // Declare variable for item subtotal
-            subtotal = selection->subTotals[i];  // Get the item subtotal
-
-            // Print item details in table format
-            printf("%-15s | %-10d | %-10.2f\n", itemName, quantity, subtotal);
+            printf("%-15s: %s PHP x %d\n", "Dispensed",
+                   formatCents(machine->cash[i].cashDenomination, amountText), payout->counts[i]);
         }
     }
+    printf(SEPARATOR);
+
+    // Check if exact change was successfully dispensed
+    if (payout->status != ENGINE_OK)
+    {
+        printf("\nUnable to dispense exact change. Remaining amount: %s PHP\n",
+               formatCents(payout->remaining, amountText));
+        isExact = 0;
+    }
     else
     {
-        // Inform the user that no items have been selected
-        printf("No items selected.\n");
+        printf("\nChange successfully dispensed.\n");
+        isExact = 1;
     }
-
-    printf(SEPARATOR "\n");  // Print separator for better visual distinction
+    return isExact;  // Report whether the change was fully dispensed
 }
 
 /**
- * @brief Handles the change calculation and dispensing process.
- * @param cash Array of CashRegister structures representing the available cash denominations.
- * @param userMoney Pointer to a float representing the total amount of money inserted by the user.
- * @param registerSize Size of the cash register array.
- * @param totalItemCost Pointer to a float representing the total cost of the items selected.
- * @param confirmation Pointer to an integer: 1 for confirming the order, 0 for canceling.
+ * @brief Asks the user to confirm or cancel the checked-out order and pays out the change or
+ *        refund.
+ *
+ * A confirmed order whose change the register cannot make is canceled and refunded instead. If
+ * input ends before an answer, the order is left open for the journal to resume.
+ *
+ * @param machine The vending machine whose cash register dispenses the change.
+ * @param session The customer's purchase session, awaiting confirmation.
+ * @return 1 if the order was confirmed and sold, 0 if it was canceled or left open.
  */
-void getChange(CashRegister cash[], float *userMoney, int registerSize, float *totalItemCost,
-               int *confirmation)
+int getChange(VendingMachine *machine, PurchaseSession *session)
 {
     // Prompt the user for order confirmation
     printf("Order Confirmation (1 - Confirm / 0 - Cancel Order): ");
@@ -459,206 +457,139 @@ void getChange(CashRegister cash[], float *userMoney, int registerSize, float *t
     // Declare variable for order confirmation input & user input
     int confirmationInput;
     int scanResult;
-    float userChange;
+    int isConfirmed;
+    Cents totalItemCost = session->selection.totalItemCost;  // Kept for display once sold
+    Cents userMoney = session->userMoney;
+    char amountText[MONEY_TEXT_SIZE];  // Amounts formatted for display
 
-    // Perform the scanf operation first
-    scanResult = scanf("%d", &confirmationInput);
+    // Read the answer first
+    scanResult = readInt(&confirmationInput);
 
     // Loop if the input is not valid
-    while (scanResult != 1)
+    while (scanResult != 1 && !isInputClosed())
     {
         // Clear invalid input from buffer
-        while (getchar() != '\n');
+        discardLine();
         printf("Invalid input! Please enter 1 to confirm or 0 to cancel: ");
 
-        // Perform the scanf operation again inside the loop
-        scanResult = scanf("%d", &confirmationInput);
+        // Read the answer again inside the loop
+        scanResult = readInt(&confirmationInput);
     }
 
-    *confirmation = confirmationInput;  // Assign the validated input to confirmation pointer
+    PERF_START(start);  // Timed from here so the wait for input is not counted
+    isConfirmed = (scanResult == 1 && confirmationInput == 1);
 
-    userChange = 0.0f;  // Declare variable to hold the calculated change
-    // Order confirmation condition
-    if (*confirmation == 1)  // Order confirmed
-    {
-        userChange = *userMoney - *totalItemCost;  // Calculate change
-        // Print confirmation details
-        printf("\n%-15s: %.2f PHP", "Final Total", *totalItemCost);
-        printf("\n%-15s: %.2f PHP", "Money Input", *userMoney);
-        printf("\n%-15s: %.2f PHP", "Change Total", userChange);
-    }
-    else  // Order canceled
+    // The session refuses the order rather than take the money without being able to give change
+    if (isConfirmed &&
+        sendEvent(machine, session, SESSION_EVENT_CONFIRM, 0, 0, 0).status != ENGINE_OK)
     {
-        userChange = *userMoney;  // Return all money
-        printf("\n%-15s: %.2f PHP\n", "Money Refunded", userChange);
+        printf("\nSorry, the machine cannot return %s PHP in change right now.\n",
+               formatCents(userMoney - totalItemCost, amountText));
+        printf("Your order has been canceled and your money will be refunded.\n");
+        isConfirmed = 0;
     }
 
-    printf("\n" SEPARATOR);  // Print separator
-
-    // Process change dispensing only if there is change to give
-    if (userChange > 0)
+    if (isConfirmed)  // Order confirmed
     {
-        dispenseChange(cash, registerSize, userChange);  // Dispense change
-    }
-    else
-    {
-        printf("\nNo change to dispense.\n");  // Inform if no change is needed
-    }
-}
-
-/**
- * @brief Dispenses the change using the available cash register denominations.
- * @param cash Array of CashRegister structure.
- * @param registerSize The number of denominations available in the cash register array.
- * @param amountToDispense The total amount of change that needs to be returned to the user.
- * @pre The amountToDispense should be a positive value representing the change to be returned.
- */
-void dispenseChange(CashRegister cash[], int registerSize, float amountToDispense)
-{
-    int i = 0;  // Index for iterating over cash denominations
-
-    printf("\nDispensing Change:\n");
+        // Print confirmation details
+        printf("\n%-15s: %s PHP", "Final Total", formatCents(totalItemCost, amountText));
+        printf("\n%-15s: %s PHP", "Money Input", formatCents(userMoney, amountText));
+        printf("\n%-15s: %s PHP", "Change Total",
+               formatCents(userMoney - totalItemCost, amountText));
+        printf("\n" SEPARATOR);  // Print separator
 
-    // Loop over the available denominations
-    while (i < registerSize && amountToDispense >= 0.05f)
+        if (userMoney > totalItemCost)
+        {
+            dispenseChange(machine, session);
+        }
+        else
+        {
+            sendEvent(machine, session, SESSION_EVENT_DISPENSED, 0, 0, 0);
+            printf("\nNo change to dispense.\n");  // Inform if no change is needed
+        }
+    }
+    else if (scanResult == 1)  // Order canceled
     {
-        int dispensedCount = 0;  // Counter for the number of times a denomination is dispensed
+        ChangeResult refund = sendEvent(machine, session, SESSION_EVENT_CANCEL, 0, 0, 0).payout;
 
-        // Dispense current denomination while possible
-        while (amountToDispense >= cash[i].cashDenomination && cash[i].amountLeft > 0)
+        printf("\n%-15s: %s PHP\n", "Money Refunded", formatCents(userMoney, amountText));
+        printf("\n" SEPARATOR);  // Print separator
+        if (userMoney > 0)
         {
-            // Deduct the denomination from the amount to dispense
-            amountToDispense -= cash[i].cashDenomination;
-            cash[i].amountLeft--;  // Reduce the available stock of this denomination
-            dispensedCount++;      // Increment the count of dispensed notes/coins
-
-            // Round the amount to dispense to two decimal places.
-            amountToDispense = roundf(amountToDispense * 100) / 100.0f;
+            showPayout(machine, &refund);
         }
-
-        // Display the denomination dispensed, if any
-        if (dispensedCount > 0)
+        else
         {
-            printf("%-15s: %.2f PHP x %d\n", "Dispensed", cash[i].cashDenomination, dispensedCount);
+            printf("\nNo change to dispense.\n");
         }
-
-        // Move to the next denomination
-        i++;
     }
-    printf(SEPARATOR);
+    PERF_STOP(PERF_GET_CHANGE, start);
+    return isConfirmed;
+}
 
-    // Check if exact change was successfully dispensed
-    if (amountToDispense >
-        0.01f)  // If the remaining amount is above 0.01 PHP, consider it an error
-    {
-        printf("\nUnable to dispense exact change. Remaining amount: %.2f PHP\n", amountToDispense);
-    }
-    else
-    {
-        printf("\nChange successfully dispensed.\n");
-    }
+/**
+ * @brief Dispenses the change reserved for a confirmed order, completing the sale.
+ * @param machine The vending machine whose cash register dispenses the change.
+ * @param session The customer's purchase session, dispensing.
+ * @return 1 if the exact change was dispensed, 0 if an amount remained undispensed.
+ */
+int dispenseChange(VendingMachine *machine, PurchaseSession *session)
+{
+    PERF_START(start);
+    ChangeResult change = sendEvent(machine, session, SESSION_EVENT_DISPENSED, 0, 0, 0).payout;
+    int isExact = showPayout(machine, &change);
+
+    PERF_STOP(PERF_DISPENSE_CHANGE, start);
+    return isExact;
 }
 
 /**
  * @brief Displays the order summary and instructs the user to retrieve the silog.
+ * @param machine The vending machine whose inventory names and prices the items.
  * @param selection Pointer to a UserSelection structure containing the details of the
  *                  user's selected items, quantities, and subtotals.
  * @pre The selection structure must be populated with valid user selections, including
  *      item names, quantities, and subtotals.
  */
-void getSilog(UserSelection *selection)
+void getSilog(const VendingMachine *machine, UserSelection *selection)
 {
     // Declare variable for the loop index
     int i;
+    const CartLine *lines = cartLines(selection);  // Item and quantity of each line
+    char amountText[MONEY_TEXT_SIZE];  // Amounts formatted for display
 
-    // Display the order summary header
-    printf("\n\nOrder Summary:\n");
-    printf("%-15s | %-10s | %-10s\n", "Item Name", "Quantity", "Total Cost");
-    printf(SEPARATOR "\n");
+    // Order summary header
+    beginFrame(DISPLAY_CART);
+    addRow("%s", "");
+    addRow("%s", "");
+    addRow("Order Summary:");
+    addRow("%-15s | %-10s | %-10s", "Item Name", "Quantity", "Total Cost");
+    addRow(SEPARATOR);
 
     // Check if any items have been selected
     if (selection->count > 0)
     {
-        // Loop through selected items to display their details
+        // Add the details of each selected item: name, quantity, and subtotal
         for (i = 0; i < selection->count; i++)
         {
-            // Display the item details: name, quantity, and subtotal
-            printf("%-15s | %-10d | %-10.2f\n", selection->selectedItems[i],
-                   selection->quantities[i], selection->subTotals[i]);
+            addRow("%-15s | %-10d | %-10s", machine->items[lines[i].itemIndex].name,
+                   lines[i].quantity,
+                   formatCents(cartLineSubtotal(selection, i), amountText));
         }
 
-        // Print the separator and the total order cost
-        printf(SEPARATOR "\n");
-        printf("Total Order Cost: %.2f PHP\n", selection->totalItemCost);
+        // Separator and the total order cost
+        addRow(SEPARATOR);
+        addRow("Total Order Cost: %s PHP", formatCents(selection->totalItemCost, amountText));
     }
     else
     {
         // Notify user if no items have been selected
-        printf("No items selected.\n");
+        addRow("No items selected.");
     }
 
-    printf(SEPARATOR "\n");
+    addRow(SEPARATOR);
+    endFrame();
 
     // Print message to retrieve the silog from the tray bin
     printf("Get silog from tray bin.\n");
 }
-
-/**
- * @brief Resets the user's order and related data when the order is canceled.
- * @param userSelection Pointer to a UserSelection structure containing the user's current order.
- * @param insertedMoney Pointer to a float representing the total amount of money inserted.
- * @param availableItems Array of VendingItem structures representing the available items.
- * @param menuSize The number of items in the vending machine (size of the `availableItems` array).
- * @pre The userSelection structure must contain valid data, including selected items, quantities,
- *      and total cost.
- */
-void resetOrderAfterCancel(UserSelection *userSelection, float *insertedMoney,
-                           VendingItem availableItems[], int menuSize)
-{
-    // Declare variables for loop indices
-    int i;
-    int j;
-
-    // Loop through the user's selection to return stock for each item
-    for (i = 0; i < userSelection->count; i++)
-    {
-        // Search for the corresponding item in the available items menu
-        for (j = 0; j < menuSize; j++)
-        {
-            int comparisonResult;
-            // Compare the item name from the user's selection with the available items
-            comparisonResult = strcmp(availableItems[j].name, userSelection->selectedItems[i]);
-
-            // If the item names match, return stock to the available items
-            if (comparisonResult == 0)
-            {
-                availableItems[j].stock += userSelection->quantities[i];  // Restore the stock
-            }
-        }
-    }
-
-    // Reset the user's order details
-    userSelection->count = 0;             // Reset the number of selected items
-    userSelection->totalItemCost = 0.0f;  // Reset the total cost of the order
-
-    // Reset the inserted money
-    *insertedMoney = 0.0f;  // Set the inserted money to zero
-}
-
-/**
- * @brief Resets the user's order details after confirming the transaction.
- * @param userSelection Pointer to a UserSelection structure containing the user's selected items.
- * @param insertedMoney Pointer to a float representing the total amount of money inserted.
- * @pre The userSelection structure must contain valid data, including selected items, quantities,
- *      and total cost.
- */
-void resetOrderAfterConfirm(UserSelection *userSelection, float *insertedMoney)
-{
-    // Reset the user's order details after confirming the transaction
-    userSelection->count = 0;             // Clear the count of selected items
-    userSelection->totalItemCost = 0.0f;  // Reset the total cost to zero
-    *insertedMoney = 0.0f;                // Set the inserted money to zero
-
-    // Print the message instructing the user to retrieve their silog
-    printf("Get Natsilog from Traybin\n");
-}
@@ -0,0 +1,453 @@
+#define _POSIX_C_SOURCE 200809L  // Expose clock_gettime and getline
+
+#include "workload_driver.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "constants.h"
+#include "data_structures.h"
+#include "engine.h"
+#include "money.h"
+#include "purchase_session.h"
+
+/**
+ * @brief A single scripted action inside a customer session.
+ */
+typedef struct
+{
+    char type;    // 'I' insert money, 'S' select item, 'C' confirm order, 'X' cancel order
+    Cents value;  // Denomination in centavos for 'I', item number for 'S', unused otherwise
+} ScriptOp;
+
+/**
+ * @brief A parsed workload script: every session's actions stored back to back.
+ */
+typedef struct
+{
+    ScriptOp *ops;       // All actions of all sessions in file order
+    int opCount;         // Number of actions stored in ops
+    int *sessionStarts;  // Index into ops where each session begins
+    int sessionCount;    // Number of sessions in the script
+} WorkloadScript;
+
+/**
+ * @brief Counters collected while replaying a workload script.
+ */
+typedef struct
+{
+    long sessions;           // Sessions executed
+    long confirmed;          // Orders confirmed and paid for
+    long cancelled;          // Orders canceled (explicitly or by an incomplete session)
+    long rejectedMoney;      // Insertions rejected as invalid denominations
+    long outOfStock;         // Selections rejected because the item was out of stock
+    long insufficientFunds;  // Selections rejected because the money inserted was not enough
+    long changeFailures;     // Change or refunds that could not be dispensed exactly
+    long changeRefused;      // Confirmations refunded because the change could not be made
+} DriverStats;
+
+/**
+ * @brief Returns the current monotonic time in nanoseconds.
+ * @return Nanoseconds elapsed since an arbitrary fixed point.
+ */
+static long long currentTimeNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long) now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * @brief Compares two latency samples for qsort.
+ */
+static int compareLatency(const void *a, const void *b)
+{
+    long long left = *(const long long *) a;
+    long long right = *(const long long *) b;
+    return (left > right) - (left < right);
+}
+
+/**
+ * @brief Appends one action to the script, growing the action array as needed.
+ * @param script The script being built.
+ * @param capacity Pointer to the current capacity of the action array.
+ * @param op The action to append.
+ * @return 1 on success, 0 if memory could not be allocated.
+ */
+static int appendOp(WorkloadScript *script, int *capacity, ScriptOp op)
+{
+    int isAppended = 1;
+
+    if (script->opCount == *capacity)
+    {
+        int newCapacity = (*capacity == 0) ? 256 : *capacity * 2;
+        ScriptOp *grown = realloc(script->ops, newCapacity * sizeof(ScriptOp));
+
+        isAppended = (grown != NULL);
+        if (isAppended)
+        {
+            script->ops = grown;
+            *capacity = newCapacity;
+        }
+    }
+    if (isAppended)
+    {
+        script->ops[script->opCount++] = op;
+    }
+    return isAppended;
+}
+
+/**
+ * @brief Parses a workload script file into memory.
+ *
+ * One session per line. Tokens are separated by whitespace: I<amount> inserts money, S<number>
+ * selects an item, C confirms and X cancels the order. Text after '#' is a comment.
+ *
+ * @param path Path to the script file.
+ * @param script The script to fill in; release it with freeScript.
+ * @return 1 on success, 0 if the file could not be read or contains an invalid token.
+ */
+static int loadScript(const char *path, WorkloadScript *script)
+{
+    int opCapacity = 0;
+    int sessionCapacity = 0;
+    int lineNumber = 0;
+    char *line = NULL;
+    size_t lineCapacity = 0;
+
+    // Start empty so the caller can always release the script, even if the file cannot be read
+    script->ops = NULL;
+    script->opCount = 0;
+    script->sessionStarts = NULL;
+    script->sessionCount = 0;
+
+    FILE *file = fopen(path, "r");
+    int isLoaded = (file != NULL);
+    if (!isLoaded)
+    {
+        perror("Error opening workload script");
+    }
+
+    while (isLoaded && getline(&line, &lineCapacity, file) != -1)
+    {
+        lineNumber++;
+
+        char *comment = strchr(line, '#');
+        if (comment != NULL)
+        {
+            *comment = '\0';  // Ignore everything after a comment marker
+        }
+
+        int sessionStart = script->opCount;
+        char *token = strtok(line, " \t\r\n");
+        while (isLoaded && token != NULL)
+        {
+            ScriptOp op;
+            char *end;
+            op.type = token[0];
+            op.value = 0;
+
+            if (op.type == 'I')
+            {
+                isLoaded = parseCents(token + 1, &op.value);
+            }
+            else if (op.type == 'S')
+            {
+                op.value = strtol(token + 1, &end, 10);
+                isLoaded = (end != token + 1 && *end == '\0');
+            }
+            else
+            {
+                isLoaded = ((op.type == 'C' || op.type == 'X') && token[1] == '\0');
+            }
+
+            if (!isLoaded)
+            {
+                fprintf(stderr, "%s:%d: invalid token '%s'\n", path, lineNumber, token);
+            }
+            else if (!appendOp(script, &opCapacity, op))
+            {
+                isLoaded = 0;
+            }
+            token = strtok(NULL, " \t\r\n");
+        }
+
+        // Record the session if the line contained at least one action
+        if (isLoaded && script->opCount > sessionStart)
+        {
+            if (script->sessionCount == sessionCapacity)
+            {
+                sessionCapacity = (sessionCapacity == 0) ? 64 : sessionCapacity * 2;
+                int *grown = realloc(script->sessionStarts, sessionCapacity * sizeof(int));
+                if (grown == NULL)
+                {
+                    isLoaded = 0;
+                }
+                else
+                {
+                    script->sessionStarts = grown;
+                }
+            }
+            if (isLoaded)
+            {
+                script->sessionStarts[script->sessionCount++] = sessionStart;
+            }
+        }
+    }
+
+    free(line);
+    if (file != NULL)
+    {
+        fclose(file);
+    }
+    return isLoaded;
+}
+
+/**
+ * @brief Releases the memory held by a parsed script.
+ * @param script The script to release.
+ */
+static void freeScript(WorkloadScript *script)
+{
+    free(script->ops);
+    free(script->sessionStarts);
+}
+
+/**
+ * @brief Advances the scripted customer's purchase session by one event.
+ * @param machine The vending machine the customer buys from.
+ * @param timeouts The sessions with open orders; never expired, as scripts do not wait.
+ * @param session The customer's purchase session.
+ * @param type The kind of event.
+ * @param value The denomination for SESSION_EVENT_INSERT_MONEY or the inventory index for
+ *              SESSION_EVENT_SELECT_ITEM.
+ * @return The outcome of the event.
+ */
+static SessionResult sendEvent(VendingMachine *machine, SessionTimeouts *timeouts,
+                               PurchaseSession *session, SessionEventType type, Cents value)
+{
+    SessionEvent event;
+
+    memset(&event, 0, sizeof(event));
+    event.type = type;
+    event.amount = (type == SESSION_EVENT_INSERT_MONEY) ? value : 0;
+    event.itemIndex = (type == SESSION_EVENT_SELECT_ITEM) ? (int) value : 0;
+    event.quantity = 1;
+    return advanceSession(machine, timeouts, session, &event, 0);
+}
+
+/**
+ * @brief Cancels the current order, if one is open: refunds the money inserted and returns the
+ *        reserved stock.
+ */
+static void cancelSession(VendingMachine *machine, SessionTimeouts *timeouts,
+                          PurchaseSession *session, DriverStats *stats)
+{
+    SessionResult result = sendEvent(machine, timeouts, session, SESSION_EVENT_CANCEL, 0);
+
+    if (result.status == ENGINE_OK && result.payout.status != ENGINE_OK)
+    {
+        stats->changeFailures++;
+    }
+    stats->cancelled++;
+}
+
+/**
+ * @brief Checks out and confirms the current order, then dispenses its change.
+ * @return 1 if the order was sold, 0 if it must be canceled instead.
+ */
+static int confirmSession(VendingMachine *machine, SessionTimeouts *timeouts,
+                          PurchaseSession *session, DriverStats *stats)
+{
+    int isSold = 0;
+
+    // An order without an add-on cannot be checked out
+    if (sendEvent(machine, timeouts, session, SESSION_EVENT_CHECKOUT, 0).status == ENGINE_OK)
+    {
+        isSold = (sendEvent(machine, timeouts, session, SESSION_EVENT_CONFIRM, 0).status ==
+                  ENGINE_OK);
+        if (isSold)
+        {
+            sendEvent(machine, timeouts, session, SESSION_EVENT_DISPENSED, 0);
+            stats->confirmed++;
+        }
+        else
+        {
+            stats->changeRefused++;  // Refused rather than short-change the customer
+        }
+    }
+    return isSold;
+}
+
+/**
+ * @brief Replays one scripted session as events of a purchase session.
+ *
+ * The session applies the same rules as at the console: money goes into the register as it is
+ * inserted, the first add-on brings the default Egg and Rice with it, and an order needs an add-on
+ * and exact change before it can be confirmed. A session that ends without a decision, or whose
+ * confirmation is refused, is canceled.
+ */
+static void runSession(const ScriptOp ops[], int opCount, VendingMachine *machine,
+                       SessionTimeouts *timeouts, PurchaseSession *session, DriverStats *stats)
+{
+    int isDecided = 0;
+
+    for (int i = 0; i < opCount && !isDecided; i++)
+    {
+        const ScriptOp *op = &ops[i];
+
+        if (op->type == 'I')
+        {
+            EngineStatus status =
+                sendEvent(machine, timeouts, session, SESSION_EVENT_INSERT_MONEY, op->value).status;
+
+            if (status != ENGINE_OK)
+            {
+                stats->rejectedMoney++;
+            }
+        }
+        else if (op->type == 'S')
+        {
+            int index = findItemByNumber(machine, (int) op->value);
+            EngineStatus status =
+                sendEvent(machine, timeouts, session, SESSION_EVENT_SELECT_ITEM, index).status;
+
+            if (status == ENGINE_OUT_OF_STOCK)
+            {
+                stats->outOfStock++;
+            }
+            else if (status == ENGINE_INSUFFICIENT_FUNDS)
+            {
+                stats->insufficientFunds++;
+            }
+        }
+        else
+        {
+            // A confirmation, or an explicit cancel; a refused confirmation cancels too
+            isDecided = 1;
+            if (op->type != 'C' || !confirmSession(machine, timeouts, session, stats))
+            {
+                cancelSession(machine, timeouts, session, stats);
+            }
+        }
+    }
+
+    if (!isDecided)
+    {
+        cancelSession(machine, timeouts, session, stats);
+    }
+    stats->sessions++;
+}
+
+/**
+ * @brief Replays a file of scripted customer sessions and reports throughput and latency.
+ *
+ * Each pass starts from a copy of the given machine state, so repeated passes measure the same
+ * workload. The sessions run through the same purchase session as the console and the socket
+ * server, but without their I/O, so only the purchase flow is timed.
+ *
+ * @param scriptPath Path to the workload script.
+ * @param repeatCount Number of times the whole script is replayed.
+ * @param machine The initial state of the machine; it is not modified.
+ * @return 0 on success, 1 if the script could not be loaded.
+ * @pre repeatCount must be positive.
+ */
+int runWorkloadDriver(const char *scriptPath, int repeatCount, const VendingMachine *machine)
+{
+    int menuSize = machine->menuSize;
+    int registerSize = machine->registerSize;
+
+    WorkloadScript script;
+    long long *latencies = NULL;
+    VendingItem *workItems = NULL;
+    CashRegister *workCash = NULL;
+    int exitCode = 0;
+
+    if (!loadScript(scriptPath, &script))
+    {
+        exitCode = 1;
+    }
+    else
+    {
+        long totalSessions = (long) script.sessionCount * repeatCount;
+
+        latencies = malloc((totalSessions > 0 ? totalSessions : 1) * sizeof(long long));
+        workItems = malloc(menuSize * sizeof(VendingItem));
+        workCash = malloc(registerSize * sizeof(CashRegister));
+        if (latencies == NULL || workItems == NULL || workCash == NULL)
+        {
+            fprintf(stderr, "Not enough memory to replay %ld sessions.\n", totalSessions);
+            exitCode = 1;
+        }
+    }
+
+    if (exitCode == 0)
+    {
+        DriverStats stats = {0};
+        VendingMachine work = *machine;  // Shares the change tables built for its denominations
+        work.items = workItems;
+        work.cash = workCash;
+        work.journal = NULL;       // Simulated sessions never reach the machine's journal
+        work.sales = NULL;         // Nor its sales totals
+        work.transactions = NULL;  // Nor its log of recent transactions
+        long sample = 0;
+
+        long long startTime = currentTimeNs();
+        for (int pass = 0; pass < repeatCount; pass++)
+        {
+            PurchaseSession session;
+            SessionTimeouts timeouts;
+
+            startPurchaseSession(&session, NULL, 0);
+            initSessionTimeouts(&timeouts, SESSION_TIMEOUT_MS);
+
+            memcpy(workItems, machine->items, menuSize * sizeof(VendingItem));
+            memcpy(workCash, machine->cash, registerSize * sizeof(CashRegister));
+            noteRegisterChanged(&work);
+
+            for (int s = 0; s < script.sessionCount; s++)
+            {
+                int first = script.sessionStarts[s];
+                int last =
+                    (s + 1 < script.sessionCount) ? script.sessionStarts[s + 1] : script.opCount;
+
+                long long sessionStart = currentTimeNs();
+                runSession(&script.ops[first], last - first, &work, &timeouts, &session, &stats);
+                latencies[sample++] = currentTimeNs() - sessionStart;
+            }
+        }
+        long long elapsed = currentTimeNs() - startTime;
+
+        // Report throughput and the per-session latency distribution
+        printf(SEPARATOR "\nWorkload Driver Report: %s (x%d)\n" SEPARATOR "\n", scriptPath,
+               repeatCount);
+        printf("%-22s: %ld\n", "Sessions", stats.sessions);
+        printf("%-22s: %ld\n", "Confirmed", stats.confirmed);
+        printf("%-22s: %ld\n", "Canceled", stats.cancelled);
+        printf("%-22s: %ld\n", "Invalid Money", stats.rejectedMoney);
+        printf("%-22s: %ld\n", "Out of Stock", stats.outOfStock);
+        printf("%-22s: %ld\n", "Insufficient Funds", stats.insufficientFunds);
+        printf("%-22s: %ld\n", "Change Failures", stats.changeFailures);
+        printf("%-22s: %ld\n", "Change Refused", stats.changeRefused);
+        printf("%-22s: %.3f s\n", "Elapsed", elapsed / 1e9);
+
+        if (sample > 0)
+        {
+            qsort(latencies, sample, sizeof(long long), compareLatency);
+            printf("%-22s: %.0f\n", "Transactions/sec", stats.sessions / (elapsed / 1e9));
+            printf("%-22s: %.0f ns\n", "Latency Mean", (double) elapsed / sample);
+            printf("%-22s: %lld ns\n", "Latency p50", latencies[sample / 2]);
+            printf("%-22s: %lld ns\n", "Latency p99", latencies[(long) (sample * 0.99)]);
+            printf("%-22s: %lld ns\n", "Latency Max", latencies[sample - 1]);
+        }
+        printf(SEPARATOR "\n");
+    }
+
+    free(latencies);
+    free(workItems);
+    free(workCash);
+    freeScript(&script);
+    return exitCode;
+}